@@ -1,9 +1,20 @@
 ////////////////////////////////////////////////////////////////////////////////
 /*
- sts_lua.h - v0.01 - public domain
+ sts_lua.h - v0.08 - public domain
  written 2016 by Sebastian Steinhauer
 
   VERSION HISTORY
+    0.08 (2026-10-19) the profiler timer only signals the thread running the profiled state (a thread CPU timer on Linux)
+                      profiled functions are told apart by the lines where their definition starts and ends
+                      the setup of worker states runs in protected mode, errors are reported for every job of the worker
+                      jobs are unpacked and their function is looked up in protected mode, errors are answered instead of aborting
+                      the allocator keeps the old block if a shrink can't get a new one (Lua requires shrinks to succeed)
+    0.07 (2026-10-19) added worker states on threads with message passing (sts_lua_startworkers, sts_lua_post, sts_lua_receive)
+    0.06 (2026-10-19) added the sampling profiler (sts_lua_startprofiler, sts_lua_getprofile, sts_lua_writecollapsed)
+    0.05 (2026-10-19) added sts_lua_newstate (size class allocator with thread local caches, memory statistics and limit)
+    0.04 (2026-10-19) added struct marshaling with field descriptors (sts_lua_initstruct, sts_lua_pushstruct, sts_lua_tostruct...)
+    0.03 (2026-10-19) sts_lua_createmeta returns a reference to the metatable, added the *ref constructors and sts_lua_check/testobject
+    0.02 (2026-10-19) added object pools (sts_lua_createpool, sts_lua_newpooled, sts_lua_getpoolstats)
     0.01 (2016-05-20) initial version
 
   LICENSE
@@ -12,12 +23,45 @@
   ABOUT
     Some simple Lua helper functions. I've chosen to collect all this functions here, as I repeated them over and over again in various projects :)
 
+  CONFIGURATION
+    STS_LUA_NO_THREADS    leave out the worker states (no pthread / Win32 threads needed)
+
 */
 ////////////////////////////////////////////////////////////////////////////////
 #ifndef __INCLUDED__STS_LUA_H__
 #define __INCLUDED__STS_LUA_H__
 
 
+#include <stddef.h>
+#include <stdio.h>
+
+
+#ifndef STS_LUA_POOL_SIZE
+// blocks up to this size (in bytes, a multiple of 16) are rounded up to a size class and cached per thread
+#define STS_LUA_POOL_SIZE     256
+#endif // STS_LUA_POOL_SIZE
+
+#ifndef STS_LUA_POOL_CACHE
+// the maximum amount of free blocks cached per size class and thread, additional blocks are given back to free()
+#define STS_LUA_POOL_CACHE    1024
+#endif // STS_LUA_POOL_CACHE
+
+#ifndef STS_LUA_PROFILER_DEPTH
+// the maximum amount of stack frames recorded per sample (deeper frames are cut off)
+#define STS_LUA_PROFILER_DEPTH      32
+#endif // STS_LUA_PROFILER_DEPTH
+
+#ifndef STS_LUA_PROFILER_FUNCTIONS
+// the maximum amount of different functions the profiler can tell apart
+#define STS_LUA_PROFILER_FUNCTIONS  1024
+#endif // STS_LUA_PROFILER_FUNCTIONS
+
+#ifndef STS_LUA_PROFILER_STACKS
+// the amount of samples whose stacks are kept for sts_lua_writecollapsed
+#define STS_LUA_PROFILER_STACKS     8192
+#endif // STS_LUA_PROFILER_STACKS
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //  additional luaL_check* functions
@@ -50,10 +94,269 @@ void sts_lua_setconsts(lua_State *L, const sts_lua_constant_t *c);
 
 // Creates a new metatable with the given name and registers the given array of functions to it.
 // All functions beginning with "__" will be added as metafunctions.
-void sts_lua_createmeta(lua_State *L, const char *tname, const luaL_Reg *f);
+// Returns a reference (in the registry of L) to the metatable, which can be used with the *ref / *object functions
+// below. They just index the registry with an integer instead of hashing and looking up the name.
+int sts_lua_createmeta(lua_State *L, const char *tname, const luaL_Reg *f);
 
 // Creates a new "object" with the given size and metatable.
 void *sts_lua_newobject(lua_State *L, const char *tname, size_t size);
+void *sts_lua_newobjectref(lua_State *L, int mref, size_t size);
+
+// Returns the object at arg if it has the metatable mref, raises an error otherwise (like luaL_checkudata).
+void *sts_lua_checkobject(lua_State *L, int arg, int mref);
+
+// Returns the object at arg if it has the metatable mref, NULL otherwise (like luaL_testudata).
+void *sts_lua_testobject(lua_State *L, int arg, int mref);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Object pools
+//
+//  A pool recycles the userdata of one metatable instead of letting the GC free it.
+//  Its "__gc" calls the original "__gc" of the metatable (if any) and puts the object
+//  on a free list, sts_lua_newpooled() takes it from there again. Short-lived objects
+//  (vectors, handles...) then cost no allocation at all.
+//  Recycled objects are NOT cleared, initialize them like a fresh sts_lua_newobject().
+//
+typedef struct {
+  lua_Integer hits;       // sts_lua_newpooled() calls served from the pool
+  lua_Integer misses;     // sts_lua_newpooled() calls which had to allocate
+  lua_Integer recycled;   // collected objects put on the free list
+  lua_Integer dropped;    // collected objects freed, because the pool was full
+  int         pooled;     // objects currently on the free list
+} sts_lua_poolstats_t;
+
+// Adds a pool to the metatable tname (call it after sts_lua_createmeta), which keeps up to max free objects.
+void sts_lua_createpool(lua_State *L, const char *tname, int max);
+
+// Same as sts_lua_newobject() but reuses a collected object of the pool if possible.
+void *sts_lua_newpooled(lua_State *L, const char *tname, size_t size);
+void *sts_lua_newpooledref(lua_State *L, int mref, size_t size);
+
+// Gets the statistics of the pool of tname.
+void sts_lua_getpoolstats(lua_State *L, const char *tname, sts_lua_poolstats_t *stats);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Struct marshaling
+//
+//  A struct is described by an array of fields, terminated by a field with a NULL name:
+//    static const sts_lua_field_t entity_fields[] = {
+//      STS_LUA_FIELD(entity_t, id, STS_LUA_FIELD_INT),
+//      STS_LUA_FIELD(entity_t, x, STS_LUA_FIELD_FLOAT),
+//      STS_LUA_FIELD(entity_t, name, STS_LUA_FIELD_CHARS),
+//      { NULL }
+//    };
+//  sts_lua_initstruct() keeps the field names as strings in the registry, so marshaling
+//  sets / gets every field with lua_rawset / lua_rawget without hashing the names again.
+//
+enum {
+  STS_LUA_FIELD_CHAR,       // signed char
+  STS_LUA_FIELD_UCHAR,      // unsigned char
+  STS_LUA_FIELD_SHORT,      // short
+  STS_LUA_FIELD_USHORT,     // unsigned short
+  STS_LUA_FIELD_INT,        // int
+  STS_LUA_FIELD_UINT,       // unsigned int
+  STS_LUA_FIELD_INTEGER,    // lua_Integer
+  STS_LUA_FIELD_FLOAT,      // float
+  STS_LUA_FIELD_DOUBLE,     // double
+  STS_LUA_FIELD_BOOL,       // int used as boolean
+  STS_LUA_FIELD_STRING,     // const char*, only pushed to Lua (skipped by sts_lua_tostruct)
+  STS_LUA_FIELD_CHARS       // char array, strings are truncated to fit and always zero terminated
+};
+
+typedef struct {
+  const char  *name;
+  int         type;     // one of STS_LUA_FIELD_*
+  size_t      offset;   // offsetof() the field
+  size_t      size;     // sizeof() the field
+} sts_lua_field_t;
+
+#define STS_LUA_FIELD(stype, field, type)   { #field, type, offsetof(stype, field), sizeof(((stype*)0)->field) }
+
+typedef struct {
+  const sts_lua_field_t *fields;
+  int                   count;    // amount of fields
+  int                   keys;     // registry reference to the array of field names
+} sts_lua_struct_t;
+
+// Prepares the struct s for the given fields. The fields array has to stay valid.
+void sts_lua_initstruct(lua_State *L, sts_lua_struct_t *s, const sts_lua_field_t *fields);
+
+// Sets all fields of data in the table at idx.
+void sts_lua_setstruct(lua_State *L, int idx, const sts_lua_struct_t *s, const void *data);
+
+// Pushes a new table with all fields of data.
+void sts_lua_pushstruct(lua_State *L, const sts_lua_struct_t *s, const void *data);
+
+// Pushes a new array with a table for each of the count structs at data, which are stride bytes apart.
+void sts_lua_pushstructs(lua_State *L, const sts_lua_struct_t *s, const void *data, int count, size_t stride);
+
+// Reads the fields of the table at idx into data. Missing (nil) fields are left untouched.
+// Raises an error if a field has the wrong type.
+void sts_lua_tostruct(lua_State *L, int idx, const sts_lua_struct_t *s, void *data);
+
+// Reads up to max tables of the array at idx into data (stride bytes apart). Returns the amount of read structs.
+int sts_lua_tostructs(lua_State *L, int idx, const sts_lua_struct_t *s, void *data, int max, size_t stride);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  State creation / memory accounting
+//
+//  sts_lua_newstate() creates a state with its own allocator. Small blocks (tables, strings,
+//  closures...) are rounded up to a size class and recycled through a free list of the calling
+//  thread, instead of going through malloc / free every time.
+//  The free blocks of a thread stay cached until sts_lua_freecache() is called on that thread.
+//
+typedef struct {
+  size_t      used;         // bytes currently allocated by the state
+  size_t      peak;         // maximum of used
+  size_t      limit;        // allocations beyond this limit fail (0 = no limit)
+  lua_Integer allocations;  // amount of allocated blocks
+  lua_Integer hits;         // small blocks taken from the thread cache
+  lua_Integer failed;       // allocations refused because of the limit
+} sts_lua_memory_t;
+
+// Creates a new state with a memory limit (in bytes, 0 = unlimited). Returns NULL on failure.
+// Like luaL_newstate() no libraries are opened.
+lua_State *sts_lua_newstate(size_t limit);
+
+// Closes a state created with sts_lua_newstate().
+void sts_lua_closestate(lua_State *L);
+
+// Gets the memory statistics of a state created with sts_lua_newstate(). Returns -1 for other states.
+int sts_lua_getmemory(lua_State *L, sts_lua_memory_t *mem);
+
+// Changes the memory limit of a state created with sts_lua_newstate() (0 = unlimited).
+void sts_lua_setmemorylimit(lua_State *L, size_t limit);
+
+// Frees all blocks cached by the calling thread. Call it before a thread which used Lua states exits.
+void sts_lua_freecache(void);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Sampling profiler
+//
+//  Every sample is weighted with the CPU time of the thread since the previous sample (so CPU time
+//  spent outside of Lua in between goes to the next sample, too). All memory is part of the
+//  sts_lua_profiler_t structure, so sampling never allocates. There are two modes:
+//    timer (count = 0)   a SIGPROF timer fires every "interval" seconds of CPU time and arms a hook
+//                        for the next VM instruction, which takes the sample and removes itself again.
+//                        Lua runs at full speed between samples, so this can stay enabled in production.
+//                        Only one state can be profiled this way at a time (POSIX only, Windows falls
+//                        back to count = 1000). Samples are only taken in L, not in running coroutines.
+//                        Start and stop the profiler on the thread which runs L. On Linux the timer
+//                        measures the CPU time of this thread and signals only this thread, elsewhere
+//                        the process wide ITIMER_PROF is used and other threads forward the signal to it.
+//                        The timer resolution is limited by the kernel (often 1 - 4 ms).
+//    count (count > 0)   a count hook looks at the clock every "count" VM instructions and takes a
+//                        sample whenever "interval" seconds passed since the last one. Any number
+//                        of states can be profiled, but Lua has to run every instruction through
+//                        the hook dispatch while a count hook is set (which costs about half the speed).
+//                        Coroutines created before sts_lua_startprofiler() are not sampled.
+//  Lua functions are told apart by their source and the lines where they start and end, so closures
+//  created again and again by the same code (e.g. a comparator for table.sort) share one entry.
+//
+//    sts_lua_profiler_t *prof = malloc(sizeof(sts_lua_profiler_t));
+//    sts_lua_startprofiler(L, prof, 0, 0.001);
+//    ...run scripts...
+//    sts_lua_stopprofiler(L);
+//    sts_lua_writecollapsed(prof, file);   // input for flamegraph.pl
+//
+typedef struct {
+  const char    *source;    // the source of the function ("=[C]" for C functions, NULL if the entry is free)
+  lua_CFunction cfunction;  // the C function (NULL for Lua functions)
+  int           line;       // the line where the function was defined
+  int           lastline;   // the line where the definition ends (tells functions on the same line apart)
+  int         mark;         // the last sample which counted this function
+  int         samples;      // samples where the function was running
+  double      self;         // seconds where the function was running
+  double      total;        // seconds where the function was on the stack
+  char        name[128];
+} sts_lua_profile_function_t;
+
+typedef struct {
+  int         depth;
+  short       functions[STS_LUA_PROFILER_DEPTH];  // the running function first
+} sts_lua_profile_stack_t;
+
+typedef struct {
+  int                         count;
+  double                      interval;
+  double                      last;
+  int                         samples;          // amount of samples taken
+  int                         function_count;   // amount of different functions seen
+  int                         stack_count;      // amount of kept stacks
+  int                         dropped;          // samples whose stack wasn't kept (the stack buffer was full)
+  sts_lua_profile_function_t  functions[STS_LUA_PROFILER_FUNCTIONS];
+  sts_lua_profile_stack_t     stacks[STS_LUA_PROFILER_STACKS];
+} sts_lua_profiler_t;
+
+typedef struct {
+  const char  *name;        // "name (source:line)"
+  double      self;         // seconds spent in the function itself
+  double      total;        // seconds spent in the function and everything it called
+  int         samples;      // the samples behind "self"
+} sts_lua_profile_entry_t;
+
+// Resets prof and starts sampling L every interval seconds (see the modes above). Returns -1 if the
+// timer is already used by another state or can't be created.
+int sts_lua_startprofiler(lua_State *L, sts_lua_profiler_t *prof, int count, double interval);
+
+// Stops the profiler of L, the results stay in the sts_lua_profiler_t structure.
+void sts_lua_stopprofiler(lua_State *L);
+
+// Fills entries with up to max functions, the most expensive (self time) first. Returns the amount of entries.
+int sts_lua_getprofile(const sts_lua_profiler_t *prof, sts_lua_profile_entry_t *entries, int max);
+
+// Writes the kept stacks as "outer;...;inner count" lines (collapsed stacks for flame graphs). Returns -1 on error.
+int sts_lua_writecollapsed(const sts_lua_profiler_t *prof, FILE *f);
+
+
+#ifndef STS_LUA_NO_THREADS
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Worker states
+//
+//  Runs count isolated states, each on its own thread. Every state is created with
+//  sts_lua_newstate() + luaL_openlibs() and then handed to setup() on its thread, which
+//  registers the bindings (sts_lua_createmeta, sts_lua_setconsts...) and loads the scripts.
+//  Both run in protected mode, so setup() may raise errors. If they fail (or run out of memory),
+//  the state is closed and every job of this worker fails with "worker setup failed: <error>".
+//  Work is sent as serialized values (nil, booleans, numbers, strings and tables of them)
+//  through lock-free queues, one per worker and one for the results:
+//
+//    lua_pushinteger(L, from); lua_pushinteger(L, to);
+//    id = sts_lua_post(workers, L, -1, "find_path", 2);   // find_path(from, to) in some worker
+//    ...every frame...
+//    while ((n = sts_lua_receive(workers, L, &id)) > 0) {
+//      ...true + the results of find_path or false + error message...
+//      lua_pop(L, n);
+//    }
+//
+typedef struct sts_lua_workers_t sts_lua_workers_t;
+
+typedef void (*sts_lua_setup_func)(lua_State *L, void *userdata);
+
+// Starts count workers with a memory limit per state (0 = unlimited). Returns NULL on failure.
+sts_lua_workers_t *sts_lua_startworkers(int count, size_t limit, sts_lua_setup_func setup, void *userdata);
+
+// Lets the workers finish all posted jobs, stops them and frees all results which weren't received.
+void sts_lua_stopworkers(sts_lua_workers_t *workers);
+
+// Pops n values from L and calls the global function fname with them in a worker (-1 = the one with the fewest jobs).
+// Returns the id of the job. Raises an error if a value can't be serialized.
+int sts_lua_post(sts_lua_workers_t *workers, lua_State *L, int worker, const char *fname, int n);
+
+// Pushes the result of a finished job like lua_pcall: true + results or false + error message.
+// Unpacking the arguments and looking up the function are part of the protected call (a job over the memory limit fails).
+// Returns the amount of pushed values and sets id, 0 if there is no finished job.
+int sts_lua_receive(sts_lua_workers_t *workers, lua_State *L, int *id);
+#endif // STS_LUA_NO_THREADS
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -73,6 +376,32 @@ int sts_lua_pusherr(lua_State *L, const char *fmt, ...);
 ////
 ////
 #ifdef STS_LUA_IMPLEMENTATION
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#include <signal.h>
+#include <sys/time.h>
+#define STS_LUA__TIMER
+#ifdef __linux__
+// a CPU time timer of the thread running the profiled state, which signals only this thread
+#include <unistd.h>
+#include <sys/syscall.h>
+#define STS_LUA__THREAD_TIMER
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id  _sigev_un._tid
+#endif // sigev_notify_thread_id
+#else
+#include <pthread.h>
+#endif // __linux__
+#ifndef STS_LUA_NO_THREADS
+#include <pthread.h>
+#include <sched.h>
+#endif // STS_LUA_NO_THREADS
+#endif // _WIN32
 #include "lua.h"
 #include "lauxlib.h"
 #include "lualib.h"
@@ -116,7 +445,7 @@ void sts_lua_setconsts(lua_State *L, const sts_lua_constant_t *c) {
 }
 
 
-void sts_lua_createmeta(lua_State *L, const char *tname, const luaL_Reg *f) {
+int sts_lua_createmeta(lua_State *L, const char *tname, const luaL_Reg *f) {
   luaL_newmetatable(L, tname);
   lua_newtable(L);
   for (; f->name != NULL; ++f) {
@@ -125,7 +454,7 @@ void sts_lua_createmeta(lua_State *L, const char *tname, const luaL_Reg *f) {
     lua_settable(L, (f->name[0] == '_' && f->name[1] == '_') ? -4 : -3);
   }
   lua_setfield(L, -2, "__index");
-  lua_pop(L, 1);
+  return luaL_ref(L, LUA_REGISTRYINDEX);
 }
 
 
@@ -136,6 +465,1254 @@ void *sts_lua_newobject(lua_State *L, const char *tname, size_t size) {
 }
 
 
+void *sts_lua_newobjectref(lua_State *L, int mref, size_t size) {
+  void *obj = lua_newuserdata(L, size);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, mref);
+  lua_setmetatable(L, -2);
+  return obj;
+}
+
+
+void *sts_lua_testobject(lua_State *L, int arg, int mref) {
+  void *obj = lua_touserdata(L, arg);
+  int  same;
+
+  if (!obj || !lua_getmetatable(L, arg)) return NULL;
+  lua_rawgeti(L, LUA_REGISTRYINDEX, mref);
+  same = lua_rawequal(L, -1, -2);
+  lua_pop(L, 2);
+  return same ? obj : NULL;
+}
+
+
+void *sts_lua_checkobject(lua_State *L, int arg, int mref) {
+  void        *obj = sts_lua_testobject(L, arg, mref);
+  const char  *tname;
+
+  if (!obj) {
+    lua_rawgeti(L, LUA_REGISTRYINDEX, mref);
+    lua_getfield(L, -1, "__name");
+    tname = lua_isstring(L, -1) ? lua_tostring(L, -1) : "object";
+    luaL_argerror(L, arg, lua_pushfstring(L, "%s expected, got %s", tname, luaL_typename(L, arg)));
+  }
+  return obj;
+}
+
+
+typedef struct {
+  sts_lua_poolstats_t stats;
+  int                 max;
+} sts_lua__pool_t;
+
+
+// upvalues: pool, original __gc (or nil)
+static int sts_lua__poolgc(lua_State *L) {
+  sts_lua__pool_t *pool = (sts_lua__pool_t*)lua_touserdata(L, lua_upvalueindex(1));
+
+  if (!lua_isnil(L, lua_upvalueindex(2))) {
+    lua_pushvalue(L, lua_upvalueindex(2));
+    lua_pushvalue(L, 1);
+    lua_call(L, 1, 0);
+  }
+  if (pool->stats.pooled < pool->max) {
+    // store the object in the free list, this resurrects it
+    lua_getuservalue(L, lua_upvalueindex(1));
+    lua_pushvalue(L, 1);
+    lua_rawseti(L, -2, ++pool->stats.pooled);
+    ++pool->stats.recycled;
+  } else {
+    ++pool->stats.dropped;
+  }
+  return 0;
+}
+
+
+// the pool is stored in the metatable with the address of this variable as key
+static const char sts_lua__poolkey = 0;
+
+
+// pushes the pool of the metatable on top of the stack
+static sts_lua__pool_t *sts_lua__getpool(lua_State *L) {
+  sts_lua__pool_t *pool;
+  lua_rawgetp(L, -1, &sts_lua__poolkey);
+  pool = (sts_lua__pool_t*)lua_touserdata(L, -1);
+  if (!pool) luaL_error(L, "metatable has no pool");
+  return pool;
+}
+
+
+// the metatable is on top of the stack and gets replaced by the new object
+static void *sts_lua__newpooled(lua_State *L, size_t size) {
+  sts_lua__pool_t *pool = sts_lua__getpool(L);
+  void            *obj;
+
+  if (pool->stats.pooled > 0) {
+    lua_getuservalue(L, -1);
+    lua_rawgeti(L, -1, pool->stats.pooled);
+    if (lua_rawlen(L, -1) >= size) {
+      lua_pushnil(L);
+      lua_rawseti(L, -3, pool->stats.pooled--);
+      ++pool->stats.hits;
+      // setting the metatable again marks the object for finalization
+      lua_pushvalue(L, -4);
+      lua_setmetatable(L, -2);
+      obj = lua_touserdata(L, -1);
+      lua_replace(L, -4);
+      lua_pop(L, 2);
+      return obj;
+    }
+    lua_pop(L, 2);
+  }
+  ++pool->stats.misses;
+  obj = lua_newuserdata(L, size);
+  lua_pushvalue(L, -3);
+  lua_setmetatable(L, -2);
+  lua_replace(L, -3);
+  lua_pop(L, 1);
+  return obj;
+}
+
+
+void sts_lua_createpool(lua_State *L, const char *tname, int max) {
+  sts_lua__pool_t *pool;
+
+  luaL_getmetatable(L, tname);
+  pool = (sts_lua__pool_t*)lua_newuserdata(L, sizeof(sts_lua__pool_t));
+  memset(pool, 0, sizeof(sts_lua__pool_t));
+  pool->max = max;
+  lua_createtable(L, max, 0);
+  lua_setuservalue(L, -2);
+  lua_pushvalue(L, -1);
+  lua_rawsetp(L, -3, &sts_lua__poolkey);
+  lua_getfield(L, -2, "__gc");
+  lua_pushcclosure(L, sts_lua__poolgc, 2);
+  lua_setfield(L, -2, "__gc");
+  lua_pop(L, 1);
+}
+
+
+void *sts_lua_newpooled(lua_State *L, const char *tname, size_t size) {
+  luaL_getmetatable(L, tname);
+  return sts_lua__newpooled(L, size);
+}
+
+
+void *sts_lua_newpooledref(lua_State *L, int mref, size_t size) {
+  lua_rawgeti(L, LUA_REGISTRYINDEX, mref);
+  return sts_lua__newpooled(L, size);
+}
+
+
+void sts_lua_getpoolstats(lua_State *L, const char *tname, sts_lua_poolstats_t *stats) {
+  luaL_getmetatable(L, tname);
+  *stats = sts_lua__getpool(L)->stats;
+  lua_pop(L, 2);
+}
+
+
+void sts_lua_initstruct(lua_State *L, sts_lua_struct_t *s, const sts_lua_field_t *fields) {
+  int i;
+
+  for (i = 0; fields[i].name != NULL; ++i);
+  s->fields = fields;
+  s->count = i;
+  lua_createtable(L, i, 0);
+  for (i = 0; i < s->count; ++i) {
+    lua_pushstring(L, fields[i].name);
+    lua_rawseti(L, -2, i + 1);
+  }
+  s->keys = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+
+static void sts_lua__pushfield(lua_State *L, const sts_lua_field_t *f, const char *p) {
+  const char *end;
+  switch (f->type) {
+    case STS_LUA_FIELD_CHAR:    lua_pushinteger(L, *(const signed char*)p); break;
+    case STS_LUA_FIELD_UCHAR:   lua_pushinteger(L, *(const unsigned char*)p); break;
+    case STS_LUA_FIELD_SHORT:   lua_pushinteger(L, *(const short*)p); break;
+    case STS_LUA_FIELD_USHORT:  lua_pushinteger(L, *(const unsigned short*)p); break;
+    case STS_LUA_FIELD_INT:     lua_pushinteger(L, *(const int*)p); break;
+    case STS_LUA_FIELD_UINT:    lua_pushinteger(L, (lua_Integer)*(const unsigned int*)p); break;
+    case STS_LUA_FIELD_INTEGER: lua_pushinteger(L, *(const lua_Integer*)p); break;
+    case STS_LUA_FIELD_FLOAT:   lua_pushnumber(L, *(const float*)p); break;
+    case STS_LUA_FIELD_DOUBLE:  lua_pushnumber(L, *(const double*)p); break;
+    case STS_LUA_FIELD_BOOL:    lua_pushboolean(L, *(const int*)p); break;
+    case STS_LUA_FIELD_STRING:  lua_pushstring(L, *(const char* const*)p); break;
+    case STS_LUA_FIELD_CHARS:
+      end = (const char*)memchr(p, 0, f->size);
+      lua_pushlstring(L, p, end ? (size_t)(end - p) : f->size);
+      break;
+    default:                    lua_pushnil(L); break;
+  }
+}
+
+
+// reads the value on top of the stack into the field
+static void sts_lua__tofield(lua_State *L, const sts_lua_field_t *f, char *p) {
+  lua_Integer i = 0;
+  lua_Number  n = 0;
+  const char  *str;
+  size_t      len;
+  int         ok = 1;
+
+  switch (f->type) {
+    case STS_LUA_FIELD_FLOAT: case STS_LUA_FIELD_DOUBLE:
+      n = lua_tonumberx(L, -1, &ok);
+      break;
+    case STS_LUA_FIELD_BOOL:
+      i = lua_toboolean(L, -1);
+      break;
+    case STS_LUA_FIELD_STRING:
+      return;
+    case STS_LUA_FIELD_CHARS:
+      ok = lua_isstring(L, -1);
+      break;
+    default:
+      i = lua_tointegerx(L, -1, &ok);
+      break;
+  }
+  if (!ok) luaL_error(L, "field '%s' has the wrong type (%s)", f->name, luaL_typename(L, -1));
+  switch (f->type) {
+    case STS_LUA_FIELD_CHAR:    *(signed char*)p = (signed char)i; break;
+    case STS_LUA_FIELD_UCHAR:   *(unsigned char*)p = (unsigned char)i; break;
+    case STS_LUA_FIELD_SHORT:   *(short*)p = (short)i; break;
+    case STS_LUA_FIELD_USHORT:  *(unsigned short*)p = (unsigned short)i; break;
+    case STS_LUA_FIELD_INT:     *(int*)p = (int)i; break;
+    case STS_LUA_FIELD_UINT:    *(unsigned int*)p = (unsigned int)i; break;
+    case STS_LUA_FIELD_INTEGER: *(lua_Integer*)p = i; break;
+    case STS_LUA_FIELD_FLOAT:   *(float*)p = (float)n; break;
+    case STS_LUA_FIELD_DOUBLE:  *(double*)p = (double)n; break;
+    case STS_LUA_FIELD_BOOL:    *(int*)p = (int)i; break;
+    case STS_LUA_FIELD_CHARS:
+      if (f->size == 0) break;
+      str = lua_tolstring(L, -1, &len);
+      if (len >= f->size) len = f->size - 1;
+      memcpy(p, str, len);
+      p[len] = 0;
+      break;
+  }
+}
+
+
+// the keys table is on top of the stack
+static void sts_lua__setstruct(lua_State *L, int idx, const sts_lua_struct_t *s, const char *data) {
+  int i;
+  for (i = 0; i < s->count; ++i) {
+    lua_rawgeti(L, -1, i + 1);
+    sts_lua__pushfield(L, &s->fields[i], data + s->fields[i].offset);
+    lua_rawset(L, idx);
+  }
+}
+
+
+// the keys table is on top of the stack
+static void sts_lua__tostruct(lua_State *L, int idx, const sts_lua_struct_t *s, char *data) {
+  int i;
+  for (i = 0; i < s->count; ++i) {
+    lua_rawgeti(L, -1, i + 1);
+    lua_rawget(L, idx);
+    if (!lua_isnil(L, -1)) sts_lua__tofield(L, &s->fields[i], data + s->fields[i].offset);
+    lua_pop(L, 1);
+  }
+}
+
+
+void sts_lua_setstruct(lua_State *L, int idx, const sts_lua_struct_t *s, const void *data) {
+  idx = lua_absindex(L, idx);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, s->keys);
+  sts_lua__setstruct(L, idx, s, (const char*)data);
+  lua_pop(L, 1);
+}
+
+
+void sts_lua_pushstruct(lua_State *L, const sts_lua_struct_t *s, const void *data) {
+  lua_createtable(L, 0, s->count);
+  sts_lua_setstruct(L, -1, s, data);
+}
+
+
+void sts_lua_pushstructs(lua_State *L, const sts_lua_struct_t *s, const void *data, int count, size_t stride) {
+  const char  *p = (const char*)data;
+  int         i;
+
+  lua_createtable(L, count, 0);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, s->keys);
+  for (i = 0; i < count; ++i, p += stride) {
+    lua_createtable(L, 0, s->count);
+    lua_insert(L, -2);
+    sts_lua__setstruct(L, lua_gettop(L) - 1, s, p);
+    lua_insert(L, -2);
+    lua_rawseti(L, -3, i + 1);
+  }
+  lua_pop(L, 1);
+}
+
+
+void sts_lua_tostruct(lua_State *L, int idx, const sts_lua_struct_t *s, void *data) {
+  idx = lua_absindex(L, idx);
+  luaL_checktype(L, idx, LUA_TTABLE);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, s->keys);
+  sts_lua__tostruct(L, idx, s, (char*)data);
+  lua_pop(L, 1);
+}
+
+
+int sts_lua_tostructs(lua_State *L, int idx, const sts_lua_struct_t *s, void *data, int max, size_t stride) {
+  char  *p = (char*)data;
+  int   i, count;
+
+  idx = lua_absindex(L, idx);
+  luaL_checktype(L, idx, LUA_TTABLE);
+  count = (int)lua_rawlen(L, idx);
+  if (count > max) count = max;
+  lua_rawgeti(L, LUA_REGISTRYINDEX, s->keys);
+  for (i = 0; i < count; ++i, p += stride) {
+    lua_rawgeti(L, idx, i + 1);
+    if (!lua_istable(L, -1)) luaL_error(L, "element %d is not a table", i + 1);
+    lua_insert(L, -2);
+    sts_lua__tostruct(L, lua_gettop(L) - 1, s, p);
+    lua_insert(L, -2);
+    lua_pop(L, 1);
+  }
+  lua_pop(L, 1);
+  return count;
+}
+
+
+#define STS_LUA__CLASSES  (STS_LUA_POOL_SIZE / 16)
+
+#ifdef _MSC_VER
+#define STS_LUA__THREAD   __declspec(thread)
+#else
+#define STS_LUA__THREAD   __thread
+#endif // _MSC_VER
+
+
+typedef struct sts_lua__block_t {
+  struct sts_lua__block_t *next;
+} sts_lua__block_t;
+
+
+typedef struct {
+  sts_lua__block_t  *first[STS_LUA__CLASSES];
+  int               count[STS_LUA__CLASSES];
+} sts_lua__cache_t;
+
+
+static STS_LUA__THREAD sts_lua__cache_t sts_lua__cache;
+
+
+// returns the size class of a block or -1 for large blocks
+static int sts_lua__class(size_t size) {
+  return (size > 0 && size <= STS_LUA_POOL_SIZE) ? (int)((size - 1) >> 4) : -1;
+}
+
+
+static void *sts_lua__getblock(sts_lua_memory_t *mem, int c) {
+  sts_lua__block_t *block = sts_lua__cache.first[c];
+  if (block) {
+    sts_lua__cache.first[c] = block->next;
+    --sts_lua__cache.count[c];
+    ++mem->hits;
+    return block;
+  }
+  return malloc((size_t)(c + 1) << 4);
+}
+
+
+static void sts_lua__putblock(void *ptr, int c) {
+  sts_lua__block_t *block = (sts_lua__block_t*)ptr;
+  if (sts_lua__cache.count[c] >= STS_LUA_POOL_CACHE) {
+    free(ptr);
+  } else {
+    block->next = sts_lua__cache.first[c];
+    sts_lua__cache.first[c] = block;
+    ++sts_lua__cache.count[c];
+  }
+}
+
+
+static void *sts_lua__alloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+  sts_lua_memory_t  *mem = (sts_lua_memory_t*)ud;
+  size_t            old = ptr ? osize : 0;  // for new blocks osize is the type of the object
+  int               oc = ptr ? sts_lua__class(osize) : -1;
+  int               nc = sts_lua__class(nsize);
+  void              *p;
+
+  if (nsize == 0) {
+    if (ptr) {
+      if (oc >= 0) sts_lua__putblock(ptr, oc); else free(ptr);
+      mem->used -= old;
+    }
+    return NULL;
+  }
+  if (nsize > old && mem->limit > 0 && mem->used + (nsize - old) > mem->limit) {
+    ++mem->failed;
+    return NULL;
+  }
+  if (nc >= 0 && nc == oc) {
+    // still the same size class
+    p = ptr;
+  } else if (nc >= 0 || oc >= 0) {
+    p = nc >= 0 ? sts_lua__getblock(mem, nc) : malloc(nsize);
+    // Lua doesn't allow a shrink to fail, keep the old block (every block is malloc'ed on its own
+    // and at least as large as its new size class, so it can be freed into that class later)
+    if (!p && nsize <= old) p = ptr;
+    else if (!p) return NULL;
+    else if (ptr) {
+      memcpy(p, ptr, old < nsize ? old : nsize);
+      if (oc >= 0) sts_lua__putblock(ptr, oc); else free(ptr);
+    }
+  } else {
+    if ((p = realloc(ptr, nsize)) == NULL) {
+      if (nsize > old) return NULL;
+      p = ptr;
+    }
+  }
+  if (!ptr) ++mem->allocations;
+  mem->used = mem->used - old + nsize;
+  if (mem->used > mem->peak) mem->peak = mem->used;
+  return p;
+}
+
+
+static int sts_lua__panic(lua_State *L) {
+  const char *msg = lua_tostring(L, -1);
+  fprintf(stderr, "PANIC: unprotected error in call to Lua API (%s)\n", msg ? msg : "error object is not a string");
+  return 0;
+}
+
+
+lua_State *sts_lua_newstate(size_t limit) {
+  sts_lua_memory_t  *mem = (sts_lua_memory_t*)calloc(1, sizeof(sts_lua_memory_t));
+  lua_State         *L;
+
+  if (!mem) return NULL;
+  mem->limit = limit;
+  if ((L = lua_newstate(sts_lua__alloc, mem)) == NULL) {
+    free(mem);
+    return NULL;
+  }
+  lua_atpanic(L, sts_lua__panic);
+  return L;
+}
+
+
+static sts_lua_memory_t *sts_lua__getmemory(lua_State *L) {
+  void *ud;
+  return lua_getallocf(L, &ud) == sts_lua__alloc ? (sts_lua_memory_t*)ud : NULL;
+}
+
+
+void sts_lua_closestate(lua_State *L) {
+  sts_lua_memory_t *mem = sts_lua__getmemory(L);
+  lua_close(L);
+  free(mem);
+}
+
+
+int sts_lua_getmemory(lua_State *L, sts_lua_memory_t *mem) {
+  sts_lua_memory_t *m = sts_lua__getmemory(L);
+  if (!m) return -1;
+  *mem = *m;
+  return 0;
+}
+
+
+void sts_lua_setmemorylimit(lua_State *L, size_t limit) {
+  sts_lua_memory_t *mem = sts_lua__getmemory(L);
+  if (mem) mem->limit = limit;
+}
+
+
+void sts_lua_freecache(void) {
+  sts_lua__block_t  *block;
+  int               i;
+
+  for (i = 0; i < STS_LUA__CLASSES; ++i) {
+    while ((block = sts_lua__cache.first[i]) != NULL) {
+      sts_lua__cache.first[i] = block->next;
+      free(block);
+    }
+    sts_lua__cache.count[i] = 0;
+  }
+}
+
+
+// the profiler is stored in the registry with the address of this variable as key
+static const char sts_lua__profilerkey = 0;
+
+
+// CPU time of the calling thread in seconds
+static double sts_lua__cputime(void) {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+  return (double)(((unsigned long long)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime) +
+                  ((unsigned long long)user.dwHighDateTime << 32 | user.dwLowDateTime)) / 10000000.0;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+#endif // _WIN32
+}
+
+
+// returns the index of the function of frame ar, the first function collects everything which didn't fit
+static int sts_lua__findfunction(lua_State *L, sts_lua_profiler_t *prof, lua_Debug *ar) {
+  sts_lua_profile_function_t  *func;
+  lua_CFunction               cfunction = NULL;
+  unsigned int                i, hash;
+  char                        *c;
+
+  // Lua functions are identified by where they are defined, C functions by the function itself
+  lua_getinfo(L, "S", ar);
+  if (ar->what[0] == 'C') {
+    lua_getinfo(L, "f", ar);
+    cfunction = lua_tocfunction(L, -1);
+    lua_pop(L, 1);
+  }
+  hash = (unsigned int)(((size_t)ar->source >> 3) + ((size_t)cfunction >> 3) * 31u + (unsigned int)ar->linedefined * 131u + (unsigned int)ar->lastlinedefined) * 2654435761u;
+  for (i = 0; i < STS_LUA_PROFILER_FUNCTIONS; ++i) {
+    func = &prof->functions[1 + (hash + i) % (STS_LUA_PROFILER_FUNCTIONS - 1)];
+    if (func->source == ar->source && func->cfunction == cfunction && func->line == ar->linedefined && func->lastline == ar->lastlinedefined) return (int)(func - prof->functions);
+    if (func->source == NULL) break;
+  }
+  if (func->source != NULL) return 0;
+  // a new function, this is the only place which needs the name
+  lua_getinfo(L, "n", ar);
+  func->source = ar->source;
+  func->cfunction = cfunction;
+  func->line = ar->linedefined;
+  func->lastline = ar->lastlinedefined;
+  if (ar->what[0] == 'C') {
+    snprintf(func->name, sizeof(func->name), "%s ([C])", ar->name ? ar->name : "?");
+  } else if (ar->what[0] == 'm') {
+    snprintf(func->name, sizeof(func->name), "main chunk (%s)", ar->short_src);
+  } else {
+    snprintf(func->name, sizeof(func->name), "%s (%s:%d)", ar->name ? ar->name : "?", ar->short_src, ar->linedefined);
+  }
+  // ';' separates the frames of collapsed stacks
+  for (c = func->name; *c; ++c) if (*c == ';') *c = ':';
+  ++prof->function_count;
+  return (int)(func - prof->functions);
+}
+
+
+static void sts_lua__profilerhook(lua_State *L, lua_Debug *hook) {
+  sts_lua_profiler_t        *prof;
+  sts_lua_profile_stack_t   *stack;
+  lua_Debug                 ar;
+  double                    now, weight;
+  int                       level, index;
+
+  (void)hook;
+  now = sts_lua__cputime();
+  lua_rawgetp(L, LUA_REGISTRYINDEX, &sts_lua__profilerkey);
+  prof = (sts_lua_profiler_t*)lua_touserdata(L, -1);
+  lua_pop(L, 1);
+  if (!prof) return;
+  if (prof->count == 0) {
+    // armed by the timer, just this one sample
+    lua_sethook(L, NULL, 0, 0);
+  } else if (now - prof->last < prof->interval) {
+    return;
+  }
+  weight = now - prof->last;
+  prof->last = now;
+  ++prof->samples;
+  stack = prof->stack_count < STS_LUA_PROFILER_STACKS ? &prof->stacks[prof->stack_count++] : NULL;
+  if (!stack) ++prof->dropped;
+  for (level = 0; level < STS_LUA_PROFILER_DEPTH && lua_getstack(L, level, &ar); ++level) {
+    index = sts_lua__findfunction(L, prof, &ar);
+    if (level == 0) {
+      ++prof->functions[index].samples;
+      prof->functions[index].self += weight;
+    }
+    // recursive functions count only once
+    if (prof->functions[index].mark != prof->samples) {
+      prof->functions[index].mark = prof->samples;
+      prof->functions[index].total += weight;
+    }
+    if (stack) stack->functions[level] = (short)index;
+  }
+  if (stack) stack->depth = level;
+}
+
+
+#ifdef STS_LUA__TIMER
+static lua_State * volatile sts_lua__profiled = NULL;
+static struct sigaction     sts_lua__oldaction;
+#ifdef STS_LUA__THREAD_TIMER
+static timer_t              sts_lua__timer;
+#else
+static pthread_t            sts_lua__profiledthread;
+#endif // STS_LUA__THREAD_TIMER
+
+
+// lua_sethook() may be called from a signal handler, this is how lua.c handles Ctrl+C too,
+// but only on the thread running L (it looks at the call stack of L)
+static void sts_lua__profilersignal(int sig) {
+  lua_State *L = sts_lua__profiled;
+  (void)sig;
+  if (!L) return;
+#ifndef STS_LUA__THREAD_TIMER
+  // the process timer signals any thread, hand it over to the thread running L
+  if (!pthread_equal(pthread_self(), sts_lua__profiledthread)) {
+    pthread_kill(sts_lua__profiledthread, SIGPROF);
+    return;
+  }
+#endif // STS_LUA__THREAD_TIMER
+  lua_sethook(L, sts_lua__profilerhook, LUA_MASKCOUNT, 1);
+}
+#endif // STS_LUA__TIMER
+
+
+int sts_lua_startprofiler(lua_State *L, sts_lua_profiler_t *prof, int count, double interval) {
+#ifdef STS_LUA__TIMER
+  struct sigaction  action;
+#ifdef STS_LUA__THREAD_TIMER
+  struct sigevent   event;
+  struct itimerspec timer;
+#else
+  struct itimerval  timer;
+#endif // STS_LUA__THREAD_TIMER
+
+  if (count <= 0 && sts_lua__profiled) return -1;
+#else
+  if (count <= 0) count = 1000;
+#endif // STS_LUA__TIMER
+  memset(prof, 0, sizeof(sts_lua_profiler_t));
+  strcpy(prof->functions[0].name, "(other)");
+  prof->count = count > 0 ? count : 0;
+  prof->interval = interval;
+  prof->last = sts_lua__cputime();
+  lua_pushlightuserdata(L, prof);
+  lua_rawsetp(L, LUA_REGISTRYINDEX, &sts_lua__profilerkey);
+  if (prof->count > 0) {
+    lua_sethook(L, sts_lua__profilerhook, LUA_MASKCOUNT, prof->count);
+    return 0;
+  }
+#ifdef STS_LUA__TIMER
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = sts_lua__profilersignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGPROF, &action, &sts_lua__oldaction);
+#ifdef STS_LUA__THREAD_TIMER
+  memset(&event, 0, sizeof(event));
+  event.sigev_notify = SIGEV_THREAD_ID;
+  event.sigev_signo = SIGPROF;
+  event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+  if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &sts_lua__timer) != 0) {
+    sigaction(SIGPROF, &sts_lua__oldaction, NULL);
+    lua_pushnil(L);
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &sts_lua__profilerkey);
+    return -1;
+  }
+  sts_lua__profiled = L;
+  timer.it_interval.tv_sec = (time_t)interval;
+  timer.it_interval.tv_nsec = (long)((interval - (double)(long)interval) * 1000000000.0);
+  if (timer.it_interval.tv_sec == 0 && timer.it_interval.tv_nsec < 1000) timer.it_interval.tv_nsec = 1000;
+  timer.it_value = timer.it_interval;
+  timer_settime(sts_lua__timer, 0, &timer, NULL);
+#else
+  sts_lua__profiledthread = pthread_self();
+  sts_lua__profiled = L;
+  timer.it_interval.tv_sec = (long)interval;
+  timer.it_interval.tv_usec = (long)((interval - (double)(long)interval) * 1000000.0);
+  if (timer.it_interval.tv_sec == 0 && timer.it_interval.tv_usec == 0) timer.it_interval.tv_usec = 1;
+  timer.it_value = timer.it_interval;
+  setitimer(ITIMER_PROF, &timer, NULL);
+#endif // STS_LUA__THREAD_TIMER
+#endif // STS_LUA__TIMER
+  return 0;
+}
+
+
+void sts_lua_stopprofiler(lua_State *L) {
+#ifdef STS_LUA__TIMER
+#ifndef STS_LUA__THREAD_TIMER
+  struct itimerval timer;
+#endif // STS_LUA__THREAD_TIMER
+
+  if (sts_lua__profiled == L) {
+    sts_lua__profiled = NULL;
+#ifdef STS_LUA__THREAD_TIMER
+    timer_delete(sts_lua__timer);
+#else
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+#endif // STS_LUA__THREAD_TIMER
+    // a SIGPROF might still be on its way, which would terminate the process with the default action
+    if (sts_lua__oldaction.sa_handler != SIG_DFL) sigaction(SIGPROF, &sts_lua__oldaction, NULL);
+  }
+#endif // STS_LUA__TIMER
+  lua_sethook(L, NULL, 0, 0);
+  lua_pushnil(L);
+  lua_rawsetp(L, LUA_REGISTRYINDEX, &sts_lua__profilerkey);
+}
+
+
+int sts_lua_getprofile(const sts_lua_profiler_t *prof, sts_lua_profile_entry_t *entries, int max) {
+  const sts_lua_profile_function_t  *func;
+  sts_lua_profile_entry_t           entry;
+  int                               i, j, count = 0;
+
+  for (i = 0; i < STS_LUA_PROFILER_FUNCTIONS; ++i) {
+    func = &prof->functions[i];
+    if (func->mark == 0) continue;
+    entry.name = func->name;
+    entry.samples = func->samples;
+    entry.self = func->self;
+    entry.total = func->total;
+    // insertion sort, the list is short and only built for reports
+    for (j = count < max ? count++ : max; j > 0 && entries[j - 1].self < entry.self; --j) {
+      if (j < max) entries[j] = entries[j - 1];
+    }
+    if (j < max) entries[j] = entry;
+  }
+  return count;
+}
+
+
+static int sts_lua__comparestacks(const void *a, const void *b) {
+  const sts_lua_profile_stack_t *sa = *(const sts_lua_profile_stack_t* const*)a;
+  const sts_lua_profile_stack_t *sb = *(const sts_lua_profile_stack_t* const*)b;
+  if (sa->depth != sb->depth) return sa->depth - sb->depth;
+  return memcmp(sa->functions, sb->functions, sizeof(short) * (size_t)sa->depth);
+}
+
+
+int sts_lua_writecollapsed(const sts_lua_profiler_t *prof, FILE *f) {
+  const sts_lua_profile_stack_t **sorted;
+  int                           i, j, count;
+
+  if (prof->stack_count == 0) return 0;
+  sorted = (const sts_lua_profile_stack_t**)malloc(sizeof(sts_lua_profile_stack_t*) * (size_t)prof->stack_count);
+  if (!sorted) return -1;
+  for (i = 0; i < prof->stack_count; ++i) sorted[i] = &prof->stacks[i];
+  qsort(sorted, (size_t)prof->stack_count, sizeof(sts_lua_profile_stack_t*), sts_lua__comparestacks);
+  for (i = 0; i < prof->stack_count; i += count) {
+    for (count = 1; i + count < prof->stack_count && sts_lua__comparestacks(&sorted[i], &sorted[i + count]) == 0; ++count);
+    if (sorted[i]->depth == 0) continue;
+    for (j = sorted[i]->depth - 1; j >= 0; --j) {
+      fputs(prof->functions[sorted[i]->functions[j]].name, f);
+      if (j > 0) fputc(';', f);
+    }
+    fprintf(f, " %d\n", count);
+  }
+  free(sorted);
+  return ferror(f) ? -1 : 0;
+}
+
+
+#ifndef STS_LUA_NO_THREADS
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Worker states
+//
+#ifdef _MSC_VER
+#define STS_LUA__ADD(p, v)            (InterlockedExchangeAdd((volatile LONG*)(p), (v)) + (v))
+#define STS_LUA__LOAD(p)              InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#define STS_LUA__LOAD_PTR(p)          InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+#define STS_LUA__STORE_PTR(p, v)      (void)InterlockedExchangePointer((PVOID volatile*)(p), (v))
+#define STS_LUA__EXCHANGE_PTR(p, v)   InterlockedExchangePointer((PVOID volatile*)(p), (v))
+#define STS_LUA__YIELD()              SwitchToThread()
+#else
+#define STS_LUA__ADD(p, v)            __atomic_add_fetch((p), (v), __ATOMIC_ACQ_REL)
+#define STS_LUA__LOAD(p)              __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STS_LUA__LOAD_PTR(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STS_LUA__STORE_PTR(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define STS_LUA__EXCHANGE_PTR(p, v)   __atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+#define STS_LUA__YIELD()              sched_yield()
+#endif // _MSC_VER
+
+// the maximum nesting of serialized tables (also catches cycles)
+#define STS_LUA__MAX_DEPTH            32
+
+enum {
+  STS_LUA__NIL,
+  STS_LUA__FALSE,
+  STS_LUA__TRUE,
+  STS_LUA__INTEGER,
+  STS_LUA__NUMBER,
+  STS_LUA__STRING,
+  STS_LUA__TABLE,
+  STS_LUA__END      // the end of a table
+};
+
+
+typedef struct sts_lua__message_t {
+  struct sts_lua__message_t *next;
+  int                       id;
+  int                       status;     // 1 = ok, 0 = error, -1 = stop the worker
+  int                       count;      // amount of values (jobs start with the name of the function)
+  size_t                    length;
+  size_t                    capacity;
+  unsigned char             *data;
+} sts_lua__message_t;
+
+
+// lock-free multiple producer / single consumer queue (Dmitry Vyukov's intrusive queue)
+typedef struct {
+  sts_lua__message_t  *head;      // producers push here
+  sts_lua__message_t  *tail;      // the consumer pops here
+  sts_lua__message_t  stub;
+} sts_lua__queue_t;
+
+
+typedef struct {
+  sts_lua_workers_t   *workers;
+  sts_lua__queue_t    jobs;
+  int                 pending;    // posted but not finished jobs
+  int                 posted;     // semaphore count
+#ifdef _WIN32
+  HANDLE              thread;
+  HANDLE              semaphore;
+#else
+  pthread_t           thread;
+  pthread_mutex_t     mutex;
+  pthread_cond_t      cond;
+#endif // _WIN32
+} sts_lua__worker_t;
+
+
+struct sts_lua_workers_t {
+  int                 count;
+  size_t              limit;
+  sts_lua_setup_func  setup;
+  void                *userdata;
+  int                 next_id;
+  sts_lua__queue_t    results;
+  sts_lua__worker_t   *workers;
+};
+
+
+static void sts_lua__initqueue(sts_lua__queue_t *queue) {
+  queue->stub.next = NULL;
+  queue->head = queue->tail = &queue->stub;
+}
+
+
+static void sts_lua__push(sts_lua__queue_t *queue, sts_lua__message_t *message) {
+  sts_lua__message_t *prev;
+  message->next = NULL;
+  prev = (sts_lua__message_t*)STS_LUA__EXCHANGE_PTR(&queue->head, message);
+  STS_LUA__STORE_PTR(&prev->next, message);
+}
+
+
+// returns NULL if the queue is empty or a producer is just in the middle of a push
+static sts_lua__message_t *sts_lua__pop(sts_lua__queue_t *queue) {
+  sts_lua__message_t *tail = queue->tail, *next = (sts_lua__message_t*)STS_LUA__LOAD_PTR(&tail->next);
+
+  if (tail == &queue->stub) {
+    if (!next) return NULL;
+    queue->tail = tail = next;
+    next = (sts_lua__message_t*)STS_LUA__LOAD_PTR(&tail->next);
+  }
+  if (next) {
+    queue->tail = next;
+    return tail;
+  }
+  if (tail != (sts_lua__message_t*)STS_LUA__LOAD_PTR(&queue->head)) return NULL;
+  sts_lua__push(queue, &queue->stub);
+  next = (sts_lua__message_t*)STS_LUA__LOAD_PTR(&tail->next);
+  if (next) {
+    queue->tail = next;
+    return tail;
+  }
+  return NULL;
+}
+
+
+static sts_lua__message_t *sts_lua__newmessage(int id, int status) {
+  sts_lua__message_t *message = (sts_lua__message_t*)calloc(1, sizeof(sts_lua__message_t));
+  if (message) {
+    message->id = id;
+    message->status = status;
+  }
+  return message;
+}
+
+
+static void sts_lua__freemessage(sts_lua__message_t *message) {
+  free(message->data);
+  free(message);
+}
+
+
+static int sts_lua__write(sts_lua__message_t *message, const void *data, size_t length) {
+  unsigned char *p;
+  size_t        capacity;
+
+  if (message->length + length > message->capacity) {
+    for (capacity = message->capacity ? message->capacity * 2 : 256; capacity < message->length + length; capacity *= 2);
+    if ((p = (unsigned char*)realloc(message->data, capacity)) == NULL) return -1;
+    message->data = p;
+    message->capacity = capacity;
+  }
+  memcpy(message->data + message->length, data, length);
+  message->length += length;
+  return 0;
+}
+
+
+static int sts_lua__writetag(sts_lua__message_t *message, unsigned char tag) {
+  return sts_lua__write(message, &tag, 1);
+}
+
+
+static int sts_lua__writestring(sts_lua__message_t *message, const char *str, size_t len) {
+  return (sts_lua__writetag(message, STS_LUA__STRING) || sts_lua__write(message, &len, sizeof(len)) ||
+          sts_lua__write(message, str, len)) ? -1 : 0;
+}
+
+
+// serializes the value at idx, returns an error message or NULL
+static const char *sts_lua__serialize(lua_State *L, int idx, sts_lua__message_t *message, int depth) {
+  lua_Integer i;
+  lua_Number  n;
+  const char  *str, *error;
+  size_t      len;
+
+  idx = lua_absindex(L, idx);
+  switch (lua_type(L, idx)) {
+    case LUA_TNIL:
+      return sts_lua__writetag(message, STS_LUA__NIL) ? "out of memory" : NULL;
+    case LUA_TBOOLEAN:
+      return sts_lua__writetag(message, lua_toboolean(L, idx) ? STS_LUA__TRUE : STS_LUA__FALSE) ? "out of memory" : NULL;
+    case LUA_TNUMBER:
+      if (lua_isinteger(L, idx)) {
+        i = lua_tointeger(L, idx);
+        return (sts_lua__writetag(message, STS_LUA__INTEGER) || sts_lua__write(message, &i, sizeof(i))) ? "out of memory" : NULL;
+      }
+      n = lua_tonumber(L, idx);
+      return (sts_lua__writetag(message, STS_LUA__NUMBER) || sts_lua__write(message, &n, sizeof(n))) ? "out of memory" : NULL;
+    case LUA_TSTRING:
+      str = lua_tolstring(L, idx, &len);
+      return sts_lua__writestring(message, str, len) ? "out of memory" : NULL;
+    case LUA_TTABLE:
+      if (depth >= STS_LUA__MAX_DEPTH) return "tables nested too deep (or cyclic)";
+      if (!lua_checkstack(L, 3)) return "stack overflow";
+      if (sts_lua__writetag(message, STS_LUA__TABLE)) return "out of memory";
+      lua_pushnil(L);
+      while (lua_next(L, idx)) {
+        if ((error = sts_lua__serialize(L, -2, message, depth + 1)) != NULL ||
+            (error = sts_lua__serialize(L, -1, message, depth + 1)) != NULL) {
+          lua_pop(L, 2);
+          return error;
+        }
+        lua_pop(L, 1);
+      }
+      return sts_lua__writetag(message, STS_LUA__END) ? "out of memory" : NULL;
+    default:
+      return "values of this type can't be sent to other states";
+  }
+}
+
+
+// pushes the next value of message, returns 0 on success or -1 on a table end / broken data
+static int sts_lua__deserialize(lua_State *L, sts_lua__message_t *message, size_t *pos) {
+  lua_Integer i;
+  lua_Number  n;
+  size_t      len;
+
+  if (*pos >= message->length) return -1;
+  luaL_checkstack(L, 3, "deserialize");
+  switch (message->data[(*pos)++]) {
+    case STS_LUA__NIL:
+      lua_pushnil(L);
+      return 0;
+    case STS_LUA__FALSE: case STS_LUA__TRUE:
+      lua_pushboolean(L, message->data[*pos - 1] == STS_LUA__TRUE);
+      return 0;
+    case STS_LUA__INTEGER:
+      memcpy(&i, message->data + *pos, sizeof(i));
+      *pos += sizeof(i);
+      lua_pushinteger(L, i);
+      return 0;
+    case STS_LUA__NUMBER:
+      memcpy(&n, message->data + *pos, sizeof(n));
+      *pos += sizeof(n);
+      lua_pushnumber(L, n);
+      return 0;
+    case STS_LUA__STRING:
+      memcpy(&len, message->data + *pos, sizeof(len));
+      *pos += sizeof(len);
+      lua_pushlstring(L, (const char*)message->data + *pos, len);
+      *pos += len;
+      return 0;
+    case STS_LUA__TABLE:
+      lua_newtable(L);
+      while (sts_lua__deserialize(L, message, pos) == 0) {
+        sts_lua__deserialize(L, message, pos);
+        lua_rawset(L, -3);
+      }
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+
+// serializes the top n values into message and pops them, returns an error message or NULL
+static const char *sts_lua__serializevalues(lua_State *L, int n, sts_lua__message_t *message) {
+  const char  *error = NULL;
+  int         i;
+
+  for (i = n; i > 0 && !error; --i) error = sts_lua__serialize(L, -i, message, 0);
+  lua_pop(L, n);
+  message->count += n;
+  return error;
+}
+
+
+// replaces the values of a result with an error message
+static void sts_lua__seterror(sts_lua__message_t *message, const char *error) {
+  message->status = 0;
+  message->length = 0;
+  message->count = sts_lua__writestring(message, error, strlen(error)) ? 0 : 1;
+}
+
+
+static void sts_lua__pushvalues(lua_State *L, sts_lua__message_t *message) {
+  size_t  pos = 0;
+  int     i;
+  for (i = 0; i < message->count; ++i) sts_lua__deserialize(L, message, &pos);
+}
+
+
+static void sts_lua__signal(sts_lua__worker_t *worker) {
+#ifdef _WIN32
+  ReleaseSemaphore(worker->semaphore, 1, NULL);
+#else
+  pthread_mutex_lock(&worker->mutex);
+  ++worker->posted;
+  pthread_cond_signal(&worker->cond);
+  pthread_mutex_unlock(&worker->mutex);
+#endif // _WIN32
+}
+
+
+static void sts_lua__wait(sts_lua__worker_t *worker) {
+#ifdef _WIN32
+  WaitForSingleObject(worker->semaphore, INFINITE);
+#else
+  pthread_mutex_lock(&worker->mutex);
+  while (worker->posted == 0) pthread_cond_wait(&worker->cond, &worker->mutex);
+  --worker->posted;
+  pthread_mutex_unlock(&worker->mutex);
+#endif // _WIN32
+}
+
+
+// opens the libraries and calls the setup function of a new worker state (protected by lua_pcall)
+static int sts_lua__setupworker(lua_State *L) {
+  sts_lua_workers_t *workers = (sts_lua_workers_t*)lua_touserdata(L, 1);
+
+  lua_pop(L, 1);
+  luaL_openlibs(L);
+  if (workers->setup) workers->setup(L, workers->userdata);
+  return 0;
+}
+
+
+// unpacks a job and calls its global function (protected by lua_pcall, a memory limit or __index can raise errors)
+static int sts_lua__callworker(lua_State *L) {
+  sts_lua__message_t *job = (sts_lua__message_t*)lua_touserdata(L, 1);
+
+  lua_pop(L, 1);
+  sts_lua__pushvalues(L, job);
+  lua_pushglobaltable(L);
+  lua_pushvalue(L, 1);
+  lua_gettable(L, -2);
+  lua_replace(L, 1);
+  lua_pop(L, 1);
+  lua_call(L, job->count - 1, LUA_MULTRET);
+  return lua_gettop(L);
+}
+
+
+static void sts_lua__runworker(sts_lua__worker_t *worker) {
+  sts_lua_workers_t   *workers = worker->workers;
+  sts_lua__message_t  *job, *result;
+  lua_State           *L = sts_lua_newstate(workers->limit);
+  const char          *error;
+  char                failure[256];
+
+  strcpy(failure, "cannot create state");
+  if (L) {
+    lua_pushcfunction(L, sts_lua__setupworker);
+    lua_pushlightuserdata(L, workers);
+    if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+      // keep the message, the state is gone
+      error = lua_tostring(L, -1);
+      snprintf(failure, sizeof(failure), "worker setup failed: %s", error ? error : "(error object is not a string)");
+      sts_lua_closestate(L);
+      L = NULL;
+    } else {
+      lua_settop(L, 0);
+    }
+  }
+  for (;;) {
+    sts_lua__wait(worker);
+    // the semaphore says there is a job, but its producer might not be done linking it
+    while ((job = sts_lua__pop(&worker->jobs)) == NULL) STS_LUA__YIELD();
+    if (job->status < 0) {
+      sts_lua__freemessage(job);
+      break;
+    }
+    result = sts_lua__newmessage(job->id, 1);
+    if (result && L) {
+      lua_pushcfunction(L, sts_lua__callworker);
+      lua_pushlightuserdata(L, job);
+      if (lua_pcall(L, 1, LUA_MULTRET, 0) != LUA_OK) result->status = 0;
+      if ((error = sts_lua__serializevalues(L, lua_gettop(L), result)) != NULL) sts_lua__seterror(result, error);
+    } else if (result) {
+      sts_lua__seterror(result, failure);
+    }
+    sts_lua__freemessage(job);
+    STS_LUA__ADD(&worker->pending, -1);
+    if (result) sts_lua__push(&workers->results, result);
+  }
+  if (L) sts_lua_closestate(L);
+  sts_lua_freecache();
+}
+
+
+#ifdef _WIN32
+static DWORD WINAPI sts_lua__workermain(LPVOID arg) {
+#else
+static void *sts_lua__workermain(void *arg) {
+#endif // _WIN32
+  sts_lua__runworker((sts_lua__worker_t*)arg);
+  return 0;
+}
+
+
+// stops and frees the first count workers
+static void sts_lua__stopworkers(sts_lua_workers_t *workers, int count) {
+  sts_lua__message_t  *message;
+  int                 i;
+
+  for (i = 0; i < count; ++i) {
+    // the stop message is queued behind all jobs
+    if ((message = sts_lua__newmessage(0, -1)) != NULL) {
+      sts_lua__push(&workers->workers[i].jobs, message);
+      sts_lua__signal(&workers->workers[i]);
+    }
+  }
+  for (i = 0; i < count; ++i) {
+#ifdef _WIN32
+    WaitForSingleObject(workers->workers[i].thread, INFINITE);
+    CloseHandle(workers->workers[i].thread);
+    CloseHandle(workers->workers[i].semaphore);
+#else
+    pthread_join(workers->workers[i].thread, NULL);
+    pthread_mutex_destroy(&workers->workers[i].mutex);
+    pthread_cond_destroy(&workers->workers[i].cond);
+#endif // _WIN32
+  }
+  while ((message = sts_lua__pop(&workers->results)) != NULL) sts_lua__freemessage(message);
+  free(workers->workers);
+  free(workers);
+}
+
+
+sts_lua_workers_t *sts_lua_startworkers(int count, size_t limit, sts_lua_setup_func setup, void *userdata) {
+  sts_lua_workers_t *workers = (sts_lua_workers_t*)calloc(1, sizeof(sts_lua_workers_t));
+  sts_lua__worker_t *worker;
+  int               i;
+
+  if (!workers) return NULL;
+  if (count < 1 || (workers->workers = (sts_lua__worker_t*)calloc((size_t)count, sizeof(sts_lua__worker_t))) == NULL) {
+    free(workers);
+    return NULL;
+  }
+  workers->limit = limit;
+  workers->setup = setup;
+  workers->userdata = userdata;
+  sts_lua__initqueue(&workers->results);
+  for (i = 0; i < count; ++i) {
+    worker = &workers->workers[i];
+    worker->workers = workers;
+    sts_lua__initqueue(&worker->jobs);
+#ifdef _WIN32
+    if ((worker->semaphore = CreateSemaphore(NULL, 0, 0x7fffffff, NULL)) == NULL) break;
+    if ((worker->thread = CreateThread(NULL, 0, sts_lua__workermain, worker, 0, NULL)) == NULL) {
+      CloseHandle(worker->semaphore);
+      break;
+    }
+#else
+    pthread_mutex_init(&worker->mutex, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+    if (pthread_create(&worker->thread, NULL, sts_lua__workermain, worker) != 0) {
+      pthread_mutex_destroy(&worker->mutex);
+      pthread_cond_destroy(&worker->cond);
+      break;
+    }
+#endif // _WIN32
+  }
+  if (i < count) {
+    sts_lua__stopworkers(workers, i);
+    return NULL;
+  }
+  workers->count = count;
+  return workers;
+}
+
+
+void sts_lua_stopworkers(sts_lua_workers_t *workers) {
+  if (workers) sts_lua__stopworkers(workers, workers->count);
+}
+
+
+int sts_lua_post(sts_lua_workers_t *workers, lua_State *L, int worker, const char *fname, int n) {
+  sts_lua__message_t  *job;
+  const char          *error;
+  int                 i, id;
+
+  if (worker < 0 || worker >= workers->count) {
+    for (worker = 0, i = 1; i < workers->count; ++i) {
+      if (STS_LUA__LOAD(&workers->workers[i].pending) < STS_LUA__LOAD(&workers->workers[worker].pending)) worker = i;
+    }
+  }
+  if ((job = sts_lua__newmessage(id = ++workers->next_id, 1)) == NULL) return luaL_error(L, "out of memory");
+  if (sts_lua__writestring(job, fname, strlen(fname)) < 0) {
+    sts_lua__freemessage(job);
+    return luaL_error(L, "out of memory");
+  }
+  job->count = 1;
+  if ((error = sts_lua__serializevalues(L, n, job)) != NULL) {
+    sts_lua__freemessage(job);
+    return luaL_error(L, "%s", error);
+  }
+  STS_LUA__ADD(&workers->workers[worker].pending, 1);
+  sts_lua__push(&workers->workers[worker].jobs, job);
+  sts_lua__signal(&workers->workers[worker]);
+  return id;
+}
+
+
+int sts_lua_receive(sts_lua_workers_t *workers, lua_State *L, int *id) {
+  sts_lua__message_t  *result = sts_lua__pop(&workers->results);
+  int                 count;
+
+  if (!result) return 0;
+  luaL_checkstack(L, result->count + 1, "receive");
+  lua_pushboolean(L, result->status);
+  sts_lua__pushvalues(L, result);
+  if (id) *id = result->id;
+  count = result->count + 1;
+  sts_lua__freemessage(result);
+  return count;
+}
+#endif // STS_LUA_NO_THREADS
+
+
 int sts_lua_pushok(lua_State *L) {
   lua_pushboolean(L, 1);
   return 1;
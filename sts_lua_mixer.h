@@ -0,0 +1,709 @@
+////////////////////////////////////////////////////////////////////////////////
+/*
+ sts_lua_mixer.h - v0.02 - public domain
+
+  VERSION HISTORY
+    0.02 (2026-10-19) voice handles compare the generation of the mixer voice, so they don't control later sounds
+                      compiles without the mixer implementation in the same file
+                      mixer.gain() checks its argument before locking the audio thread
+    0.01 (2026-10-19) initial version
+
+  LICENSE
+    Public domain. See "unlicense" statement at the end of this file.
+
+  ABOUT
+    Lua bindings for sts_mixer.h. Samples, streams and voices are userdata, every change
+    of the mixer state happens under the lock given to sts_lua_openmixer() (e.g. SDL_LockAudioDevice).
+    A script can collect any amount of play / stop / set commands in a batch and apply
+    them with a single lock, instead of locking the audio thread for every sound.
+
+  USAGE
+    C:
+      #include "lua.h"
+      #include "lauxlib.h"
+      #include "sts_lua_mixer.h"
+      ...
+      sts_lua_openmixer(L, &mixer, lock_audio, NULL);
+      lua_setglobal(L, "mixer");
+
+    Lua:
+      local boom = mixer.sample(mixer.FORMAT_16, 22050, pcm_data)   -- mono PCM as string
+      local music = mixer.stream(mixer.FORMAT_FLOAT, 44100, 4096)   -- 4096 stereo frames per refill
+      local voice = mixer.voice()
+      local batch = mixer.batch(64)                                 -- room for 64 commands
+
+      music:write(decoded)                                          -- queue stereo PCM, returns accepted bytes
+      batch:stream(music, 0.7)
+      batch:play(boom, 1.0, 1.0, -0.5, voice)                       -- voice gets bound when submitted
+      batch:set(voice, 0.5, 1.2, 0.5)
+      mixer.submit(batch)                                           -- one lock for everything, batch is empty again
+      ...
+      voice:stop()                                                  -- single calls take the lock themselves
+
+  DEPENDENCIES
+    sts_lua, sts_mixer
+
+*/
+////////////////////////////////////////////////////////////////////////////////
+#ifndef __INCLUDED__STS_LUA_MIXER_H__
+#define __INCLUDED__STS_LUA_MIXER_H__
+
+
+#include "sts_mixer.h"
+#include "sts_lua.h"
+
+
+#ifndef STS_LUA_MIXER_BATCH
+// the default amount of commands of a batch
+#define STS_LUA_MIXER_BATCH     64
+#endif // STS_LUA_MIXER_BATCH
+
+#ifndef STS_LUA_MIXER_VOICE_POOL
+// the amount of collected voice objects kept for reuse
+#define STS_LUA_MIXER_VOICE_POOL  256
+#endif // STS_LUA_MIXER_VOICE_POOL
+
+
+// Called with lock = 1 before and lock = 0 after the mixer state is changed.
+typedef void (*sts_lua_mixer_lock_func)(void *userdata, int lock);
+
+// Pushes the mixer module table. lock may be NULL if the mixer isn't used by another thread.
+// The mixer has to stay valid as long as L exists.
+void sts_lua_openmixer(lua_State *L, sts_mixer_t *mixer, sts_lua_mixer_lock_func lock, void *userdata);
+
+
+#endif // __INCLUDED__STS_LUA_MIXER_H__
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////
+////    IMPLEMENTATION
+////
+////
+#ifdef STS_LUA_MIXER_IMPLEMENTATION
+#include <string.h>
+
+
+enum {
+  STS_LUA_MIXER__PLAY,
+  STS_LUA_MIXER__STREAM,
+  STS_LUA_MIXER__STOP,
+  STS_LUA_MIXER__SET
+};
+
+
+typedef struct {
+  sts_mixer_t             *mixer;
+  sts_lua_mixer_lock_func lock;
+  void                    *userdata;
+  int                     sample_ref, stream_ref, voice_ref, batch_ref;
+} sts_lua_mixer__context_t;
+
+
+typedef struct {
+  sts_mixer_sample_t        sample;
+  sts_lua_mixer__context_t  *context;
+  // the PCM data follows
+} sts_lua_mixer__sample_t;
+
+
+typedef struct {
+  sts_mixer_stream_t        stream;
+  sts_lua_mixer__context_t  *context;
+  unsigned char             *ring;      // the queued PCM data, written by stream:write
+  size_t                    capacity;   // size of the ring in bytes
+  size_t                    head;       // read position
+  size_t                    queued;     // bytes in the ring
+  // the buffer for the mixer and the ring follow
+} sts_lua_mixer__stream_t;
+
+
+typedef struct {
+  int                       index;      // the voice of the mixer or -1
+  const void                *source;    // the sample / stream which was started on it
+  unsigned int              generation; // the generation of the mixer voice when it was started
+} sts_lua_mixer__voice_t;
+
+
+typedef struct {
+  int                       type;
+  void                      *source;
+  sts_lua_mixer__voice_t    *voice;
+  float                     gain, pitch, pan;
+} sts_lua_mixer__command_t;
+
+
+typedef struct {
+  int                       count;
+  int                       capacity;
+  // the commands follow
+} sts_lua_mixer__batch_t;
+
+
+// the context is stored in the registry with the address of this variable as key
+static const char sts_lua_mixer__key = 0;
+
+
+static sts_lua_mixer__context_t *sts_lua_mixer__getcontext(lua_State *L) {
+  sts_lua_mixer__context_t *context;
+  lua_rawgetp(L, LUA_REGISTRYINDEX, &sts_lua_mixer__key);
+  context = (sts_lua_mixer__context_t*)lua_touserdata(L, -1);
+  lua_pop(L, 1);
+  return context;
+}
+
+
+static void sts_lua_mixer__lock(sts_lua_mixer__context_t *context, int lock) {
+  if (context->lock) context->lock(context->userdata, lock);
+}
+
+
+static int sts_lua_mixer__bytes(int format) {
+  switch (format) {
+    case STS_MIXER_SAMPLE_FORMAT_8:     return 1;
+    case STS_MIXER_SAMPLE_FORMAT_16:    return 2;
+    case STS_MIXER_SAMPLE_FORMAT_32:    return 4;
+    case STS_MIXER_SAMPLE_FORMAT_FLOAT: return 4;
+    default:                            return 0;
+  }
+}
+
+
+// is the voice still playing what it was started with? (the generation changes when the mixer voice is started again)
+static int sts_lua_mixer__isplaying(sts_mixer_t *mixer, sts_lua_mixer__voice_t *voice) {
+  sts_mixer_voice_t *v;
+
+  if (voice->index < 0 || !voice->source) return 0;
+  v = &mixer->voices[voice->index];
+  // the voice states are private to the mixer implementation, a stopped voice has neither sample nor stream
+  if ((!v->sample && !v->stream) || v->generation != voice->generation) return 0;
+  return (const void*)v->sample == voice->source || (const void*)v->stream == voice->source;
+}
+
+
+// the mixer calls this from the audio thread (with the lock held) when the stream buffer is used up
+static void sts_lua_mixer__refill(sts_mixer_sample_t *sample, void *userdata) {
+  sts_lua_mixer__stream_t *stream = (sts_lua_mixer__stream_t*)userdata;
+  unsigned char           *out = (unsigned char*)sample->data;
+  size_t                  size = (size_t)sample->length * (size_t)sts_lua_mixer__bytes(sample->audio_format);
+  size_t                  n, chunk;
+
+  n = stream->queued < size ? stream->queued : size;
+  stream->queued -= n;
+  while (n > 0) {
+    chunk = stream->capacity - stream->head;
+    if (chunk > n) chunk = n;
+    memcpy(out, stream->ring + stream->head, chunk);
+    stream->head = (stream->head + chunk) % stream->capacity;
+    out += chunk;
+    size -= chunk;
+    n -= chunk;
+  }
+  // not enough data, play silence
+  memset(out, 0, size);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  samples
+//
+static int sts_lua_mixer__sample_gc(lua_State *L) {
+  sts_lua_mixer__sample_t *sample = (sts_lua_mixer__sample_t*)lua_touserdata(L, 1);
+  // make sure no voice uses the data anymore
+  sts_lua_mixer__lock(sample->context, 1);
+  sts_mixer_stop_sample(sample->context->mixer, &sample->sample);
+  sts_lua_mixer__lock(sample->context, 0);
+  return 0;
+}
+
+
+static int sts_lua_mixer__sample_length(lua_State *L) {
+  sts_lua_mixer__sample_t *sample = (sts_lua_mixer__sample_t*)sts_lua_checkobject(L, 1, sts_lua_mixer__getcontext(L)->sample_ref);
+  lua_pushnumber(L, (lua_Number)sample->sample.length / (lua_Number)sample->sample.frequency);
+  return 1;
+}
+
+
+static const luaL_Reg sts_lua_mixer__sample_funcs[] = {
+  { "__gc", sts_lua_mixer__sample_gc },
+  { "length", sts_lua_mixer__sample_length },
+  { NULL, NULL }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  streams
+//
+static int sts_lua_mixer__stream_gc(lua_State *L) {
+  sts_lua_mixer__stream_t *stream = (sts_lua_mixer__stream_t*)lua_touserdata(L, 1);
+  sts_lua_mixer__lock(stream->context, 1);
+  sts_mixer_stop_stream(stream->context->mixer, &stream->stream);
+  sts_lua_mixer__lock(stream->context, 0);
+  return 0;
+}
+
+
+// stream:write(data) queues stereo PCM data, returns the amount of accepted bytes (whole frames only)
+static int sts_lua_mixer__stream_write(lua_State *L) {
+  sts_lua_mixer__context_t  *context = sts_lua_mixer__getcontext(L);
+  sts_lua_mixer__stream_t   *stream = (sts_lua_mixer__stream_t*)sts_lua_checkobject(L, 1, context->stream_ref);
+  size_t                    len, n, pos, chunk, frame = 2 * (size_t)sts_lua_mixer__bytes(stream->stream.sample.audio_format);
+  const char                *data = luaL_checklstring(L, 2, &len);
+
+  sts_lua_mixer__lock(context, 1);
+  n = stream->capacity - stream->queued;
+  if (n > len) n = len;
+  n -= n % frame;
+  pos = (stream->head + stream->queued) % stream->capacity;
+  stream->queued += n;
+  for (len = n; len > 0; len -= chunk, data += chunk) {
+    chunk = stream->capacity - pos;
+    if (chunk > len) chunk = len;
+    memcpy(stream->ring + pos, data, chunk);
+    pos = (pos + chunk) % stream->capacity;
+  }
+  sts_lua_mixer__lock(context, 0);
+  lua_pushinteger(L, (lua_Integer)n);
+  return 1;
+}
+
+
+// stream:space() returns the amount of bytes stream:write would accept
+static int sts_lua_mixer__stream_space(lua_State *L) {
+  sts_lua_mixer__context_t  *context = sts_lua_mixer__getcontext(L);
+  sts_lua_mixer__stream_t   *stream = (sts_lua_mixer__stream_t*)sts_lua_checkobject(L, 1, context->stream_ref);
+  size_t                    space;
+
+  sts_lua_mixer__lock(context, 1);
+  space = stream->capacity - stream->queued;
+  sts_lua_mixer__lock(context, 0);
+  lua_pushinteger(L, (lua_Integer)space);
+  return 1;
+}
+
+
+static const luaL_Reg sts_lua_mixer__stream_funcs[] = {
+  { "__gc", sts_lua_mixer__stream_gc },
+  { "write", sts_lua_mixer__stream_write },
+  { "space", sts_lua_mixer__stream_space },
+  { NULL, NULL }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  voices
+//
+static int sts_lua_mixer__voice_playing(lua_State *L) {
+  sts_lua_mixer__context_t  *context = sts_lua_mixer__getcontext(L);
+  sts_lua_mixer__voice_t    *voice = (sts_lua_mixer__voice_t*)sts_lua_checkobject(L, 1, context->voice_ref);
+  int                       playing;
+
+  sts_lua_mixer__lock(context, 1);
+  playing = sts_lua_mixer__isplaying(context->mixer, voice);
+  sts_lua_mixer__lock(context, 0);
+  lua_pushboolean(L, playing);
+  return 1;
+}
+
+
+static int sts_lua_mixer__voice_stop(lua_State *L) {
+  sts_lua_mixer__context_t  *context = sts_lua_mixer__getcontext(L);
+  sts_lua_mixer__voice_t    *voice = (sts_lua_mixer__voice_t*)sts_lua_checkobject(L, 1, context->voice_ref);
+
+  sts_lua_mixer__lock(context, 1);
+  if (sts_lua_mixer__isplaying(context->mixer, voice)) sts_mixer_stop_voice(context->mixer, voice->index);
+  sts_lua_mixer__lock(context, 0);
+  voice->index = -1;
+  voice->source = NULL;
+  return 0;
+}
+
+
+static int sts_lua_mixer__voice_set(lua_State *L) {
+  sts_lua_mixer__context_t  *context = sts_lua_mixer__getcontext(L);
+  sts_lua_mixer__voice_t    *voice = (sts_lua_mixer__voice_t*)sts_lua_checkobject(L, 1, context->voice_ref);
+  float                     gain = (float)luaL_checknumber(L, 2);
+  float                     pitch = (float)luaL_optnumber(L, 3, 1.0);
+  float                     pan = (float)luaL_optnumber(L, 4, 0.0);
+
+  sts_lua_mixer__lock(context, 1);
+  if (sts_lua_mixer__isplaying(context->mixer, voice)) sts_mixer_set_voice(context->mixer, voice->index, gain, pitch, pan);
+  sts_lua_mixer__lock(context, 0);
+  return 0;
+}
+
+
+static const luaL_Reg sts_lua_mixer__voice_funcs[] = {
+  { "playing", sts_lua_mixer__voice_playing },
+  { "stop", sts_lua_mixer__voice_stop },
+  { "set", sts_lua_mixer__voice_set },
+  { NULL, NULL }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  batches
+//
+// adds a command, the objects it uses are kept alive in the uservalue of the batch until it is submitted
+static sts_lua_mixer__command_t *sts_lua_mixer__addcommand(lua_State *L, sts_lua_mixer__batch_t *batch, int type, int source, int voice) {
+  sts_lua_mixer__command_t *command;
+
+  if (batch->count >= batch->capacity) luaL_error(L, "batch is full (%d commands)", batch->capacity);
+  command = (sts_lua_mixer__command_t*)(batch + 1) + batch->count++;
+  memset(command, 0, sizeof(sts_lua_mixer__command_t));
+  command->type = type;
+  lua_getuservalue(L, 1);
+  lua_pushvalue(L, source);
+  lua_rawseti(L, -2, 2 * batch->count - 1);
+  if (voice > 0) {
+    lua_pushvalue(L, voice);
+    lua_rawseti(L, -2, 2 * batch->count);
+  }
+  lua_pop(L, 1);
+  return command;
+}
+
+
+// batch:play(sample, gain, pitch, pan [, voice])
+static int sts_lua_mixer__batch_play(lua_State *L) {
+  sts_lua_mixer__context_t  *context = sts_lua_mixer__getcontext(L);
+  sts_lua_mixer__batch_t    *batch = (sts_lua_mixer__batch_t*)sts_lua_checkobject(L, 1, context->batch_ref);
+  sts_lua_mixer__sample_t   *sample = (sts_lua_mixer__sample_t*)sts_lua_checkobject(L, 2, context->sample_ref);
+  sts_lua_mixer__voice_t    *voice = lua_isnoneornil(L, 6) ? NULL : (sts_lua_mixer__voice_t*)sts_lua_checkobject(L, 6, context->voice_ref);
+  sts_lua_mixer__command_t  *command;
+  float                     gain = (float)luaL_optnumber(L, 3, 1.0);
+  float                     pitch = (float)luaL_optnumber(L, 4, 1.0);
+  float                     pan = (float)luaL_optnumber(L, 5, 0.0);
+
+  command = sts_lua_mixer__addcommand(L, batch, STS_LUA_MIXER__PLAY, 2, voice ? 6 : 0);
+  command->source = &sample->sample;
+  command->voice = voice;
+  command->gain = gain;
+  command->pitch = pitch;
+  command->pan = pan;
+  return 0;
+}
+
+
+// batch:stream(stream, gain [, voice])
+static int sts_lua_mixer__batch_stream(lua_State *L) {
+  sts_lua_mixer__context_t  *context = sts_lua_mixer__getcontext(L);
+  sts_lua_mixer__batch_t    *batch = (sts_lua_mixer__batch_t*)sts_lua_checkobject(L, 1, context->batch_ref);
+  sts_lua_mixer__stream_t   *stream = (sts_lua_mixer__stream_t*)sts_lua_checkobject(L, 2, context->stream_ref);
+  sts_lua_mixer__voice_t    *voice = lua_isnoneornil(L, 4) ? NULL : (sts_lua_mixer__voice_t*)sts_lua_checkobject(L, 4, context->voice_ref);
+  sts_lua_mixer__command_t  *command;
+  float                     gain = (float)luaL_optnumber(L, 3, 1.0);
+
+  command = sts_lua_mixer__addcommand(L, batch, STS_LUA_MIXER__STREAM, 2, voice ? 4 : 0);
+  command->source = &stream->stream;
+  command->voice = voice;
+  command->gain = gain;
+  return 0;
+}
+
+
+// batch:stop(voice)
+static int sts_lua_mixer__batch_stop(lua_State *L) {
+  sts_lua_mixer__context_t  *context = sts_lua_mixer__getcontext(L);
+  sts_lua_mixer__batch_t    *batch = (sts_lua_mixer__batch_t*)sts_lua_checkobject(L, 1, context->batch_ref);
+  sts_lua_mixer__voice_t    *voice = (sts_lua_mixer__voice_t*)sts_lua_checkobject(L, 2, context->voice_ref);
+
+  sts_lua_mixer__addcommand(L, batch, STS_LUA_MIXER__STOP, 2, 0)->voice = voice;
+  return 0;
+}
+
+
+// batch:set(voice, gain, pitch, pan)
+static int sts_lua_mixer__batch_set(lua_State *L) {
+  sts_lua_mixer__context_t  *context = sts_lua_mixer__getcontext(L);
+  sts_lua_mixer__batch_t    *batch = (sts_lua_mixer__batch_t*)sts_lua_checkobject(L, 1, context->batch_ref);
+  sts_lua_mixer__voice_t    *voice = (sts_lua_mixer__voice_t*)sts_lua_checkobject(L, 2, context->voice_ref);
+  sts_lua_mixer__command_t  *command;
+  float                     gain = (float)luaL_checknumber(L, 3);
+  float                     pitch = (float)luaL_optnumber(L, 4, 1.0);
+  float                     pan = (float)luaL_optnumber(L, 5, 0.0);
+
+  command = sts_lua_mixer__addcommand(L, batch, STS_LUA_MIXER__SET, 2, 0);
+  command->voice = voice;
+  command->gain = gain;
+  command->pitch = pitch;
+  command->pan = pan;
+  return 0;
+}
+
+
+static int sts_lua_mixer__batch_count(lua_State *L) {
+  sts_lua_mixer__batch_t *batch = (sts_lua_mixer__batch_t*)sts_lua_checkobject(L, 1, sts_lua_mixer__getcontext(L)->batch_ref);
+  lua_pushinteger(L, batch->count);
+  return 1;
+}
+
+
+static void sts_lua_mixer__clearbatch(lua_State *L, int idx, sts_lua_mixer__batch_t *batch) {
+  int i;
+  lua_getuservalue(L, idx);
+  for (i = 1; i <= 2 * batch->count; ++i) {
+    lua_pushnil(L);
+    lua_rawseti(L, -2, i);
+  }
+  lua_pop(L, 1);
+  batch->count = 0;
+}
+
+
+static int sts_lua_mixer__batch_clear(lua_State *L) {
+  sts_lua_mixer__batch_t *batch = (sts_lua_mixer__batch_t*)sts_lua_checkobject(L, 1, sts_lua_mixer__getcontext(L)->batch_ref);
+  sts_lua_mixer__clearbatch(L, 1, batch);
+  return 0;
+}
+
+
+static const luaL_Reg sts_lua_mixer__batch_funcs[] = {
+  { "play", sts_lua_mixer__batch_play },
+  { "stream", sts_lua_mixer__batch_stream },
+  { "stop", sts_lua_mixer__batch_stop },
+  { "set", sts_lua_mixer__batch_set },
+  { "count", sts_lua_mixer__batch_count },
+  { "clear", sts_lua_mixer__batch_clear },
+  { NULL, NULL }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  module functions (the context is upvalue 1)
+//
+#define STS_LUA_MIXER__CONTEXT(L)   ((sts_lua_mixer__context_t*)lua_touserdata(L, lua_upvalueindex(1)))
+
+
+// mixer.sample(format, frequency, data) creates a sample from mono PCM data
+static int sts_lua_mixer__newsample(lua_State *L) {
+  sts_lua_mixer__context_t  *context = STS_LUA_MIXER__CONTEXT(L);
+  sts_lua_mixer__sample_t   *sample;
+  int                       format = sts_lua_checkint(L, 1), bytes = sts_lua_mixer__bytes(format);
+  int                       frequency = sts_lua_checkint(L, 2);
+  size_t                    len;
+  const char                *data = luaL_checklstring(L, 3, &len);
+
+  luaL_argcheck(L, bytes > 0, 1, "unknown format");
+  luaL_argcheck(L, frequency > 0, 2, "frequency has to be positive");
+  sample = (sts_lua_mixer__sample_t*)sts_lua_newobjectref(L, context->sample_ref, sizeof(sts_lua_mixer__sample_t) + len);
+  sample->context = context;
+  sample->sample.length = (unsigned int)(len / (size_t)bytes);
+  sample->sample.frequency = (unsigned int)frequency;
+  sample->sample.audio_format = format;
+  sample->sample.data = sample + 1;
+  memcpy(sample + 1, data, len);
+  return 1;
+}
+
+
+// mixer.stream(format, frequency, frames [, queue]) creates a stream, which gets refilled with frames stereo frames
+// from a queue of "queue" frames (default 4 * frames)
+static int sts_lua_mixer__newstream(lua_State *L) {
+  sts_lua_mixer__context_t  *context = STS_LUA_MIXER__CONTEXT(L);
+  sts_lua_mixer__stream_t   *stream;
+  int                       format = sts_lua_checkint(L, 1), bytes = sts_lua_mixer__bytes(format);
+  int                       frequency = sts_lua_checkint(L, 2);
+  int                       frames = sts_lua_checkint(L, 3);
+  int                       queue = (int)luaL_optinteger(L, 4, 4 * (lua_Integer)frames);
+  size_t                    buffer;
+
+  luaL_argcheck(L, bytes > 0, 1, "unknown format");
+  luaL_argcheck(L, frequency > 0, 2, "frequency has to be positive");
+  luaL_argcheck(L, frames > 0, 3, "frames have to be positive");
+  luaL_argcheck(L, queue > 0, 4, "queue has to be positive");
+  buffer = (size_t)frames * 2 * (size_t)bytes;
+  stream = (sts_lua_mixer__stream_t*)sts_lua_newobjectref(L, context->stream_ref,
+                                                          sizeof(sts_lua_mixer__stream_t) + buffer + (size_t)queue * 2 * (size_t)bytes);
+  memset(stream, 0, sizeof(sts_lua_mixer__stream_t) + buffer);
+  stream->context = context;
+  stream->stream.userdata = stream;
+  stream->stream.callback = sts_lua_mixer__refill;
+  stream->stream.sample.length = (unsigned int)frames * 2;
+  stream->stream.sample.frequency = (unsigned int)frequency;
+  stream->stream.sample.audio_format = format;
+  stream->stream.sample.data = stream + 1;
+  stream->ring = (unsigned char*)(stream + 1) + buffer;
+  stream->capacity = (size_t)queue * 2 * (size_t)bytes;
+  return 1;
+}
+
+
+// mixer.voice() creates a voice handle, which gets bound by play / stream commands
+static int sts_lua_mixer__newvoice(lua_State *L) {
+  sts_lua_mixer__voice_t *voice = (sts_lua_mixer__voice_t*)sts_lua_newpooledref(L, STS_LUA_MIXER__CONTEXT(L)->voice_ref, sizeof(sts_lua_mixer__voice_t));
+  voice->index = -1;
+  voice->source = NULL;
+  voice->generation = 0;
+  return 1;
+}
+
+
+// mixer.batch([capacity]) creates a command batch
+static int sts_lua_mixer__newbatch(lua_State *L) {
+  sts_lua_mixer__batch_t  *batch;
+  int                     capacity = (int)luaL_optinteger(L, 1, STS_LUA_MIXER_BATCH);
+
+  luaL_argcheck(L, capacity > 0, 1, "capacity has to be positive");
+  batch = (sts_lua_mixer__batch_t*)sts_lua_newobjectref(L, STS_LUA_MIXER__CONTEXT(L)->batch_ref,
+                                                        sizeof(sts_lua_mixer__batch_t) + (size_t)capacity * sizeof(sts_lua_mixer__command_t));
+  batch->count = 0;
+  batch->capacity = capacity;
+  lua_createtable(L, 2 * capacity, 0);
+  lua_setuservalue(L, -2);
+  return 1;
+}
+
+
+// mixer.submit(batch) applies all commands with a single lock and empties the batch, returns the amount of started voices
+static int sts_lua_mixer__submit(lua_State *L) {
+  sts_lua_mixer__context_t  *context = STS_LUA_MIXER__CONTEXT(L);
+  sts_lua_mixer__batch_t    *batch = (sts_lua_mixer__batch_t*)sts_lua_checkobject(L, 1, context->batch_ref);
+  sts_lua_mixer__command_t  *command = (sts_lua_mixer__command_t*)(batch + 1);
+  sts_mixer_t               *mixer = context->mixer;
+  int                       i, voice, started = 0;
+
+  sts_lua_mixer__lock(context, 1);
+  for (i = 0; i < batch->count; ++i, ++command) {
+    switch (command->type) {
+      case STS_LUA_MIXER__PLAY:
+      case STS_LUA_MIXER__STREAM:
+        if (command->type == STS_LUA_MIXER__PLAY) {
+          voice = sts_mixer_play_sample(mixer, (sts_mixer_sample_t*)command->source, command->gain, command->pitch, command->pan);
+        } else {
+          voice = sts_mixer_play_stream(mixer, (sts_mixer_stream_t*)command->source, command->gain);
+        }
+        if (voice >= 0) ++started;
+        if (command->voice) {
+          command->voice->index = voice;
+          command->voice->source = voice >= 0 ? command->source : NULL;
+          command->voice->generation = voice >= 0 ? mixer->voices[voice].generation : 0;
+        }
+        break;
+      case STS_LUA_MIXER__STOP:
+        if (sts_lua_mixer__isplaying(mixer, command->voice)) sts_mixer_stop_voice(mixer, command->voice->index);
+        break;
+      case STS_LUA_MIXER__SET:
+        if (sts_lua_mixer__isplaying(mixer, command->voice)) {
+          sts_mixer_set_voice(mixer, command->voice->index, command->gain, command->pitch, command->pan);
+        }
+        break;
+    }
+  }
+  sts_lua_mixer__lock(context, 0);
+  sts_lua_mixer__clearbatch(L, 1, batch);
+  lua_pushinteger(L, started);
+  return 1;
+}
+
+
+// mixer.gain([gain]) returns the global gain, changes it if given
+static int sts_lua_mixer__gain(lua_State *L) {
+  sts_lua_mixer__context_t  *context = STS_LUA_MIXER__CONTEXT(L);
+  float                     gain;
+  int                       change = !lua_isnoneornil(L, 1);
+
+  // check the argument before taking the lock, an error would leave it locked
+  if (change) gain = (float)luaL_checknumber(L, 1);
+  sts_lua_mixer__lock(context, 1);
+  if (change) context->mixer->gain = gain;
+  gain = context->mixer->gain;
+  sts_lua_mixer__lock(context, 0);
+  lua_pushnumber(L, gain);
+  return 1;
+}
+
+
+// mixer.active() returns the amount of playing voices
+static int sts_lua_mixer__active(lua_State *L) {
+  sts_lua_mixer__context_t  *context = STS_LUA_MIXER__CONTEXT(L);
+  int                       active;
+
+  sts_lua_mixer__lock(context, 1);
+  active = sts_mixer_get_active_voices(context->mixer);
+  sts_lua_mixer__lock(context, 0);
+  lua_pushinteger(L, active);
+  return 1;
+}
+
+
+static const luaL_Reg sts_lua_mixer__funcs[] = {
+  { "sample", sts_lua_mixer__newsample },
+  { "stream", sts_lua_mixer__newstream },
+  { "voice", sts_lua_mixer__newvoice },
+  { "batch", sts_lua_mixer__newbatch },
+  { "submit", sts_lua_mixer__submit },
+  { "gain", sts_lua_mixer__gain },
+  { "active", sts_lua_mixer__active },
+  { NULL, NULL }
+};
+
+
+static const sts_lua_constant_t sts_lua_mixer__consts[] = {
+  { "FORMAT_8", STS_MIXER_SAMPLE_FORMAT_8 },
+  { "FORMAT_16", STS_MIXER_SAMPLE_FORMAT_16 },
+  { "FORMAT_32", STS_MIXER_SAMPLE_FORMAT_32 },
+  { "FORMAT_FLOAT", STS_MIXER_SAMPLE_FORMAT_FLOAT },
+  { "VOICES", STS_MIXER_VOICES },
+  { NULL, 0 }
+};
+
+
+void sts_lua_openmixer(lua_State *L, sts_mixer_t *mixer, sts_lua_mixer_lock_func lock, void *userdata) {
+  sts_lua_mixer__context_t  *context;
+  const luaL_Reg            *f;
+
+  context = (sts_lua_mixer__context_t*)lua_newuserdata(L, sizeof(sts_lua_mixer__context_t));
+  context->mixer = mixer;
+  context->lock = lock;
+  context->userdata = userdata;
+  context->sample_ref = sts_lua_createmeta(L, "sts_mixer.sample", sts_lua_mixer__sample_funcs);
+  context->stream_ref = sts_lua_createmeta(L, "sts_mixer.stream", sts_lua_mixer__stream_funcs);
+  context->voice_ref = sts_lua_createmeta(L, "sts_mixer.voice", sts_lua_mixer__voice_funcs);
+  context->batch_ref = sts_lua_createmeta(L, "sts_mixer.batch", sts_lua_mixer__batch_funcs);
+  sts_lua_createpool(L, "sts_mixer.voice", STS_LUA_MIXER_VOICE_POOL);
+  // the registry keeps the context alive
+  lua_pushvalue(L, -1);
+  lua_rawsetp(L, LUA_REGISTRYINDEX, &sts_lua_mixer__key);
+
+  lua_newtable(L);
+  for (f = sts_lua_mixer__funcs; f->name != NULL; ++f) {
+    lua_pushvalue(L, -2);
+    lua_pushcclosure(L, f->func, 1);
+    lua_setfield(L, -2, f->name);
+  }
+  sts_lua_setconsts(L, sts_lua_mixer__consts);
+  lua_remove(L, -2);
+}
+#endif // STS_LUA_MIXER_IMPLEMENTATION
+/*
+  This is free and unencumbered software released into the public domain.
+
+  Anyone is free to copy, modify, publish, use, compile, sell, or
+  distribute this software, either in source code form or as a compiled
+  binary, for any purpose, commercial or non-commercial, and by any
+  means.
+
+  In jurisdictions that recognize copyright laws, the author or authors
+  of this software dedicate any and all copyright interest in the
+  software to the public domain. We make this dedication for the benefit
+  of the public at large and to the detriment of our heirs and
+  successors. We intend this dedication to be an overt act of
+  relinquishment in perpetuity of all present and future rights to this
+  software under copyright law.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+  OTHER DEALINGS IN THE SOFTWARE.
+
+  For more information, please refer to <http://unlicense.org/>
+*/
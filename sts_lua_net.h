@@ -0,0 +1,625 @@
+////////////////////////////////////////////////////////////////////////////////
+/*
+ sts_lua_net.h - v0.01 - public domain
+
+  VERSION HISTORY
+    0.01 (2026-10-19) initial version
+
+  LICENSE
+    Public domain. See "unlicense" statement at the end of this file.
+
+  ABOUT
+    Lua bindings for the sts_net.h packet API which don't create any garbage per packet.
+    Received packets are handed to Lua as a view on the ring buffer of the socket (no copy,
+    no string), and outgoing packets are written into buffer objects which can be reused.
+    Both are "sts_net.buffer" userdata with the same accessors:
+
+      buf:readu8()   buf:readi8()   buf:readu16()  buf:readi16()  buf:readu32()  buf:readi32()
+      buf:readf32()  buf:readf64()  buf:readvarint()  buf:readsvarint()  buf:readstring(n)
+      buf:writeu8(v) buf:writei8(v) ... buf:writevarint(v)  buf:writesvarint(v)  buf:writestring(s)
+      buf:writebuffer(other)                    copies the unread data of another buffer / view
+      buf:skip(n)  buf:seek(pos)  buf:tell()  buf:remaining()  buf:size()  buf:clear()  buf:tostring()
+
+    All values are little endian, varints are LEB128 (svarint is zig-zag encoded).
+    Reads advance the read position, writes append to the end (views are read only).
+
+  USAGE
+    C:
+      #include "lua.h"
+      #include "lauxlib.h"
+      #include "sts_lua_net.h"
+      ...
+      sts_lua_opennet(L);
+      lua_setglobal(L, "net");
+      ...
+      while (sts_net_receive_packet(&socket)) {
+        lua_getglobal(L, "on_packet");
+        sts_lua_pushpacket(L, &socket);           // always the same view object
+        lua_call(L, 1, 1);
+        sts_lua_sendbuffer(L, -1, &socket);       // send the buffer returned by the script
+        lua_pop(L, 1);
+        sts_lua_droppacket(L, &socket);           // the view becomes invalid
+      }
+
+    Lua:
+      local reply = net.buffer(256)               -- create once, reuse for every packet
+      function on_packet(packet)
+        local id, x, y = packet:readu16(), packet:readf32(), packet:readf32()
+        reply:clear()
+        reply:writeu16(id)
+        reply:writevarint(packet:remaining())
+        return reply
+      end
+
+    The view is reused for every packet and only valid until sts_lua_droppacket, so don't
+    keep it around. Accessing it afterwards raises an error.
+
+  DEPENDENCIES
+    sts_lua, sts_net
+
+*/
+////////////////////////////////////////////////////////////////////////////////
+#ifndef __INCLUDED__STS_LUA_NET_H__
+#define __INCLUDED__STS_LUA_NET_H__
+
+
+#include "sts_net.h"
+#include "sts_lua.h"
+
+
+// Pushes the net module table (net.buffer(capacity) creates a buffer for outgoing packets).
+void sts_lua_opennet(lua_State *L);
+
+// Returns the data of the buffer at idx (raises an error if it isn't a buffer).
+// Views with a wrapped packet return NULL, use their spans with sts_lua_tonetspans.
+const char *sts_lua_tonetbuffer(lua_State *L, int idx, int *length);
+
+// Returns the unread data of the buffer / view at idx as two spans (like sts_net_packet_t).
+void sts_lua_tonetspans(lua_State *L, int idx, sts_net_packet_t *spans);
+
+#ifndef STS_NET_NO_PACKETS
+// Pushes the view on the current packet of the socket (after sts_net_receive_packet returned non-zero).
+void sts_lua_pushpacket(lua_State *L, sts_net_socket_t *socket);
+
+// Invalidates the view and drops the packet with sts_net_drop_packet.
+void sts_lua_droppacket(lua_State *L, sts_net_socket_t *socket);
+
+// Sends the contents of the buffer at idx as a packet with sts_net_send_packet.
+int sts_lua_sendbuffer(lua_State *L, int idx, sts_net_socket_t *socket);
+#endif // STS_NET_NO_PACKETS
+
+
+#endif // __INCLUDED__STS_LUA_NET_H__
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////
+////    IMPLEMENTATION
+////
+////
+#ifdef STS_LUA_NET_IMPLEMENTATION
+#include <string.h>
+
+
+typedef struct {
+  const char  *data[2];   // the spans of the readable data (data[1] is only used by wrapped packets)
+  int         length[2];  // the length of both spans
+  int         position;   // the read position
+  int         capacity;   // the size of the storage (0 for views, which are read only)
+  int         valid;      // views are invalid while there's no packet
+  // the storage of buffers follows
+} sts_lua_net__buffer_t;
+
+
+// the registry keeps the metatable reference and the view with these keys
+static const char sts_lua_net__metakey = 0;
+static const char sts_lua_net__viewkey = 0;
+
+
+static int sts_lua_net__metaref(lua_State *L) {
+  int ref;
+  lua_rawgetp(L, LUA_REGISTRYINDEX, &sts_lua_net__metakey);
+  ref = (int)lua_tointeger(L, -1);
+  lua_pop(L, 1);
+  return ref;
+}
+
+
+static sts_lua_net__buffer_t *sts_lua_net__check(lua_State *L, int idx) {
+  sts_lua_net__buffer_t *buffer = (sts_lua_net__buffer_t*)sts_lua_checkobject(L, idx, sts_lua_net__metaref(L));
+  if (!buffer->valid) luaL_error(L, "the packet was already dropped");
+  return buffer;
+}
+
+
+static sts_lua_net__buffer_t *sts_lua_net__checkwritable(lua_State *L, int idx) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, idx);
+  if (!buffer->capacity) luaL_error(L, "packets are read only");
+  return buffer;
+}
+
+
+// copies n bytes from the read position (the data might be split into two spans)
+static void sts_lua_net__read(lua_State *L, sts_lua_net__buffer_t *buffer, void *out, int n) {
+  int position = buffer->position, first;
+
+  if (n > buffer->length[0] + buffer->length[1] - position) luaL_error(L, "read beyond the end of the buffer");
+  buffer->position += n;
+  if (position < buffer->length[0]) {
+    first = buffer->length[0] - position;
+    if (first > n) first = n;
+    memcpy(out, buffer->data[0] + position, (size_t)first);
+    out = (char*)out + first;
+    n -= first;
+    position = 0;
+  } else {
+    position -= buffer->length[0];
+  }
+  if (n > 0) memcpy(out, buffer->data[1] + position, (size_t)n);
+}
+
+
+// reserves n bytes at the end of a buffer
+static unsigned char *sts_lua_net__reserve(lua_State *L, sts_lua_net__buffer_t *buffer, int n) {
+  unsigned char *out;
+
+  if (n > buffer->capacity - buffer->length[0]) luaL_error(L, "buffer is full (%d bytes)", buffer->capacity);
+  out = (unsigned char*)(buffer + 1) + buffer->length[0];
+  buffer->length[0] += n;
+  return out;
+}
+
+
+static unsigned long long sts_lua_net__readle(lua_State *L, int n) {
+  unsigned char       bytes[8];
+  unsigned long long  value = 0;
+
+  sts_lua_net__read(L, sts_lua_net__check(L, 1), bytes, n);
+  while (n-- > 0) value = (value << 8) | bytes[n];
+  return value;
+}
+
+
+static void sts_lua_net__writele(lua_State *L, unsigned long long value, int n) {
+  unsigned char *out = sts_lua_net__reserve(L, sts_lua_net__checkwritable(L, 1), n);
+  int           i;
+
+  for (i = 0; i < n; ++i, value >>= 8) out[i] = (unsigned char)(value & 0xff);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  reading
+//
+static int sts_lua_net__readu8(lua_State *L) {
+  lua_pushinteger(L, (lua_Integer)sts_lua_net__readle(L, 1));
+  return 1;
+}
+
+
+static int sts_lua_net__readi8(lua_State *L) {
+  lua_pushinteger(L, (lua_Integer)(signed char)sts_lua_net__readle(L, 1));
+  return 1;
+}
+
+
+static int sts_lua_net__readu16(lua_State *L) {
+  lua_pushinteger(L, (lua_Integer)sts_lua_net__readle(L, 2));
+  return 1;
+}
+
+
+static int sts_lua_net__readi16(lua_State *L) {
+  lua_pushinteger(L, (lua_Integer)(short)sts_lua_net__readle(L, 2));
+  return 1;
+}
+
+
+static int sts_lua_net__readu32(lua_State *L) {
+  lua_pushinteger(L, (lua_Integer)sts_lua_net__readle(L, 4));
+  return 1;
+}
+
+
+static int sts_lua_net__readi32(lua_State *L) {
+  unsigned long long value = sts_lua_net__readle(L, 4);
+  lua_pushinteger(L, (lua_Integer)(value >= 0x80000000ULL ? (long long)value - 0x100000000LL : (long long)value));
+  return 1;
+}
+
+
+static int sts_lua_net__readf32(lua_State *L) {
+  unsigned int  bits = (unsigned int)sts_lua_net__readle(L, 4);
+  float         value;
+  memcpy(&value, &bits, sizeof(value));
+  lua_pushnumber(L, (lua_Number)value);
+  return 1;
+}
+
+
+static int sts_lua_net__readf64(lua_State *L) {
+  unsigned long long  bits = sts_lua_net__readle(L, 8);
+  double              value;
+  memcpy(&value, &bits, sizeof(value));
+  lua_pushnumber(L, (lua_Number)value);
+  return 1;
+}
+
+
+static unsigned long long sts_lua_net__readleb(lua_State *L) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, 1);
+  unsigned long long    value = 0;
+  unsigned char         byte;
+  int                   shift;
+
+  for (shift = 0; shift < 64; shift += 7) {
+    sts_lua_net__read(L, buffer, &byte, 1);
+    value |= (unsigned long long)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return value;
+  }
+  luaL_error(L, "varint is too long");
+  return 0;
+}
+
+
+static int sts_lua_net__readvarint(lua_State *L) {
+  lua_pushinteger(L, (lua_Integer)sts_lua_net__readleb(L));
+  return 1;
+}
+
+
+static int sts_lua_net__readsvarint(lua_State *L) {
+  unsigned long long value = sts_lua_net__readleb(L);
+  lua_pushinteger(L, (lua_Integer)((long long)(value >> 1) ^ -(long long)(value & 1)));
+  return 1;
+}
+
+
+// buf:readstring([n]) reads n bytes (the rest of the buffer by default) as string
+static int sts_lua_net__readstring(lua_State *L) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, 1);
+  int                   remaining = buffer->length[0] + buffer->length[1] - buffer->position;
+  lua_Integer           n = luaL_optinteger(L, 2, remaining);
+  sts_net_packet_t      spans;
+
+  luaL_argcheck(L, n >= 0, 2, "length can't be negative");
+  if (n > remaining) luaL_error(L, "read beyond the end of the buffer");
+  sts_lua_tonetspans(L, 1, &spans);
+  if (n <= spans.length[0]) {
+    lua_pushlstring(L, spans.data[0], (size_t)n);
+  } else {
+    lua_pushlstring(L, spans.data[0], (size_t)spans.length[0]);
+    lua_pushlstring(L, spans.data[1], (size_t)(n - spans.length[0]));
+    lua_concat(L, 2);
+  }
+  buffer->position += (int)n;
+  return 1;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  writing
+//
+static int sts_lua_net__writeu8(lua_State *L) {
+  sts_lua_net__writele(L, (unsigned long long)luaL_checkinteger(L, 2), 1);
+  return 0;
+}
+
+
+static int sts_lua_net__writeu16(lua_State *L) {
+  sts_lua_net__writele(L, (unsigned long long)luaL_checkinteger(L, 2), 2);
+  return 0;
+}
+
+
+static int sts_lua_net__writeu32(lua_State *L) {
+  sts_lua_net__writele(L, (unsigned long long)luaL_checkinteger(L, 2), 4);
+  return 0;
+}
+
+
+static int sts_lua_net__writef32(lua_State *L) {
+  float         value = (float)luaL_checknumber(L, 2);
+  unsigned int  bits;
+  memcpy(&bits, &value, sizeof(bits));
+  sts_lua_net__writele(L, bits, 4);
+  return 0;
+}
+
+
+static int sts_lua_net__writef64(lua_State *L) {
+  double              value = (double)luaL_checknumber(L, 2);
+  unsigned long long  bits;
+  memcpy(&bits, &value, sizeof(bits));
+  sts_lua_net__writele(L, bits, 8);
+  return 0;
+}
+
+
+static void sts_lua_net__writeleb(lua_State *L, unsigned long long value) {
+  unsigned char bytes[10];
+  int           n = 0;
+
+  do {
+    bytes[n] = (unsigned char)(value & 0x7f);
+    value >>= 7;
+    if (value) bytes[n] |= 0x80;
+    ++n;
+  } while (value);
+  memcpy(sts_lua_net__reserve(L, sts_lua_net__checkwritable(L, 1), n), bytes, (size_t)n);
+}
+
+
+static int sts_lua_net__writevarint(lua_State *L) {
+  sts_lua_net__writeleb(L, (unsigned long long)luaL_checkinteger(L, 2));
+  return 0;
+}
+
+
+static int sts_lua_net__writesvarint(lua_State *L) {
+  long long value = (long long)luaL_checkinteger(L, 2);
+  sts_lua_net__writeleb(L, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+  return 0;
+}
+
+
+static int sts_lua_net__writestring(lua_State *L) {
+  size_t      len;
+  const char  *s = luaL_checklstring(L, 2, &len);
+  sts_lua_net__buffer_t *buffer = sts_lua_net__checkwritable(L, 1);
+
+  if (len > (size_t)(buffer->capacity - buffer->length[0])) luaL_error(L, "buffer is full (%d bytes)", buffer->capacity);
+  memcpy(sts_lua_net__reserve(L, buffer, (int)len), s, len);
+  return 0;
+}
+
+
+// buf:writebuffer(other) appends the unread data of another buffer / packet view (without moving its read position)
+static int sts_lua_net__writebuffer(lua_State *L) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__checkwritable(L, 1);
+  sts_lua_net__buffer_t *source = sts_lua_net__check(L, 2);
+  int                   position = source->position;
+  int                   n = source->length[0] + source->length[1] - position;
+
+  luaL_argcheck(L, source != buffer, 2, "can't append a buffer to itself");
+  sts_lua_net__reserve(L, buffer, n);
+  buffer->length[0] -= n;
+  sts_lua_net__read(L, source, (char*)(buffer + 1) + buffer->length[0], n);
+  buffer->length[0] += n;
+  source->position = position;
+  return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  position / misc
+//
+static int sts_lua_net__skip(lua_State *L) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, 1);
+  lua_Integer           n = luaL_checkinteger(L, 2);
+
+  if (n < 0 || n > buffer->length[0] + buffer->length[1] - buffer->position) luaL_error(L, "read beyond the end of the buffer");
+  buffer->position += (int)n;
+  return 0;
+}
+
+
+// buf:seek(pos) sets the read position (0 is the start)
+static int sts_lua_net__seek(lua_State *L) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, 1);
+  lua_Integer           position = luaL_checkinteger(L, 2);
+
+  luaL_argcheck(L, position >= 0 && position <= buffer->length[0] + buffer->length[1], 2, "position is out of range");
+  buffer->position = (int)position;
+  return 0;
+}
+
+
+static int sts_lua_net__tell(lua_State *L) {
+  lua_pushinteger(L, sts_lua_net__check(L, 1)->position);
+  return 1;
+}
+
+
+static int sts_lua_net__remaining(lua_State *L) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, 1);
+  lua_pushinteger(L, buffer->length[0] + buffer->length[1] - buffer->position);
+  return 1;
+}
+
+
+static int sts_lua_net__size(lua_State *L) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, 1);
+  lua_pushinteger(L, buffer->length[0] + buffer->length[1]);
+  return 1;
+}
+
+
+static int sts_lua_net__clear(lua_State *L) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__checkwritable(L, 1);
+  buffer->length[0] = 0;
+  buffer->position = 0;
+  return 0;
+}
+
+
+// buf:tostring() returns all data (ignoring the read position) as string
+static int sts_lua_net__tostring(lua_State *L) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, 1);
+  lua_pushlstring(L, buffer->data[0], (size_t)buffer->length[0]);
+  if (buffer->length[1] > 0) {
+    lua_pushlstring(L, buffer->data[1], (size_t)buffer->length[1]);
+    lua_concat(L, 2);
+  }
+  return 1;
+}
+
+
+static const luaL_Reg sts_lua_net__buffer_funcs[] = {
+  { "readu8", sts_lua_net__readu8 },
+  { "readi8", sts_lua_net__readi8 },
+  { "readu16", sts_lua_net__readu16 },
+  { "readi16", sts_lua_net__readi16 },
+  { "readu32", sts_lua_net__readu32 },
+  { "readi32", sts_lua_net__readi32 },
+  { "readf32", sts_lua_net__readf32 },
+  { "readf64", sts_lua_net__readf64 },
+  { "readvarint", sts_lua_net__readvarint },
+  { "readsvarint", sts_lua_net__readsvarint },
+  { "readstring", sts_lua_net__readstring },
+  // the signed writes are the same as the unsigned ones (only the lower bytes get written)
+  { "writeu8", sts_lua_net__writeu8 },
+  { "writei8", sts_lua_net__writeu8 },
+  { "writeu16", sts_lua_net__writeu16 },
+  { "writei16", sts_lua_net__writeu16 },
+  { "writeu32", sts_lua_net__writeu32 },
+  { "writei32", sts_lua_net__writeu32 },
+  { "writef32", sts_lua_net__writef32 },
+  { "writef64", sts_lua_net__writef64 },
+  { "writevarint", sts_lua_net__writevarint },
+  { "writesvarint", sts_lua_net__writesvarint },
+  { "writestring", sts_lua_net__writestring },
+  { "writebuffer", sts_lua_net__writebuffer },
+  { "skip", sts_lua_net__skip },
+  { "seek", sts_lua_net__seek },
+  { "tell", sts_lua_net__tell },
+  { "remaining", sts_lua_net__remaining },
+  { "size", sts_lua_net__size },
+  { "clear", sts_lua_net__clear },
+  { "tostring", sts_lua_net__tostring },
+  { "__len", sts_lua_net__size },
+  { NULL, NULL }
+};
+
+
+// net.buffer(capacity) creates a buffer for outgoing packets
+static int sts_lua_net__newbuffer(lua_State *L) {
+  sts_lua_net__buffer_t *buffer;
+  lua_Integer           capacity = luaL_checkinteger(L, 1);
+
+  luaL_argcheck(L, capacity > 0 && capacity <= STS_NET_PACKET_SIZE, 1, "capacity is out of range");
+  buffer = (sts_lua_net__buffer_t*)sts_lua_newobjectref(L, sts_lua_net__metaref(L), sizeof(sts_lua_net__buffer_t) + (size_t)capacity);
+  memset(buffer, 0, sizeof(sts_lua_net__buffer_t));
+  buffer->data[0] = (const char*)(buffer + 1);
+  buffer->capacity = (int)capacity;
+  buffer->valid = 1;
+  return 1;
+}
+
+
+static const luaL_Reg sts_lua_net__funcs[] = {
+  { "buffer", sts_lua_net__newbuffer },
+  { NULL, NULL }
+};
+
+
+static const sts_lua_constant_t sts_lua_net__consts[] = {
+  { "PACKET_SIZE", STS_NET_PACKET_SIZE },
+  { NULL, 0 }
+};
+
+
+void sts_lua_opennet(lua_State *L) {
+  sts_lua_net__buffer_t *view;
+
+  lua_pushinteger(L, sts_lua_createmeta(L, "sts_net.buffer", sts_lua_net__buffer_funcs));
+  lua_rawsetp(L, LUA_REGISTRYINDEX, &sts_lua_net__metakey);
+  // the view for received packets, it's reused for every packet
+  view = (sts_lua_net__buffer_t*)sts_lua_newobjectref(L, sts_lua_net__metaref(L), sizeof(sts_lua_net__buffer_t));
+  memset(view, 0, sizeof(sts_lua_net__buffer_t));
+  lua_rawsetp(L, LUA_REGISTRYINDEX, &sts_lua_net__viewkey);
+  lua_newtable(L);
+  luaL_setfuncs(L, sts_lua_net__funcs, 0);
+  sts_lua_setconsts(L, sts_lua_net__consts);
+}
+
+
+const char *sts_lua_tonetbuffer(lua_State *L, int idx, int *length) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, idx);
+  if (buffer->length[1] > 0) return NULL;
+  if (length) *length = buffer->length[0];
+  return buffer->data[0];
+}
+
+
+void sts_lua_tonetspans(lua_State *L, int idx, sts_net_packet_t *spans) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__check(L, idx);
+  int                   position = buffer->position;
+
+  if (position < buffer->length[0]) {
+    spans->data[0] = buffer->data[0] + position;
+    spans->length[0] = buffer->length[0] - position;
+    spans->data[1] = buffer->length[1] > 0 ? buffer->data[1] : NULL;
+    spans->length[1] = buffer->length[1];
+  } else {
+    spans->data[0] = buffer->data[1] ? buffer->data[1] + position - buffer->length[0] : buffer->data[0] + position;
+    spans->length[0] = buffer->length[0] + buffer->length[1] - position;
+    spans->data[1] = NULL;
+    spans->length[1] = 0;
+  }
+}
+
+
+#ifndef STS_NET_NO_PACKETS
+void sts_lua_pushpacket(lua_State *L, sts_net_socket_t *socket) {
+  sts_lua_net__buffer_t *view;
+  sts_net_packet_t      packet;
+
+  sts_net_get_packet(socket, &packet);
+  lua_rawgetp(L, LUA_REGISTRYINDEX, &sts_lua_net__viewkey);
+  view = (sts_lua_net__buffer_t*)lua_touserdata(L, -1);
+  view->data[0] = packet.data[0];
+  view->data[1] = packet.data[1];
+  view->length[0] = packet.length[0];
+  view->length[1] = packet.length[1];
+  view->position = 0;
+  view->valid = 1;
+}
+
+
+void sts_lua_droppacket(lua_State *L, sts_net_socket_t *socket) {
+  sts_lua_net__buffer_t *view;
+
+  lua_rawgetp(L, LUA_REGISTRYINDEX, &sts_lua_net__viewkey);
+  view = (sts_lua_net__buffer_t*)lua_touserdata(L, -1);
+  lua_pop(L, 1);
+  memset(view, 0, sizeof(sts_lua_net__buffer_t));
+  sts_net_drop_packet(socket);
+}
+
+
+int sts_lua_sendbuffer(lua_State *L, int idx, sts_net_socket_t *socket) {
+  sts_lua_net__buffer_t *buffer = sts_lua_net__checkwritable(L, idx);
+  return sts_net_send_packet(socket, buffer->data[0], buffer->length[0]);
+}
+#endif // STS_NET_NO_PACKETS
+#endif // STS_LUA_NET_IMPLEMENTATION
+/*
+  This is free and unencumbered software released into the public domain.
+
+  Anyone is free to copy, modify, publish, use, compile, sell, or
+  distribute this software, either in source code form or as a compiled
+  binary, for any purpose, commercial or non-commercial, and by any
+  means.
+
+  In jurisdictions that recognize copyright laws, the author or authors
+  of this software dedicate any and all copyright interest in the
+  software to the public domain. We make this dedication for the benefit
+  of the public at large and to the detriment of our heirs and
+  successors. We intend this dedication to be an overt act of
+  relinquishment in perpetuity of all present and future rights to this
+  software under copyright law.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+  OTHER DEALINGS IN THE SOFTWARE.
+
+  For more information, please refer to <http://unlicense.org/>
+*/
@@ -1,5 +1,5 @@
 ///////////////////////////////////////////////////////////////////////////////
-// sts_mixer.h - v0.01
+// sts_mixer.h - v0.02
 // written 2016 by Sebastian Steinhauer
 //
 //  LICENSE
@@ -18,6 +18,8 @@
 //    See the example at the end of the file.
 //
 //  VERSION HISTORY
+//    0.02 (2026-10-19) added sts_mixer_set_voice
+//                      added a generation counter to every voice, so handles can tell if a voice was started again
 //    0.01 (2016-05-01) initial version
 //
 #ifndef __INCLUDED__STS_MIXER_H__
@@ -89,6 +91,7 @@ typedef struct {
   float                     gain;
   float                     pitch;
   float                     pan;
+  unsigned int              generation;       // incremented every time the voice gets started
 } sts_mixer_voice_t;
 
 
@@ -129,6 +132,9 @@ int sts_mixer_play_sample(sts_mixer_t* mixer, sts_mixer_sample_t* sample, float
 // Returns the number of the voice where this stream will be played or -1 if no voice was free.
 int sts_mixer_play_stream(sts_mixer_t* mixer, sts_mixer_stream_t* stream, float gain);
 
+// Changes gain, pitch and panning of a playing voice (same ranges as sts_mixer_play_sample, pitch and panning are ignored by streams).
+void sts_mixer_set_voice(sts_mixer_t* mixer, int voice, float gain, float pitch, float pan);
+
 // Stops voice with the given voice no. You can pass the returned number of sts_mixer_play_sample / sts_mixer_play_stream here.
 void sts_mixer_stop_voice(sts_mixer_t* mixer, int voice);
 
@@ -213,7 +219,10 @@ static int sts_mixer__find_free_voice(sts_mixer_t* mixer) {
 void sts_mixer_init(sts_mixer_t* mixer, unsigned int frequency, int audio_format) {
   int i;
 
-  for (i = 0; i < STS_MIXER_VOICES; ++i) sts_mixer__reset_voice(mixer, i);
+  for (i = 0; i < STS_MIXER_VOICES; ++i) {
+    sts_mixer__reset_voice(mixer, i);
+    mixer->voices[i].generation = 0;
+  }
   mixer->frequency = frequency;
   mixer->gain = 1.0f;
   mixer->audio_format = audio_format;
@@ -248,6 +257,7 @@ int sts_mixer_play_sample(sts_mixer_t* mixer, sts_mixer_sample_t* sample, float
     voice->sample = sample;
     voice->stream = 0;
     voice->state = STS_MIXER_VOICE_PLAYING;
+    ++voice->generation;
   }
   return i;
 }
@@ -265,11 +275,21 @@ int sts_mixer_play_stream(sts_mixer_t* mixer, sts_mixer_stream_t* stream, float
     voice->sample = 0;
     voice->stream = stream;
     voice->state = STS_MIXER_VOICE_STREAMING;
+    ++voice->generation;
   }
   return i;
 }
 
 
+void sts_mixer_set_voice(sts_mixer_t* mixer, int voice, float gain, float pitch, float pan) {
+  if (voice >= 0 && voice < STS_MIXER_VOICES && mixer->voices[voice].state != STS_MIXER_VOICE_STOPPED) {
+    mixer->voices[voice].gain = gain;
+    mixer->voices[voice].pitch = sts_mixer__clamp(pitch, 0.1f, 10.0f);
+    mixer->voices[voice].pan = sts_mixer__clamp(pan * 0.5f, -0.5f, 0.5f);
+  }
+}
+
+
 void sts_mixer_stop_voice(sts_mixer_t* mixer, int voice) {
   if (voice >= 0 && voice < STS_MIXER_VOICES) sts_mixer__reset_voice(mixer, voice);
 }
@@ -1,9 +1,58 @@
 ////////////////////////////////////////////////////////////////////////////////
 /*
- sts_net.h - v0.07 - public domain
+ sts_net.h - v0.24 - public domain
  written 2017 by Sebastian Steinhauer
 
   VERSION HISTORY
+    0.24 (2026-10-19) sts_net_send_replies() flushes full send queues and keeps replies which don't fit pending
+                      connections no longer acknowledge datagram 0 before anything was received (the header got a flags byte)
+                      sts_net_accept_sockets() restores the blocking mode of the server socket
+                      added sts_net_set_socket_backlog() to change the backlog of an already listening server socket
+                      sts_net_uring_init() probes the io_uring features and opcodes instead of checking the kernel version
+                      shared rings got a second eventfd for free space, full rings no longer make socket sets spin
+                      sts_net_accept_shared_ring() closes received file descriptors if the message was invalid
+                      socket statistics are updated with relaxed atomics, added sts_net_get_socket_stats() to read them
+                      the global queue_high statistic is raised with a compare and swap loop (shards can't lower it)
+                      the compressor no longer copies the hash table of the dictionary for every packet
+                      STS_NET_FRAGMENT_SIZE is checked at compile time to fit into STS_NET_CONNECTION_MTU with all headers
+    0.23 (2026-10-19) added the dispatcher (worker pool handling packets with a serial queue per socket)
+    0.22 (2026-10-19) sts_net_open_socket() opens unix domain sockets for "unix:/path" (host for clients, service for servers)
+                      added shared memory rings (sts_net_create_shared_ring) for processes on the same machine (Linux only)
+    0.21 (2026-10-19) added the connection API (reliable ordered and unreliable sequenced messages over UDP)
+                      added sts_net_simulate_network() to test connections with packet loss and latency
+    0.20 (2026-10-19) added compressed packets (sts_net_send_compressed_packet, sts_net_create_compressed_packet_buffer)
+                      added sts_net_set_compression_dictionary() to compress with a preset dictionary
+    0.19 (2026-10-19) added file buffers (sts_net_create_file_buffer), they are sent with sendfile() on Linux and macOS
+    0.18 (2026-10-19) added the timer API (a hierarchical timer wheel with millisecond ticks)
+                      timers attached to a socket set bound the timeout of sts_net_check_socket_set() and expire in it
+    0.17 (2026-10-19) sts_net_check_socket_set() uses poll() on POSIX systems, so sockets are no longer limited by FD_SETSIZE
+                      added the loopback benchmark sts_net_bench.c
+    0.16 (2026-10-19) added traffic statistics for every socket and for all sockets (sts_net_get_stats)
+                      added latency histograms (sts_net_histogram_t), sockets can record how long buffers were queued
+    0.15 (2026-10-19) added sts_net_accept_sockets() to accept all pending connections at once (accept4 on Linux)
+                      added sts_net_accept_options_t to set TCP_NODELAY, buffer sizes and non-blocking mode when accepting
+                      added sts_net_set_backlog() to change the backlog of server sockets at runtime
+    0.14 (2026-10-19) added the resolver API (a worker thread resolves host names, results are signaled through a socket set)
+                      resolved host names are kept in a cache for STS_NET_RESOLVER_TTL seconds
+                      added sts_net_resolve_host(), sts_net_connect_address() and sts_net_set_resolve_func()
+                      sts_net_open_socket() uses the resolver cache
+    0.13 (2026-10-19) added reference counted buffers and a send queue for every socket
+                      added sts_net_broadcast() to send one buffer to many sockets without copies
+                      added sts_net_enable_zerocopy() to use MSG_ZEROCOPY on Linux
+                      sts_net_check_socket_set() sets "writable" for sockets with queued data
+    0.12 (2026-10-19) added the io_uring API (multishot accept / recv with provided buffers, batched sends) for Linux 6.0+
+    0.11 (2026-10-19) added the reactor API (sharded SO_REUSEPORT listeners with one thread per shard)
+                      the last error and the packet buffer pool are now thread local
+    0.10 (2026-10-19) added UDP sockets with sts_net_open_datagram_socket()
+                      added sts_net_recv_datagrams() / sts_net_send_datagrams() (batched with recvmmsg / sendmmsg on Linux)
+    0.09 (2026-10-19) packet buffers are borrowed from a shared pool only while data is pending
+                      packets bigger than 64 KB use a wider length prefix
+                      added sts_net_send_packet() and sts_net_trim_pool()
+                      sts_net_accept_socket() resets the remote socket
+    0.08 (2026-10-19) the packet buffer is now a ring buffer, packets are no longer moved around
+                      added sts_net_packet_t and sts_net_get_packet()
+                      sts_net_refill_packet_data() fills the ring with a single receive call
+                      fixed the ready check in sts_net_refill_packet_data()
     0.07 (2017-02-24) added checks for a valid socket in every function
                       return 0 for an empty socket set
     0.06 (2017-01-14) fixed warnings when compiling on Windows 64-bit
@@ -37,16 +86,131 @@
 #endif // STS_NET_SET_SOCKETS
 
 #ifndef STS_NET_BACKLOG
-// amount of waiting connections for a server socket
+// amount of waiting connections for a server socket (can be changed with sts_net_set_backlog)
 #define STS_NET_BACKLOG       2
 #endif // STS_NET_BACKLOG
 
+#ifndef STS_NET_DATAGRAM_BATCH
+// the maximum amount of datagrams which will be received / sent with a single system call
+#define STS_NET_DATAGRAM_BATCH  64
+#endif // STS_NET_DATAGRAM_BATCH
+
+#ifndef STS_NET_SEND_QUEUE
+// the maximum amount of buffers which can be queued for sending on a socket
+#define STS_NET_SEND_QUEUE      16
+#endif // STS_NET_SEND_QUEUE
+
+#ifndef STS_NET_ZEROCOPY_SIZE
+// sends smaller than this won't use MSG_ZEROCOPY (only if enabled with sts_net_enable_zerocopy)
+#define STS_NET_ZEROCOPY_SIZE   16384
+#endif // STS_NET_ZEROCOPY_SIZE
+
+#ifndef STS_NET_FILE_CHUNK
+// the maximum amount of bytes sent from a file buffer with a single call
+#define STS_NET_FILE_CHUNK      65536
+#endif // STS_NET_FILE_CHUNK
+
+#ifndef STS_NET_HISTOGRAM_BUCKETS
+// the amount of buckets of a latency histogram (16 buckets per power of two microseconds, covers more than an hour)
+#define STS_NET_HISTOGRAM_BUCKETS   464
+#endif // STS_NET_HISTOGRAM_BUCKETS
+
+#ifndef STS_NET_TIMER_LEVELS
+// the amount of levels of the timer wheel, every level has 64 slots and covers 64 times the time of the level below
+// (the first level has a slot for every millisecond, 6 levels cover more than 2 years)
+#define STS_NET_TIMER_LEVELS    6
+#endif // STS_NET_TIMER_LEVELS
+
+#ifndef STS_NET_CONNECTION_MTU
+// the maximum size of a datagram sent by a connection
+#define STS_NET_CONNECTION_MTU      1200
+#endif // STS_NET_CONNECTION_MTU
+
+#ifndef STS_NET_FRAGMENT_SIZE
+// reliable messages are split into fragments of this size (has to fit into STS_NET_CONNECTION_MTU with 16 bytes of headers)
+#define STS_NET_FRAGMENT_SIZE       1024
+#endif // STS_NET_FRAGMENT_SIZE
+
+#ifndef STS_NET_CONNECTION_WINDOW
+// the maximum amount of reliable messages in flight (sending and receiving)
+#define STS_NET_CONNECTION_WINDOW   64
+#endif // STS_NET_CONNECTION_WINDOW
+
+#ifndef STS_NET_CONNECTION_QUEUE
+// the maximum amount of queued unreliable messages and of received messages waiting for sts_net_receive_message
+#define STS_NET_CONNECTION_QUEUE    128
+#endif // STS_NET_CONNECTION_QUEUE
+
+#ifndef STS_NET_CONNECTION_TIMEOUT
+// a connection times out if nothing was received for this amount of seconds
+#define STS_NET_CONNECTION_TIMEOUT  10.0
+#endif // STS_NET_CONNECTION_TIMEOUT
+
+#ifndef STS_NET_CONNECTION_MIN_RTO
+// the minimal resend timeout in seconds
+#define STS_NET_CONNECTION_MIN_RTO  0.05
+#endif // STS_NET_CONNECTION_MIN_RTO
+
+#ifndef STS_NET_SHARED_RING_SIZE
+// the default size of each direction of a shared memory ring
+#define STS_NET_SHARED_RING_SIZE    (1024 * 1024)
+#endif // STS_NET_SHARED_RING_SIZE
+
+#ifndef STS_NET_RESOLVER_CACHE
+// the amount of host names kept in the resolver cache
+#define STS_NET_RESOLVER_CACHE  32
+#endif // STS_NET_RESOLVER_CACHE
+
+#ifndef STS_NET_RESOLVER_TTL
+// seconds a resolved host name stays in the resolver cache (0 disables the cache)
+#define STS_NET_RESOLVER_TTL    60
+#endif // STS_NET_RESOLVER_TTL
+
+#ifndef STS_NET_RESOLVER_ADDRESSES
+// the maximum amount of addresses kept for a host name
+#define STS_NET_RESOLVER_ADDRESSES  4
+#endif // STS_NET_RESOLVER_ADDRESSES
+
+#ifndef STS_NET_NO_THREADS
+#ifndef STS_NET_REACTOR_SHARDS
+// the maximum amount of shards (threads) of a reactor
+#define STS_NET_REACTOR_SHARDS  64
+#endif // STS_NET_REACTOR_SHARDS
+
+#ifndef STS_NET_DISPATCH_WORKERS
+// the maximum amount of worker threads of a dispatcher
+#define STS_NET_DISPATCH_WORKERS  64
+#endif // STS_NET_DISPATCH_WORKERS
+#endif // STS_NET_NO_THREADS
+
+#ifndef STS_NET_URING_BUFFERS
+// amount of receive buffers which are provided to io_uring (has to be a power of two)
+#define STS_NET_URING_BUFFERS       256
+#endif // STS_NET_URING_BUFFERS
+
+#ifndef STS_NET_URING_BUFFER_SIZE
+// size of every receive buffer provided to io_uring
+#define STS_NET_URING_BUFFER_SIZE   4096
+#endif // STS_NET_URING_BUFFER_SIZE
+
 #ifndef STS_NET_NO_PACKETS
 #ifndef STS_NET_PACKET_SIZE
 // the biggest possible size for a packet
 // note, that this size is already bigger then any MTU
+// packets bigger than 65534 bytes are possible, they will get a wider length prefix
 #define STS_NET_PACKET_SIZE   2048
 #endif // STS_NET_PACKET_SIZE
+
+#ifndef STS_NET_POOL_MIN_SIZE
+// the smallest buffer size of the packet buffer pool
+// buffer sizes are powers of two starting with this size up to STS_NET_PACKET_SIZE
+#define STS_NET_POOL_MIN_SIZE 1024
+#endif // STS_NET_POOL_MIN_SIZE
+
+#ifndef STS_NET_POOL_KEEP
+// the maximum amount of unused buffers the pool keeps for every size
+#define STS_NET_POOL_KEEP     64
+#endif // STS_NET_POOL_KEEP
 #endif // STS_NET_NO_PACKETS
 
 
@@ -54,23 +218,133 @@
 //
 //    Structures
 //
+// A reference counted buffer which can be queued on many sockets at once.
+typedef struct {
+  int   refs;           // reference counter (use sts_net_retain_buffer / sts_net_release_buffer)
+  int   length;         // length of the data
+  char* data;           // the data (NULL for file buffers)
+  int   file;           // file descriptor of a file buffer (-1 for memory buffers)
+  long long file_offset;  // offset of the data in the file
+} sts_net_buffer_t;
+
+
+#ifndef STS_NET_NO_STATS
+// Traffic statistics. Every socket has its own statistics, sts_net_get_stats returns the sum of all sockets.
+typedef struct {
+  long long bytes_in;       // received bytes
+  long long bytes_out;      // sent bytes
+  long long packets_in;     // received packets / datagrams
+  long long packets_out;    // sent packets / datagrams / queued buffers
+  long long syscalls_in;    // system calls receiving data
+  long long syscalls_out;   // system calls sending data
+  long long partial_sends;  // sends which couldn't send all the data at once
+  long long queue_high;     // the highest amount of queued buffers
+} sts_net_stats_t;
+#endif // STS_NET_NO_STATS
+
+
+// A log-linear (HDR style) histogram of latencies with a precision of about 6%.
+typedef struct {
+  int   counts[STS_NET_HISTOGRAM_BUCKETS];
+  int   total;          // amount of recorded latencies
+} sts_net_histogram_t;
+
+
 typedef struct {
   int   fd;             // socket file descriptor
   int   ready;          // flag if this socket is ready or not
   int   server;         // flag indicating if it is a server socket
+  int   datagram;       // flag indicating if it is a datagram (UDP) socket
+  int   writable;       // flag if queued data can be sent (only set for sockets with queued data)
+  int   queued;         // number of queued buffers
+  int   queue_head;     // index of the first queued buffer
+  int   queue_offset;   // amount of bytes of the first buffer which are already sent
+  sts_net_buffer_t* queue[STS_NET_SEND_QUEUE];  // buffers waiting to be sent
+  void* zerocopy;       // MSG_ZEROCOPY state (NULL if not enabled)
+  void* shared;         // shared memory ring (NULL if this is a real socket)
+  void* serial;         // serial queue of the dispatcher (NULL if no packets were dispatched)
+  sts_net_histogram_t* histogram;             // records how long buffers were queued (NULL to disable)
+  double  queue_times[STS_NET_SEND_QUEUE];    // time when the queued buffers were queued
+#ifndef STS_NET_NO_STATS
+  sts_net_stats_t stats;  // traffic statistics of this socket
+#endif // STS_NET_NO_STATS
 #ifndef STS_NET_NO_PACKETS
   int   received;       // number of bytes currently received
   int   packet_length;  // the packet size which is requested (-1 if it is still receiving the first 2 bytes)
-  char  data[STS_NET_PACKET_SIZE];  // buffer for the incoming packet
+  int   offset;         // position of the first received byte in the ring buffer
+  int   size;           // size of the ring buffer (0 if there is no buffer borrowed from the pool)
+  char* data;           // ring buffer for the incoming packets (NULL if there's no pending data)
+  int   compressed;     // flag if the current packet is compressed
+  char* unpacked;       // the decompressed current packet (NULL if the current packet isn't compressed)
+  int   unpacked_length;  // length of the decompressed packet
+  int   unpacked_size;    // size of the buffer borrowed for the decompressed packet
 #endif // STS_NET_NO_PACKETS
 } sts_net_socket_t;
 
 
+#ifndef STS_NET_NO_PACKETS
+// A received packet. The packet lives inside the ring buffer of the socket, so it might
+// wrap around the end of the buffer. In this case the packet is split into two spans.
+typedef struct {
+  const char* data[2];  // the spans of the packet data (data[1] is NULL if the packet is contiguous)
+  int         length[2];  // the length of both spans
+} sts_net_packet_t;
+#endif // STS_NET_NO_PACKETS
+
+
+// A timer. Timers are kept in a sts_net_timers_t, the structure has to stay valid while the timer is active.
+typedef struct sts_net_timer_t {
+  void*                   userdata;   // free for your own use
+  int                     expired;    // flag if this timer expired (set by sts_net_update_timers)
+  // private
+  struct sts_net_timer_t* prev;
+  struct sts_net_timer_t* next;
+  unsigned long long      expires;
+  int                     slot;
+} sts_net_timer_t;
+
+
+// A hierarchical timer wheel. Starting, stopping and expiring timers is O(1).
+typedef struct {
+  double              start;        // time when the timers were initialized
+  unsigned long long  now;          // the current tick (milliseconds since start)
+  unsigned long long  occupied[STS_NET_TIMER_LEVELS];     // bitmap of non-empty slots of every level
+  sts_net_timer_t*    slots[STS_NET_TIMER_LEVELS * 64 + 1]; // the last slot holds the expired timers
+  sts_net_timer_t*    expired_tail;
+} sts_net_timers_t;
+
+
 typedef struct {
   sts_net_socket_t* sockets[STS_NET_SET_SOCKETS];
+  sts_net_timers_t* timers;       // timers bounding the timeout of sts_net_check_socket_set (NULL if none)
 } sts_net_set_t;
 
 
+// Options applied to sockets accepted by sts_net_accept_sockets.
+typedef struct {
+  int   nodelay;        // non-zero to disable Nagle's algorithm (TCP_NODELAY)
+  int   nonblocking;    // non-zero to make the sockets non-blocking
+  int   send_buffer;    // size of the kernel send buffer (SO_SNDBUF, 0 keeps the default)
+  int   recv_buffer;    // size of the kernel receive buffer (SO_RCVBUF, 0 keeps the default)
+} sts_net_accept_options_t;
+
+
+// A socket address (IPv4 or IPv6).
+typedef struct {
+  int   length;         // length of the address (0 if there's no address)
+  char  data[128];      // the raw "struct sockaddr" data
+} sts_net_address_t;
+
+
+// A single datagram which will be received or sent by the datagram API.
+typedef struct {
+  void*             data;     // buffer for the datagram data
+  int               size;     // size of the buffer (only used for receiving)
+  int               length;   // length of the datagram
+  sts_net_address_t address;  // address of the sender / receiver (use a length of 0 to send to the connected host)
+} sts_net_datagram_t;
+
+
 // REMARK: most functions return 0 on success and -1 on error. You can get a more verbose error message
 // from sts_net_get_last_error. Functions which behave differently are the sts_net packet api and sts_net_check_socket_set.
 
@@ -102,6 +376,9 @@ int sts_net_is_socket_valid(sts_net_socket_t* socket);
 
 // Open a (TCP) socket. If you provide "host" sts_net will try to connect to a remove host.
 // Pass NULL for host and you'll have a server socket.
+// Use "unix:/path/to/socket" as host (or as service for servers) to open a unix domain socket instead
+// (not on Windows). Paths starting with '@' are in the abstract namespace on Linux, e.g. "unix:@game".
+// NOTE: resolving "host" might block, use the resolver API and sts_net_connect_address to avoid this.
 int sts_net_open_socket(sts_net_socket_t* socket, const char* host, const char* service);
 
 // Closes the socket.
@@ -110,6 +387,22 @@ void sts_net_close_socket(sts_net_socket_t* socket);
 // Try to accept a connection from the given server socket.
 int sts_net_accept_socket(sts_net_socket_t* listen_socket, sts_net_socket_t* remote_socket);
 
+// Accept all pending connections (at most "count") of the server socket with as few system calls as possible.
+// A blocking server socket is switched to non-blocking mode for the call (and back afterwards), so call this
+// when it's ready. Pass NULL for the default options. All accepted sockets are closed on exec.
+//  returns:
+//    -1  on errors
+//    >=0 amount of accepted sockets written to "remote_sockets"
+int sts_net_accept_sockets(sts_net_socket_t* listen_socket, sts_net_socket_t* remote_sockets, int count, const sts_net_accept_options_t* options);
+
+// Set the backlog (amount of waiting connections) for server sockets opened after this call.
+// Already listening sockets keep their backlog, use sts_net_set_socket_backlog for them.
+// The default is STS_NET_BACKLOG, the kernel might limit it (see SOMAXCONN).
+void sts_net_set_backlog(int backlog);
+
+// Change the backlog of a listening server socket (calls listen() again, pass 0 for the current default).
+int sts_net_set_socket_backlog(sts_net_socket_t* listen_socket, int backlog);
+
 // Send data to the socket.
 int sts_net_send(sts_net_socket_t* socket, const void* data, int length);
 
@@ -130,24 +423,367 @@ int sts_net_remove_socket_from_set(sts_net_socket_t* socket, sts_net_set_t* set)
 // Checks for activity on all sockets in the given socket set. If you want to peek for events
 // pass 0.0f to the timeout.
 // All sockets will have set the ready property to non-zero if you can read data from it,
-// or can accept connections.
+// or can accept connections. Sockets with queued buffers will have set the writable
+// property to non-zero if you can call sts_net_flush_socket.
+// If the set has timers, it will wait no longer than until the next timer expires and update the timers.
 //  returns:
 //    -1  on errors
 //     0  if there was no activity
-//    >0  amount of sockets with activity
+//    >0  amount of sockets with activity plus the amount of expired timers
 int sts_net_check_socket_set(sts_net_set_t* set, const float timeout);
 
 
+////////////////////////////////////////////////////////////////////////////////
+//
+//   Timer API
+//
+//  Timers for idle timeouts, heartbeats, resends etc. Attach the timers to a socket set and
+//  sts_net_check_socket_set will wake up when they expire, so you don't have to scan all your clients.
+//
+//  sts_net_init_timers(&timers);
+//  set.timers = &timers;
+//  client->timeout.userdata = client;
+//  sts_net_start_timer(&timers, &client->timeout, 30.0);   // restart it whenever the client sends something
+//  while (1) {
+//    sts_net_check_socket_set(&set, 1.0f);
+//    while ((timer = sts_net_next_expired_timer(&timers)) != NULL) ...disconnect timer->userdata...
+//    ...handle the sockets...
+//  }
+//
+// Initialize the timers.
+void sts_net_init_timers(sts_net_timers_t* timers);
+
+// Initialize a timer structure (it won't be active).
+void sts_net_reset_timer(sts_net_timer_t* timer);
+
+// Start the timer, it will expire after "seconds". An active timer will be restarted.
+void sts_net_start_timer(sts_net_timers_t* timers, sts_net_timer_t* timer, double seconds);
+
+// Stop the timer. It will also be removed from the expired timers.
+void sts_net_stop_timer(sts_net_timers_t* timers, sts_net_timer_t* timer);
+
+// Check if the timer is started and not expired yet.
+int sts_net_is_timer_active(sts_net_timer_t* timer);
+
+// Seconds until the next timer might expire (this might be earlier than the real expiry of the timer), or -1 if there are no timers.
+double sts_net_get_timer_delay(sts_net_timers_t* timers);
+
+// Expire all timers which are due. This is done by sts_net_check_socket_set for the timers of the set.
+// Returns the amount of timers which expired.
+int sts_net_update_timers(sts_net_timers_t* timers);
+
+// Get the next expired timer or NULL if there's none. The timer won't be active anymore.
+sts_net_timer_t* sts_net_next_expired_timer(sts_net_timers_t* timers);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//   Buffer API
+//
+//  Buffers are reference counted, so the same buffer can be queued on many sockets without
+//  copying the data. Queued buffers are sent without blocking by sts_net_flush_socket.
+//
+//  sts_net_buffer_t* buffer = sts_net_create_buffer(data, length);
+//  sts_net_broadcast(set.sockets, STS_NET_SET_SOCKETS, buffer);
+//  sts_net_release_buffer(buffer);
+//
+// Create a new buffer with a copy of "data" (pass NULL to get an uninitialized buffer). The buffer will have one reference.
+sts_net_buffer_t* sts_net_create_buffer(const void* data, int length);
+
+// Create a buffer for "length" bytes of a file starting at "offset" (pass -1 as length to use the rest of the file).
+// The data isn't read into memory, it's sent from the page cache with sendfile() on Linux and macOS.
+// The file is kept open until the buffer is released. Send files larger than 2GB in several buffers.
+// NOTE: sendfile() might raise SIGPIPE if the other side closed the connection, so ignore it with signal(SIGPIPE, SIG_IGN).
+sts_net_buffer_t* sts_net_create_file_buffer(const char* filename, long long offset, int length);
+
+// Add a reference to the buffer.
+void sts_net_retain_buffer(sts_net_buffer_t* buffer);
+
+// Remove a reference from the buffer. The buffer will be freed when there are no more references.
+void sts_net_release_buffer(sts_net_buffer_t* buffer);
+
+// Queue the buffer for sending. The socket holds a reference to the buffer until it's sent.
+int sts_net_queue_buffer(sts_net_socket_t* socket, sts_net_buffer_t* buffer);
+
+// Send as much queued data as possible without blocking.
+//  returns:
+//    -1  on errors
+//     0  if all queued data was sent
+//     1  if there's still queued data
+int sts_net_flush_socket(sts_net_socket_t* socket);
+
+// Queue the buffer on all valid (non-server) sockets of the list and flush them.
+// NULL entries will be ignored, so you can pass the sockets of a socket set.
+// Returns -1 if it failed for any socket, but it will still try all the other sockets.
+int sts_net_broadcast(sts_net_socket_t** sockets, int count, sts_net_buffer_t* buffer);
+
+// Use MSG_ZEROCOPY for sends of at least STS_NET_ZEROCOPY_SIZE bytes (Linux 4.14+).
+// The kernel will use the buffer memory directly, so buffers are kept alive until the kernel is done with them.
+int sts_net_enable_zerocopy(sts_net_socket_t* socket);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//   Statistics API
+//
+//  The statistics of a socket are updated by the thread using the socket (with relaxed atomic
+//  loads and stores), the statistics of all sockets with atomic additions. Both can be read at any
+//  time without locks, use sts_net_get_socket_stats to read the statistics of a socket from another thread.
+//  Define STS_NET_NO_STATS to remove the statistics.
+//
+//  Set the histogram of a socket to record how long buffers wait in its send queue:
+//
+//  socket.histogram = &histogram;
+//  ...
+//  printf("99%% of all buffers were sent after %f seconds\n", sts_net_get_latency(&histogram, 99.0));
+//
+#ifndef STS_NET_NO_STATS
+// Get the statistics of all sockets.
+void sts_net_get_stats(sts_net_stats_t* stats);
+
+// Get the statistics of a single socket (safe to call while another thread uses the socket).
+void sts_net_get_socket_stats(const sts_net_socket_t* socket, sts_net_stats_t* stats);
+
+// Reset the statistics of all sockets (the statistics of every socket are reset when it's opened).
+void sts_net_reset_stats();
+#endif // STS_NET_NO_STATS
+
+// Clear the histogram.
+void sts_net_reset_histogram(sts_net_histogram_t* histogram);
+
+// Record a latency (like the round trip time of a packet). Can be called from any thread.
+void sts_net_record_latency(sts_net_histogram_t* histogram, double seconds);
+
+// Get the latency in seconds which is higher than "percentile" (0 - 100) percent of all recorded latencies.
+double sts_net_get_latency(const sts_net_histogram_t* histogram, double percentile);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//   Resolver API
+//
+//  Host names are resolved by a worker thread, so the main loop won't block. Add the wakeup
+//  socket of the resolver to your socket set, it will be ready when requests are done.
+//  Resolved host names are cached (also for sts_net_open_socket), so reconnecting to the same
+//  host won't ask the system resolver again until STS_NET_RESOLVER_TTL seconds passed.
+//
+//  sts_net_start_resolver(&resolver);
+//  sts_net_add_socket_to_set(&resolver.wakeup_socket, &set);
+//  sts_net_resolve(&resolver, "example.com", "4040", NULL);
+//  while (1) {
+//    sts_net_check_socket_set(&set, 0.5f);
+//    while ((resolved = sts_net_next_resolved(&resolver)) != NULL) {
+//      if (resolved->count > 0) sts_net_connect_address(&socket, resolved->addresses, resolved->count);
+//      sts_net_free_resolved(resolved);
+//    }
+//  }
+//
+// A function resolving "host" / "service" to at most "max_addresses" addresses.
+// It has to return the amount of addresses or -1 on errors.
+typedef int (*sts_net_resolve_func)(const char* host, const char* service, sts_net_address_t* addresses, int max_addresses);
+
+// Replace the system resolver (getaddrinfo) by your own function, useful for tests.
+// Pass NULL to use the system resolver again. Don't call this while resolvers are running.
+void sts_net_set_resolve_func(sts_net_resolve_func func);
+
+// Resolve the host name (this will block if it's not cached).
+//  returns:
+//    -1  on errors
+//    >0  amount of addresses written to "addresses"
+int sts_net_resolve_host(const char* host, const char* service, sts_net_address_t* addresses, int max_addresses);
+
+// Remove all host names from the resolver cache.
+void sts_net_clear_resolver_cache();
+
+// Open a (TCP) socket connected to the first address which accepts the connection.
+int sts_net_connect_address(sts_net_socket_t* socket, const sts_net_address_t* addresses, int count);
+
+#ifndef STS_NET_NO_THREADS
+typedef struct sts_net_resolved_t {
+  struct sts_net_resolved_t*  next;       // private
+  void*                       userdata;   // the userdata given to sts_net_resolve
+  char*                       host;       // the resolved host name
+  char*                       service;    // the resolved service
+  int                         count;      // amount of addresses (-1 if the host could not be resolved)
+  sts_net_address_t           addresses[STS_NET_RESOLVER_ADDRESSES];
+} sts_net_resolved_t;
+
+typedef struct {
+  sts_net_socket_t            wakeup_socket;  // will be ready when requests are done (add it to your socket set)
+  // private
+  sts_net_socket_t            notify_socket;
+  sts_net_socket_t            request_socket;
+  sts_net_socket_t            worker_socket;
+  sts_net_resolved_t*         requests;
+  sts_net_resolved_t*         done;
+  sts_net_resolved_t*         head;
+  int                         running;
+  void*                       thread;
+} sts_net_resolver_t;
+
+// Start the worker thread of the resolver.
+int sts_net_start_resolver(sts_net_resolver_t* resolver);
+
+// Stop the worker thread and free all pending requests. Requests still in progress will be waited for.
+void sts_net_stop_resolver(sts_net_resolver_t* resolver);
+
+// Request resolving the host name. Cached host names will be done without asking the worker thread.
+int sts_net_resolve(sts_net_resolver_t* resolver, const char* host, const char* service, void* userdata);
+
+// Get the next done request or NULL if there's none.
+sts_net_resolved_t* sts_net_next_resolved(sts_net_resolver_t* resolver);
+
+// Free a request returned by sts_net_next_resolved.
+void sts_net_free_resolved(sts_net_resolved_t* resolved);
+#endif // STS_NET_NO_THREADS
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//   Datagram API
+//
+//  Datagram sockets use UDP. On Linux multiple datagrams are received / sent with a single
+//  system call (recvmmsg / sendmmsg). Those need _GNU_SOURCE, so define it or include the implementation
+//  before any system header. Define STS_NET_NO_MMSG if your C library doesn't provide them.
+//
+// Open a (UDP) socket. If you provide "host" the socket will be connected to this host,
+// so you can send datagrams without an address. Pass NULL for host to bind the socket to "service".
+int sts_net_open_datagram_socket(sts_net_socket_t* socket, const char* host, const char* service);
+
+// Receive up to "count" datagrams. Fill in data and size of every datagram before calling.
+// NOTE: this call will block until at least one datagram was received if the socket is not ready.
+//  returns:
+//    -1  on errors
+//    >0  amount of received datagrams
+int sts_net_recv_datagrams(sts_net_socket_t* socket, sts_net_datagram_t* datagrams, int count);
+
+// Send "count" datagrams.
+//  returns:
+//    -1  on errors
+//    >=0 amount of sent datagrams
+int sts_net_send_datagrams(sts_net_socket_t* socket, const sts_net_datagram_t* datagrams, int count);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//   Connection API
+//
+//  Reliable and unreliable messages over a datagram socket, without the head-of-line blocking of TCP.
+//  Every connection talks to one address. A server uses one datagram socket for all connections and
+//  passes every received datagram to the connection of its sender.
+//
+//  Datagrams start with a sequence number, the latest received remote sequence and 32 bits for the
+//  sequences before it, so every datagram acknowledges the last 33 received datagrams (a flag tells
+//  if the sender received anything yet). Reliable
+//  messages are split into fragments which are resent when their datagram wasn't acknowledged
+//  within the resend timeout (based on the measured round trip time). They are delivered in order.
+//  Unreliable messages are sent once and older ones are dropped if a newer one arrived already.
+//
+//  connection = sts_net_create_connection(&socket, &address);
+//  while (1) {
+//    sts_net_check_socket_set(&set, 0.01f);
+//    if (socket.ready) ...sts_net_recv_datagrams and sts_net_process_datagram for each...
+//    while ((message = sts_net_receive_message(connection, &channel)) != NULL) {
+//      ...use message->data and message->length...
+//      sts_net_release_buffer(message);
+//    }
+//    sts_net_send_message(connection, STS_NET_UNRELIABLE, &position, sizeof(position));
+//    if (sts_net_update_connection(connection) < 0) ...disconnected...
+//  }
+//
+enum {
+  STS_NET_UNRELIABLE,         // unreliable sequenced messages
+  STS_NET_RELIABLE            // reliable ordered messages
+};
+
+
+typedef struct sts_net_connection_t sts_net_connection_t;
+
+
+typedef struct {
+  float     rtt;              // smoothed round trip time in seconds
+  float     rto;              // resend timeout in seconds
+  int       pending;          // reliable messages waiting for their acknowledgment
+  long long sent;             // sent datagrams
+  long long received;         // received datagrams
+  long long resent;           // fragments which were sent again
+  long long dropped;          // datagrams dropped by the network simulation
+} sts_net_connection_info_t;
+
+
+// Create a connection to "address" over the datagram socket (pass NULL if the socket is connected).
+// The socket has to stay open while the connection is used.
+sts_net_connection_t* sts_net_create_connection(sts_net_socket_t* socket, const sts_net_address_t* address);
+
+// Free the connection and all pending messages.
+void sts_net_destroy_connection(sts_net_connection_t* connection);
+
+// Queue a message on the channel (STS_NET_RELIABLE or STS_NET_UNRELIABLE), it's sent by sts_net_update_connection.
+// Reliable messages can have up to 255 * STS_NET_FRAGMENT_SIZE bytes, unreliable ones STS_NET_FRAGMENT_SIZE.
+int sts_net_send_message(sts_net_connection_t* connection, int channel, const void* data, int length);
+
+// Process a datagram received from the address of the connection.
+int sts_net_process_datagram(sts_net_connection_t* connection, const void* data, int length);
+
+// Get the next received message or NULL if there's none. Release the buffer when you are done with it.
+sts_net_buffer_t* sts_net_receive_message(sts_net_connection_t* connection, int* channel);
+
+// Send queued messages, resend lost fragments and acknowledge received datagrams. Call it regularly (e.g. every tick).
+// Returns -1 on errors or if nothing was received for STS_NET_CONNECTION_TIMEOUT seconds.
+int sts_net_update_connection(sts_net_connection_t* connection);
+
+// Simulate a bad network for all datagrams sent by the connection. "loss" is the probability (0 - 1)
+// a datagram gets lost, every datagram is delayed by "latency" plus up to "jitter" seconds.
+void sts_net_simulate_network(sts_net_connection_t* connection, float loss, float latency, float jitter);
+
+// Get the statistics of the connection.
+void sts_net_get_connection_info(sts_net_connection_t* connection, sts_net_connection_info_t* info);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//   Shared Memory Ring API (Linux only)
+//
+//  Processes on the same machine can skip the network stack entirely. A shared ring is a pair of
+//  single producer / single consumer byte rings in shared memory. The socket's fd is an eventfd which
+//  wakes up the reader, so ring sockets work with socket sets, sts_net_send / sts_net_recv, the send
+//  queue and the packet API like normal sockets (but not with the reactor or io_uring). A second
+//  eventfd is signaled by the reader when it makes space, socket sets only wait for it while the
+//  ring is full.
+//  The memory and the eventfds are passed to the other process over a connected unix domain socket:
+//
+//    // process A                                      // process B
+//    sts_net_open_socket(&server, NULL, "unix:/tmp/x");  sts_net_open_socket(&link, "unix:/tmp/x", NULL);
+//    sts_net_accept_socket(&server, &link);              sts_net_accept_shared_ring(&ring, &link);
+//    sts_net_create_shared_ring(&ring, &link, 0);
+//
+//  The unix domain socket isn't needed afterwards. If a process crashes, the other one won't notice.
+//
+// Create a shared ring and send it over the connected unix domain socket "unix_socket".
+// "size" is the size of each direction (rounded up to a power of two), pass 0 for STS_NET_SHARED_RING_SIZE.
+int sts_net_create_shared_ring(sts_net_socket_t* socket, sts_net_socket_t* unix_socket, int size);
+
+// Receive a shared ring created by sts_net_create_shared_ring from the connected unix domain socket.
+// NOTE: this call will block until the ring was received.
+int sts_net_accept_shared_ring(sts_net_socket_t* socket, sts_net_socket_t* unix_socket);
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //   Packet API
 //
 //  Packets are an "high-level" approach to sending and receiving data.
 //  sts_net will prefix every packet with two bytes to indicate the size of the incoming data.
+//  Packets with 65535 bytes or more will get the two bytes 0xFF 0xFF followed by a four byte size.
+//  All sizes are stored in network byte order (big endian).
+//  Compressed packets always use the four byte size with the highest bit set. The data starts with the
+//  decompressed size (7 bits per byte, the highest bit marks that another byte follows) followed by LZ
+//  sequences. Compressed packets are decompressed by sts_net_receive_packet, so you don't have to care.
 //  You should create a socket set add the desired sockets to the set and call sts_net_check_socket_set regurarely.
 //
 //  sts_net_socket_set_t  client_set;
 //  sts_net_socket_t      clients[NUM_CLIENTS];
+//  sts_net_packet_t      packet;
 //
 //  ... some code here...
 //
@@ -157,12 +793,18 @@ int sts_net_check_socket_set(sts_net_set_t* set, const float timeout);
 //        ...error handling...
 //      }
 //      while (sts_net_receive_packet(clients[i]) {
-//        ...use clients[i].data and clients[i].packet_length...
+//        sts_net_get_packet(clients[i], &packet);
+//        ...use packet.data[0] / packet.length[0] and packet.data[1] / packet.length[1]...
 //        sts_net_drop_packet(clients[i]) // drop packet data
 //      }
 //    }
 //  }
 //
+//  The received data is kept in a ring buffer. One call to sts_net_refill_packet_data may
+//  receive multiple packets, which are decoded in place without moving any memory around.
+//  The ring buffer is borrowed from a shared pool and returned as soon as all received data
+//  was dropped, so idle sockets don't occupy any buffer memory.
+//
 #ifndef STS_NET_NO_PACKETS
 // try to "refill" the internal packet buffer with data
 // note that the socket has to be "ready" so use it in conjunction with a socket set
@@ -173,11 +815,298 @@ int sts_net_check_socket_set(sts_net_set_t* set, const float timeout);
 int sts_net_refill_packet_data(sts_net_socket_t* socket);
 
 // tries to "decode" the next packet in the stream
-// returns 0 when there's no packet read, non-zero if you can use socket->data and socket->packet_length
+// returns 0 when there's no packet read, non-zero if you can use sts_net_get_packet
 int sts_net_receive_packet(sts_net_socket_t* socket);
 
+// get the spans of the current packet (only valid after sts_net_receive_packet returned non-zero)
+// the spans stay valid until you call sts_net_drop_packet
+void sts_net_get_packet(sts_net_socket_t* socket, sts_net_packet_t* packet);
+
 // drops the packet after you used it
 void sts_net_drop_packet(sts_net_socket_t* socket);
+
+// sends the data as a packet (prefixed with the packet size)
+int sts_net_send_packet(sts_net_socket_t* socket, const void* data, int length);
+
+// creates a buffer holding the data as a packet (prefixed with the packet size), so it can be
+// queued on sockets or used with sts_net_broadcast
+sts_net_buffer_t* sts_net_create_packet_buffer(const void* data, int length);
+
+// like sts_net_send_packet / sts_net_create_packet_buffer, but the data is compressed
+// if the compressed packet isn't smaller, the data is sent uncompressed
+int sts_net_send_compressed_packet(sts_net_socket_t* socket, const void* data, int length);
+sts_net_buffer_t* sts_net_create_compressed_packet_buffer(const void* data, int length);
+
+// use the data as preset dictionary for compression, so even small packets compress well
+// (e.g. pass a typical packet). Only the last 65535 bytes will be used.
+// Both sides have to use the same dictionary. Pass NULL to remove the dictionary.
+// The data is not copied and has to stay valid. Set it before any packets are sent or received.
+void sts_net_set_compression_dictionary(const void* dictionary, int length);
+
+// frees all unused buffers of the packet buffer pool (also done by sts_net_shutdown)
+// the pool is thread local, so this will only free the buffers of the calling thread
+void sts_net_trim_pool();
+#endif // STS_NET_NO_PACKETS
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//   Reactor API
+//
+//  A reactor opens one listening socket per shard on the same port (using SO_REUSEPORT),
+//  so the kernel will distribute incoming connections between them. Every shard runs in its
+//  own thread with its own socket set. Shards can send messages to each other.
+//  Load balancing of incoming connections needs Linux (3.9+), the reactor is not available on Windows.
+//  Define STS_NET_NO_THREADS if you don't want any threading support in sts_net.
+//
+//  void shard_main(sts_net_shard_t* shard) {
+//    sts_net_message_t* msg;
+//    while (sts_net_is_reactor_running(shard->reactor)) {
+//      if (sts_net_check_socket_set(&shard->set, 0.5f) < 0) ...error handling...
+//      if (shard->listen_socket.ready) ...accept and add to shard->set...
+//      while ((msg = sts_net_next_message(shard)) != NULL) {
+//        ...use msg->data and msg->length...
+//        sts_net_free_message(msg);
+//      }
+//      ...handle the other sockets of shard->set...
+//    }
+//  }
+//
+//  sts_net_start_reactor(&reactor, "4040", 4, shard_main, NULL);
+//
+#ifndef STS_NET_NO_THREADS
+typedef struct sts_net_reactor_t sts_net_reactor_t;
+typedef struct sts_net_shard_t sts_net_shard_t;
+
+// The main function of a shard. It will be called in the thread of the shard
+// and should run until sts_net_is_reactor_running returns 0.
+typedef void (*sts_net_shard_func)(sts_net_shard_t* shard);
+
+typedef struct sts_net_message_t {
+  struct sts_net_message_t* next;   // private
+  int                       length; // length of the message data
+  char*                     data;   // the message data
+} sts_net_message_t;
+
+struct sts_net_shard_t {
+  int                 index;          // index of this shard
+  sts_net_reactor_t*  reactor;        // the reactor owning this shard
+  void*               userdata;       // the userdata given to sts_net_start_reactor
+  sts_net_socket_t    listen_socket;  // the listening socket of this shard (already in "set")
+  sts_net_socket_t    wakeup_socket;  // will be ready when messages arrive (already in "set")
+  sts_net_set_t       set;            // the socket set of this shard
+  // private
+  sts_net_socket_t    notify_socket;
+  sts_net_message_t*  inbox;
+  sts_net_message_t*  head;
+  void*               thread;
+  sts_net_shard_func  func;
+};
+
+struct sts_net_reactor_t {
+  int                 running;        // non-zero while the reactor is running
+  int                 num_shards;     // amount of shards
+  sts_net_shard_t     shards[STS_NET_REACTOR_SHARDS];
+};
+
+// Opens "num_shards" listening sockets on "service" and starts a thread for every shard.
+int sts_net_start_reactor(sts_net_reactor_t* reactor, const char* service, int num_shards, sts_net_shard_func func, void* userdata);
+
+// Stops all shard threads and waits for them. All sockets of the shards will be closed.
+// Don't call this from inside a shard.
+void sts_net_stop_reactor(sts_net_reactor_t* reactor);
+
+// Check if the reactor is still running. Can be called from any thread.
+int sts_net_is_reactor_running(sts_net_reactor_t* reactor);
+
+// Send a copy of the data to the given shard. Can be called from any thread.
+int sts_net_post_message(sts_net_reactor_t* reactor, int shard, const void* data, int length);
+
+// Get the next message for this shard or NULL if there's none.
+// Only call this from the thread of the shard.
+sts_net_message_t* sts_net_next_message(sts_net_shard_t* shard);
+
+// Free a message returned by sts_net_next_message.
+void sts_net_free_message(sts_net_message_t* message);
+#endif // STS_NET_NO_THREADS
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//   Dispatcher API
+//
+//  The dispatcher moves the handling of packets off the polling thread. The polling thread receives
+//  packets as usual and hands them to a pool of worker threads with sts_net_dispatch_packets. Every
+//  socket has its own serial queue, so the packets of a socket are handled one after another in the
+//  order they arrived, while packets of different sockets are handled in parallel. Idle workers steal
+//  queues from busy ones. Handlers reply with sts_net_reply, the replies are queued on the sockets by
+//  sts_net_send_replies on the polling thread. Replies which don't fit into the send queue of their
+//  socket stay pending (dispatcher.pending) until the socket was flushed.
+//
+//  void handle_packet(sts_net_job_t* job) {
+//    ...decode job->data / job->length (don't touch job->socket, it belongs to the polling thread)...
+//    sts_net_reply(job, answer, answer_length);
+//  }
+//
+//  sts_net_start_dispatcher(&dispatcher, 4, handle_packet, NULL);
+//  sts_net_add_socket_to_set(&dispatcher.wakeup_socket, &set);
+//  while (1) {
+//    sts_net_check_socket_set(&set, 0.5f);
+//    ...for every ready client: sts_net_refill_packet_data(client) and sts_net_dispatch_packets(&dispatcher, client)...
+//    if (dispatcher.wakeup_socket.ready || dispatcher.pending > 0) sts_net_send_replies(&dispatcher);
+//  }
+//
+#if !defined(STS_NET_NO_THREADS) && !defined(STS_NET_NO_PACKETS)
+typedef struct sts_net_dispatcher_t sts_net_dispatcher_t;
+
+typedef struct sts_net_job_t {
+  struct sts_net_job_t* next;         // private
+  sts_net_dispatcher_t* dispatcher;   // the dispatcher running this job
+  sts_net_socket_t*     socket;       // the socket which received the packet (only use it to identify the connection)
+  void*                 serial;       // private
+  int                   length;       // length of the packet
+  char*                 data;         // the packet data
+} sts_net_job_t;
+
+// Handles a packet, called from a worker thread.
+typedef void (*sts_net_job_func)(sts_net_job_t* job);
+
+typedef struct {
+  sts_net_dispatcher_t* dispatcher;
+  int                   index;
+  void*                 lock;
+  void*                 first;        // queues waiting for this worker (oldest first)
+  void*                 last;
+  int                   sleeping;
+  sts_net_socket_t      wakeup_socket;
+  sts_net_socket_t      notify_socket;
+  void*                 thread;
+} sts_net_worker_t;
+
+struct sts_net_dispatcher_t {
+  sts_net_socket_t      wakeup_socket;  // will be ready when handlers replied (add it to your socket set)
+  void*                 userdata;       // the userdata given to sts_net_start_dispatcher
+  int                   pending;        // amount of replies waiting for space in the send queue of their socket
+  // private
+  sts_net_socket_t      notify_socket;
+  sts_net_job_func      func;
+  int                   running;
+  int                   num_workers;
+  int                   next_worker;
+  void*                 replies;
+  void*                 head;           // the pending replies (oldest first)
+  sts_net_worker_t      workers[STS_NET_DISPATCH_WORKERS];
+};
+
+// Start "num_workers" worker threads which call "func" for every dispatched packet.
+int sts_net_start_dispatcher(sts_net_dispatcher_t* dispatcher, int num_workers, sts_net_job_func func, void* userdata);
+
+// Stop and join all workers. Packets which weren't handled yet and pending replies are dropped.
+void sts_net_stop_dispatcher(sts_net_dispatcher_t* dispatcher);
+
+// Hand all complete packets of the socket to the workers (call it after sts_net_refill_packet_data).
+// Only call this from the polling thread.
+//  returns:
+//    -1  on errors
+//    >=0 amount of dispatched packets
+int sts_net_dispatch_packets(sts_net_dispatcher_t* dispatcher, sts_net_socket_t* socket);
+
+// Send a packet back to the socket of the job. Call this from the handler.
+int sts_net_reply(sts_net_job_t* job, const void* data, int length);
+
+// Queue all replies on their sockets and flush them. Replies to closed sockets are dropped.
+// If the send queue of a socket is full, the socket gets flushed. Replies which still don't fit
+// are kept in order and sent by the next call, so call it again while dispatcher->pending > 0
+// (sockets with queued data will be writable in the socket set when they can take more data).
+// Only call this from the polling thread.
+//  returns:
+//    -1  on errors (the other replies are still sent)
+//    >=0 amount of queued replies
+int sts_net_send_replies(sts_net_dispatcher_t* dispatcher);
+#endif // !defined(STS_NET_NO_THREADS) && !defined(STS_NET_NO_PACKETS)
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//   io_uring API
+//
+//  On Linux 6.0+ sockets can be driven by io_uring instead of a socket set. Listening sockets
+//  get a multishot accept, connected sockets a multishot recv which picks buffers from a ring
+//  of provided buffers. Received bytes will be appended to the packet buffer of the socket, so
+//  you can use sts_net_receive_packet / sts_net_get_packet / sts_net_drop_packet as usual.
+//  Sends are queued and submitted together with the next sts_net_uring_wait call.
+//  sts_net_uring_init probes the kernel for every needed feature and opcode (and multishot recv)
+//  and fails if one is missing or io_uring is disabled, just use the socket set API then.
+//  Define STS_NET_NO_URING to remove the io_uring support.
+//
+//  if (sts_net_uring_init(&ring, 256) == 0) {
+//    sts_net_uring_accept(&ring, &server);
+//    while (1) {
+//      n = sts_net_uring_wait(&ring, events, 64, 0.5f);
+//      for (i = 0; i < n; ++i) {
+//        switch (events[i].type) {
+//          case STS_NET_URING_ACCEPT: ...sts_net_uring_accept_socket + sts_net_uring_recv...
+//          case STS_NET_URING_RECV: ...while (sts_net_receive_packet(events[i].socket))...
+//          case STS_NET_URING_CLOSED: ...sts_net_uring_cancel + sts_net_close_socket...
+//        }
+//      }
+//    }
+//  } else {
+//    ...use sts_net_check_socket_set...
+//  }
+//
+#ifndef STS_NET_NO_PACKETS
+enum {
+  STS_NET_URING_ACCEPT,     // a new connection, "result" is the file descriptor (use sts_net_uring_accept_socket)
+  STS_NET_URING_RECV,       // "result" bytes were appended to the packet buffer of the socket
+  STS_NET_URING_SEND,       // a send has finished, "result" is the amount of bytes sent
+  STS_NET_URING_CLOSED,     // the remote host closed the connection
+  STS_NET_URING_ERROR       // an operation failed, "result" is the negative error code
+};
+
+typedef struct {
+  int               type;     // one of STS_NET_URING_*
+  int               result;   // depends on the type
+  sts_net_socket_t* socket;   // the socket of this event
+} sts_net_uring_event_t;
+
+typedef struct {
+  int               fd;       // the io_uring file descriptor
+  // private
+  unsigned          sq_entries, sq_tail, sq_submitted;
+  unsigned          *sq_head_ptr, *sq_tail_ptr, *sq_mask_ptr;
+  unsigned          *cq_head_ptr, *cq_tail_ptr, *cq_mask_ptr;
+  void              *ring, *sqes, *cqes, *buffer_ring;
+  char              *buffers;
+  unsigned long     ring_size, sqes_size, buffer_ring_size;
+} sts_net_uring_t;
+
+// Initialize io_uring with the given amount of submission entries.
+// Returns -1 if io_uring (or one of the needed features) is not available.
+int sts_net_uring_init(sts_net_uring_t* ring, unsigned entries);
+
+// Shutdown the io_uring instance. This will not close any sockets.
+void sts_net_uring_shutdown(sts_net_uring_t* ring);
+
+// Start accepting connections on the server socket. Every connection will create an STS_NET_URING_ACCEPT event.
+int sts_net_uring_accept(sts_net_uring_t* ring, sts_net_socket_t* socket);
+
+// Initialize "remote_socket" with the connection of an STS_NET_URING_ACCEPT event.
+int sts_net_uring_accept_socket(const sts_net_uring_event_t* event, sts_net_socket_t* remote_socket);
+
+// Start receiving data on the socket. Every received piece of data will create an STS_NET_URING_RECV event.
+int sts_net_uring_recv(sts_net_uring_t* ring, sts_net_socket_t* socket);
+
+// Queue sending data on the socket. "data" has to stay valid until the STS_NET_URING_SEND event of this socket.
+int sts_net_uring_send(sts_net_uring_t* ring, sts_net_socket_t* socket, const void* data, int length);
+
+// Cancel all operations of a socket. Call this before closing the socket.
+// The socket structure has to stay valid until the next call of sts_net_uring_wait.
+int sts_net_uring_cancel(sts_net_uring_t* ring, sts_net_socket_t* socket);
+
+// Submit all queued operations and wait up to "timeout" seconds for events.
+//  returns:
+//    -1  on errors
+//    >=0 amount of events written to "events"
+int sts_net_uring_wait(sts_net_uring_t* ring, sts_net_uring_event_t* events, int max_events, const float timeout);
 #endif // STS_NET_NO_PACKETS
 #endif // __INCLUDED__STS_NET_H__
 
@@ -196,24 +1125,76 @@ void sts_net_drop_packet(sts_net_socket_t* socket);
 
 #ifdef STS_NET_IMPLEMENTATION
 
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // recvmmsg / sendmmsg / accept4
+#endif // _GNU_SOURCE
+#ifndef STS_NET_NO_MMSG
+#define STS_NET__MMSG
+#endif // STS_NET_NO_MMSG
+#define STS_NET__ACCEPT4
+#ifndef STS_NET_NO_SHM
+#define STS_NET__SHM
+#endif // STS_NET_NO_SHM
+#endif // __linux__
+
 #include <string.h>   // NULL and possibly memcpy, memset
 
 #ifdef _WIN32
 #include <WinSock2.h>
 #include <Ws2tcpip.h>
+#include <Windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 typedef int socklen_t;
 #pragma comment(lib, "Ws2_32.lib")
 #else
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <poll.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#ifndef STS_NET_NO_THREADS
+#include <pthread.h>
+#endif // STS_NET_NO_THREADS
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <sys/sendfile.h>
+#endif // __linux__
+#ifdef STS_NET__SHM
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif // STS_NET__SHM
 #define INVALID_SOCKET    -1
 #define SOCKET_ERROR      -1
 #define closesocket(fd)   close(fd)
+#if defined(__linux__) && !defined(STS_NET_NO_URING) && !defined(STS_NET_NO_PACKETS)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifdef IORING_RECV_MULTISHOT
+#define STS_NET__URING
+#endif // IORING_RECV_MULTISHOT
+#endif
+#if defined(__GLIBC__) && !defined(__USE_GNU)
+// the system headers were included before without _GNU_SOURCE, so we can't use recvmmsg / sendmmsg / accept4
+#undef STS_NET__MMSG
+#undef STS_NET__ACCEPT4
+#undef STS_NET__SHM
+#endif
 #endif
 
 
@@ -223,9 +1204,63 @@ typedef int socklen_t;
 #ifndef sts__memset
 #define sts__memset     memset
 #endif // sts__memset
+#ifndef sts__malloc
+#include <stdlib.h>
+#define sts__malloc     malloc
+#define sts__free       free
+#endif // sts__malloc
+
+
+// thread locals and atomics
+#ifdef STS_NET_NO_THREADS
+#define STS_NET__THREAD_LOCAL
+#define STS_NET__ADD(p, v)            (*(p) += (v))
+#define STS_NET__ADD64(p, v)          (*(p) += (v))
+#define STS_NET__LOAD64(p)            (*(p))
+#define STS_NET__STORE64(p, v)        (*(p) = (v))
+#define STS_NET__CAS64(p, o, v)       (*(p) == (o) ? (*(p) = (v), 1) : 0)
+#elif defined(_MSC_VER)
+#define STS_NET__THREAD_LOCAL         __declspec(thread)
+#define STS_NET__ADD(p, v)            (InterlockedExchangeAdd((volatile LONG*)(p), (v)) + (v))
+#define STS_NET__LOAD(p)              InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#define STS_NET__STORE(p, v)          InterlockedExchange((volatile LONG*)(p), (v))
+#define STS_NET__LOAD_PTR(p)          InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+#define STS_NET__EXCHANGE_PTR(p, v)   InterlockedExchangePointer((PVOID volatile*)(p), (v))
+#define STS_NET__CAS_PTR(p, o, v)     (InterlockedCompareExchangePointer((PVOID volatile*)(p), (v), (o)) == (o))
+#define STS_NET__ADD64(p, v)          InterlockedExchangeAdd64((volatile LONG64*)(p), (v))
+#define STS_NET__LOAD64(p)            InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#define STS_NET__STORE64(p, v)        InterlockedExchange64((volatile LONG64*)(p), (v))
+#define STS_NET__CAS64(p, o, v)       (InterlockedCompareExchange64((volatile LONG64*)(p), (v), (o)) == (o))
+#else
+#define STS_NET__THREAD_LOCAL         __thread
+#define STS_NET__ADD(p, v)            __atomic_add_fetch((p), (v), __ATOMIC_ACQ_REL)
+#define STS_NET__LOAD(p)              __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STS_NET__STORE(p, v)          __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define STS_NET__LOAD_PTR(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STS_NET__EXCHANGE_PTR(p, v)   __atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+#define STS_NET__CAS_PTR(p, o, v)     __atomic_compare_exchange_n((p), &(o), (v), 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+// statistics don't need any ordering
+#define STS_NET__ADD64(p, v)          __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define STS_NET__LOAD64(p)            __atomic_load_n((p), __ATOMIC_RELAXED)
+#define STS_NET__STORE64(p, v)        __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define STS_NET__CAS64(p, o, v)       __atomic_compare_exchange_n((p), &(o), (v), 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#endif // STS_NET_NO_THREADS
+
 
+static STS_NET__THREAD_LOCAL const char* sts_net__error_message = "";
+static int sts_net__backlog = STS_NET_BACKLOG;
 
-static const char* sts_net__error_message = "";
+
+#ifndef STS_NET_NO_STATS
+static sts_net_stats_t sts_net__stats;
+// count on the socket and for all sockets. Only the thread using the socket writes its statistics,
+// so a relaxed load and store is enough there (other threads won't see torn values).
+#define STS_NET__COUNT(socket, field, value)  do { long long v__ = (long long)(value); \
+  STS_NET__STORE64(&(socket)->stats.field, STS_NET__LOAD64(&(socket)->stats.field) + v__); \
+  (void)STS_NET__ADD64(&sts_net__stats.field, v__); } while (0)
+#else
+#define STS_NET__COUNT(socket, field, value)  do { } while (0)
+#endif // STS_NET_NO_STATS
 
 
 static int sts_net__set_error(const char* message) {
@@ -234,266 +1269,4139 @@ static int sts_net__set_error(const char* message) {
 }
 
 
-void sts_net_reset_socket(sts_net_socket_t* socket) {
-  socket->fd = INVALID_SOCKET;
-  socket->ready = 0;
-  socket->server = 0;
+// monotonic time in seconds
+static double sts_net__time() {
+#ifdef _WIN32
+  return (double)GetTickCount64() / 1000.0;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+#endif // _WIN32
+}
+
+
+void sts_net_reset_socket(sts_net_socket_t* socket) {
+  socket->fd = INVALID_SOCKET;
+  socket->ready = 0;
+  socket->server = 0;
+  socket->datagram = 0;
+  socket->writable = 0;
+  socket->queued = 0;
+  socket->queue_head = 0;
+  socket->queue_offset = 0;
+  socket->zerocopy = NULL;
+  socket->shared = NULL;
+  socket->serial = NULL;
+  socket->histogram = NULL;
+#ifndef STS_NET_NO_STATS
+  sts__memset(&socket->stats, 0, sizeof(socket->stats));
+#endif // STS_NET_NO_STATS
 #ifndef STS_NET_NO_PACKETS
   socket->received = 0;
   socket->packet_length = -1;
+  socket->offset = 0;
+  socket->size = 0;
+  socket->data = NULL;
+  socket->compressed = 0;
+  socket->unpacked = NULL;
+  socket->unpacked_length = 0;
+  socket->unpacked_size = 0;
 #endif // STS_NET_NO_PACKETS
 }
 
 
-int sts_net_is_socket_valid(sts_net_socket_t* socket) {
-  return socket->fd != INVALID_SOCKET;
-}
+int sts_net_is_socket_valid(sts_net_socket_t* socket) {
+  return socket->fd != INVALID_SOCKET;
+}
+
+
+const char *sts_net_get_last_error() {
+  return sts_net__error_message;
+}
+
+
+int sts_net_init() {
+  #ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+      return sts_net__set_error("Windows Sockets failed to start");
+    }
+    return 0;
+  #else
+    return 0;
+  #endif // _WIN32
+}
+
+
+void sts_net_shutdown() {
+  #ifndef STS_NET_NO_PACKETS
+    sts_net_trim_pool();
+  #endif // STS_NET_NO_PACKETS
+  #ifdef _WIN32
+    WSACleanup();
+  #endif // _WIN32
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Statistics
+//
+#ifndef STS_NET_NO_STATS
+static void sts_net__load_stats(const sts_net_stats_t* from, sts_net_stats_t* stats) {
+  stats->bytes_in = STS_NET__LOAD64(&from->bytes_in);
+  stats->bytes_out = STS_NET__LOAD64(&from->bytes_out);
+  stats->packets_in = STS_NET__LOAD64(&from->packets_in);
+  stats->packets_out = STS_NET__LOAD64(&from->packets_out);
+  stats->syscalls_in = STS_NET__LOAD64(&from->syscalls_in);
+  stats->syscalls_out = STS_NET__LOAD64(&from->syscalls_out);
+  stats->partial_sends = STS_NET__LOAD64(&from->partial_sends);
+  stats->queue_high = STS_NET__LOAD64(&from->queue_high);
+}
+
+
+void sts_net_get_stats(sts_net_stats_t* stats) {
+  sts_net__load_stats(&sts_net__stats, stats);
+}
+
+
+void sts_net_get_socket_stats(const sts_net_socket_t* socket, sts_net_stats_t* stats) {
+  sts_net__load_stats(&socket->stats, stats);
+}
+
+
+void sts_net_reset_stats() {
+  STS_NET__STORE64(&sts_net__stats.bytes_in, 0);
+  STS_NET__STORE64(&sts_net__stats.bytes_out, 0);
+  STS_NET__STORE64(&sts_net__stats.packets_in, 0);
+  STS_NET__STORE64(&sts_net__stats.packets_out, 0);
+  STS_NET__STORE64(&sts_net__stats.syscalls_in, 0);
+  STS_NET__STORE64(&sts_net__stats.syscalls_out, 0);
+  STS_NET__STORE64(&sts_net__stats.partial_sends, 0);
+  STS_NET__STORE64(&sts_net__stats.queue_high, 0);
+}
+#endif // STS_NET_NO_STATS
+
+
+// the first 32 buckets are exact microseconds, after that every power of two is split into 16 buckets
+static int sts_net__histogram_bucket(unsigned long micros) {
+  int shift = 0;
+  while ((micros >> shift) >= 32) ++shift;
+  return shift * 16 + (int)(micros >> shift);
+}
+
+
+void sts_net_reset_histogram(sts_net_histogram_t* histogram) {
+  sts__memset(histogram, 0, sizeof(sts_net_histogram_t));
+}
+
+
+void sts_net_record_latency(sts_net_histogram_t* histogram, double seconds) {
+  double  micros = seconds * 1000000.0;
+  int     bucket;
+
+  if (micros < 0.0) micros = 0.0;
+  if (micros > 4294967295.0) micros = 4294967295.0;
+  bucket = sts_net__histogram_bucket((unsigned long)micros);
+  if (bucket >= STS_NET_HISTOGRAM_BUCKETS) bucket = STS_NET_HISTOGRAM_BUCKETS - 1;
+  STS_NET__ADD(&histogram->counts[bucket], 1);
+  STS_NET__ADD(&histogram->total, 1);
+}
+
+
+double sts_net_get_latency(const sts_net_histogram_t* histogram, double percentile) {
+  double  wanted = (double)histogram->total * percentile / 100.0;
+  long    seen = 0;
+  int     i, shift;
+
+  if (histogram->total <= 0) return 0.0;
+  for (i = 0; i < STS_NET_HISTOGRAM_BUCKETS - 1; ++i) {
+    seen += histogram->counts[i];
+    if ((double)seen >= wanted && seen > 0) break;
+  }
+  // return the highest latency of the bucket
+  if (i < 32) return (double)i / 1000000.0;
+  shift = i / 16 - 1;
+  return (double)(((unsigned long)(i - shift * 16 + 1) << shift) - 1) / 1000000.0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Timers
+//
+#define STS_NET__TIMER_EXPIRED  (STS_NET_TIMER_LEVELS * 64)
+
+
+static unsigned long long sts_net__timer_tick(sts_net_timers_t* timers) {
+  double elapsed = sts_net__time() - timers->start;
+  return elapsed > 0.0 ? (unsigned long long)(elapsed * 1000.0) : 0;
+}
+
+
+static void sts_net__unlink_timer(sts_net_timers_t* timers, sts_net_timer_t* timer) {
+  if (timer->prev) timer->prev->next = timer->next;
+  else timers->slots[timer->slot] = timer->next;
+  if (timer->next) timer->next->prev = timer->prev;
+  else if (timer->slot == STS_NET__TIMER_EXPIRED) timers->expired_tail = timer->prev;
+  if (timer->slot < STS_NET__TIMER_EXPIRED && !timers->slots[timer->slot]) {
+    timers->occupied[timer->slot / 64] &= ~(1ULL << (timer->slot % 64));
+  }
+  timer->prev = timer->next = NULL;
+  timer->slot = -1;
+}
+
+
+// put the timer into the slot of the level which covers its expiry
+static void sts_net__link_timer(sts_net_timers_t* timers, sts_net_timer_t* timer) {
+  unsigned long long  delta = timer->expires - timers->now;
+  int                 level = 0, slot;
+
+  while (level < STS_NET_TIMER_LEVELS - 1 && delta >= (1ULL << (6 * (level + 1)))) ++level;
+  if (level == STS_NET_TIMER_LEVELS - 1 && delta >= (1ULL << (6 * STS_NET_TIMER_LEVELS - 6)) * 63) {
+    // too far away, it will be moved down when its slot is reached
+    slot = (int)(((timers->now >> (6 * level)) + 63) & 63);
+  } else {
+    slot = (int)((timer->expires >> (6 * level)) & 63);
+  }
+  timer->slot = level * 64 + slot;
+  timer->prev = NULL;
+  timer->next = timers->slots[timer->slot];
+  if (timer->next) timer->next->prev = timer;
+  timers->slots[timer->slot] = timer;
+  timers->occupied[level] |= 1ULL << slot;
+}
+
+
+void sts_net_init_timers(sts_net_timers_t* timers) {
+  sts__memset(timers, 0, sizeof(sts_net_timers_t));
+  timers->start = sts_net__time();
+}
+
+
+void sts_net_reset_timer(sts_net_timer_t* timer) {
+  timer->userdata = NULL;
+  timer->expired = 0;
+  timer->prev = timer->next = NULL;
+  timer->expires = 0;
+  timer->slot = -1;
+}
+
+
+void sts_net_start_timer(sts_net_timers_t* timers, sts_net_timer_t* timer, double seconds) {
+  unsigned long long ticks = seconds > 0.0 ? (unsigned long long)(seconds * 1000.0 + 0.999) : 0;
+
+  if (timer->slot >= 0) sts_net__unlink_timer(timers, timer);
+  // the current tick is already processed, so the earliest expiry is the next tick
+  timer->expires = sts_net__timer_tick(timers) + (ticks > 0 ? ticks : 1);
+  if (timer->expires <= timers->now) timer->expires = timers->now + 1;
+  timer->expired = 0;
+  sts_net__link_timer(timers, timer);
+}
+
+
+void sts_net_stop_timer(sts_net_timers_t* timers, sts_net_timer_t* timer) {
+  if (timer->slot >= 0) sts_net__unlink_timer(timers, timer);
+  timer->expired = 0;
+}
+
+
+int sts_net_is_timer_active(sts_net_timer_t* timer) {
+  return timer->slot >= 0 && timer->slot != STS_NET__TIMER_EXPIRED;
+}
+
+
+double sts_net_get_timer_delay(sts_net_timers_t* timers) {
+  unsigned long long  next = 0, boundary, index;
+  int                 level, distance, found = 0;
+  double              delay;
+
+  if (timers->slots[STS_NET__TIMER_EXPIRED]) return 0.0;
+  for (level = 0; level < STS_NET_TIMER_LEVELS; ++level) {
+    if (!timers->occupied[level]) continue;
+    // find the next non-empty slot of this level, the timers will expire or move down when it's reached
+    index = timers->now >> (6 * level);
+    for (distance = 1; distance <= 64; ++distance) {
+      if (timers->occupied[level] & (1ULL << ((index + distance) & 63))) break;
+    }
+    boundary = (index + distance) << (6 * level);
+    if (!found || boundary < next) next = boundary;
+    found = 1;
+  }
+  if (!found) return -1.0;
+  delay = (double)next / 1000.0 - (sts_net__time() - timers->start);
+  return delay > 0.0 ? delay : 0.0;
+}
+
+
+int sts_net_update_timers(sts_net_timers_t* timers) {
+  unsigned long long  target = sts_net__timer_tick(timers), t;
+  sts_net_timer_t     *timer, *next;
+  int                 level, top, count = 0;
+
+  while (timers->now < target) {
+    t = timers->now + 1;
+    if (!timers->occupied[0] && (t & 63) != 0) {
+      // nothing in the first level, so skip to the next slot of the second level
+      t = (timers->now | 63) + 1;
+      if (t > target) {
+        timers->now = target;
+        break;
+      }
+    }
+    timers->now = t;
+    // move the timers of the higher levels down, starting at the highest level which wrapped around
+    for (top = 0; top < STS_NET_TIMER_LEVELS - 1 && (t & ((1ULL << (6 * (top + 1))) - 1)) == 0; ++top) {}
+    for (level = top; level > 0; --level) {
+      int slot = level * 64 + (int)((t >> (6 * level)) & 63);
+      timer = timers->slots[slot];
+      timers->slots[slot] = NULL;
+      timers->occupied[level] &= ~(1ULL << (slot % 64));
+      for (; timer; timer = next) {
+        next = timer->next;
+        sts_net__link_timer(timers, timer);
+      }
+    }
+    // expire all timers of the current slot
+    while ((timer = timers->slots[t & 63]) != NULL) {
+      sts_net__unlink_timer(timers, timer);
+      timer->expired = 1;
+      timer->slot = STS_NET__TIMER_EXPIRED;
+      timer->prev = timers->expired_tail;
+      if (timers->expired_tail) timers->expired_tail->next = timer;
+      else timers->slots[STS_NET__TIMER_EXPIRED] = timer;
+      timers->expired_tail = timer;
+      ++count;
+    }
+  }
+  return count;
+}
+
+
+sts_net_timer_t* sts_net_next_expired_timer(sts_net_timers_t* timers) {
+  sts_net_timer_t* timer = timers->slots[STS_NET__TIMER_EXPIRED];
+  if (timer) sts_net__unlink_timer(timers, timer);
+  return timer;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Resolver cache
+//
+typedef struct {
+  char              host[256];
+  char              service[32];
+  double            expires;      // sts_net__time when this entry expires (0 if unused)
+  int               count;
+  sts_net_address_t addresses[STS_NET_RESOLVER_ADDRESSES];
+} sts_net__cache_entry_t;
+
+
+static sts_net__cache_entry_t sts_net__cache[STS_NET_RESOLVER_CACHE];
+static sts_net_resolve_func   sts_net__resolve_func = NULL;
+#ifndef STS_NET_NO_THREADS
+static void*                  sts_net__cache_lock = NULL;
+#define STS_NET__LOCK_CACHE()   while (STS_NET__EXCHANGE_PTR(&sts_net__cache_lock, (void*)1) != NULL)
+#define STS_NET__UNLOCK_CACHE() (void)STS_NET__EXCHANGE_PTR(&sts_net__cache_lock, NULL)
+#else
+#define STS_NET__LOCK_CACHE()
+#define STS_NET__UNLOCK_CACHE()
+#endif // STS_NET_NO_THREADS
+
+
+static int sts_net__getaddrinfo(const char* host, const char* service, sts_net_address_t* addresses, int max_addresses) {
+  struct addrinfo hints;
+  struct addrinfo *res = NULL, *r = NULL;
+  int             count = 0;
+
+  sts__memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, service, &hints, &res) != 0) return -1;
+  for (r = res; r && count < max_addresses; r = r->ai_next) {
+    if (r->ai_addrlen > sizeof(addresses[count].data)) continue;
+    sts__memcpy(addresses[count].data, r->ai_addr, r->ai_addrlen);
+    addresses[count].length = (int)r->ai_addrlen;
+    ++count;
+  }
+  freeaddrinfo(res);
+  return count;
+}
+
+
+// find a cache entry (or a free / the oldest entry if "create" is set)
+static sts_net__cache_entry_t* sts_net__find_cache_entry(const char* host, const char* service, double now, int create) {
+  sts_net__cache_entry_t  *entry, *oldest = &sts_net__cache[0];
+  int                     i;
+
+  for (i = 0; i < STS_NET_RESOLVER_CACHE; ++i) {
+    entry = &sts_net__cache[i];
+    if (entry->expires > now && strcmp(entry->host, host) == 0 && strcmp(entry->service, service) == 0) return entry;
+    if (entry->expires < oldest->expires) oldest = entry;
+  }
+  return create ? oldest : NULL;
+}
+
+
+void sts_net_set_resolve_func(sts_net_resolve_func func) {
+  sts_net__resolve_func = func;
+  sts_net_clear_resolver_cache();
+}
+
+
+// copy the addresses of a cached host name, returns 0 if the host name is not cached
+static int sts_net__lookup_cache(const char* host, const char* service, sts_net_address_t* addresses, int max_addresses) {
+  sts_net__cache_entry_t* entry;
+  int                     count = 0;
+
+  STS_NET__LOCK_CACHE();
+  if ((entry = sts_net__find_cache_entry(host, service, sts_net__time(), 0)) != NULL) {
+    count = entry->count < max_addresses ? entry->count : max_addresses;
+    sts__memcpy(addresses, entry->addresses, sizeof(sts_net_address_t) * count);
+  }
+  STS_NET__UNLOCK_CACHE();
+  return count;
+}
+
+
+int sts_net_resolve_host(const char* host, const char* service, sts_net_address_t* addresses, int max_addresses) {
+  sts_net__cache_entry_t* entry;
+  sts_net_address_t       resolved[STS_NET_RESOLVER_ADDRESSES];
+  size_t                  host_length, service_length;
+  int                     count, cacheable;
+
+  if (!host) return sts_net__set_error("Cannot resolve without host name");
+  if (!service) service = "";
+  host_length = strlen(host) + 1;
+  service_length = strlen(service) + 1;
+  cacheable = STS_NET_RESOLVER_TTL > 0 && host_length <= sizeof(entry->host) && service_length <= sizeof(entry->service);
+  if (cacheable && (count = sts_net__lookup_cache(host, service, addresses, max_addresses)) > 0) return count;
+
+  // ask the resolver, this might take a while
+  count = (sts_net__resolve_func ? sts_net__resolve_func : sts_net__getaddrinfo)(host, *service ? service : NULL, resolved, STS_NET_RESOLVER_ADDRESSES);
+  if (count <= 0) return sts_net__set_error("Cannot resolve hostname");
+  if (cacheable) {
+    STS_NET__LOCK_CACHE();
+    entry = sts_net__find_cache_entry(host, service, sts_net__time(), 1);
+    sts__memcpy(entry->host, host, host_length);
+    sts__memcpy(entry->service, service, service_length);
+    entry->expires = sts_net__time() + STS_NET_RESOLVER_TTL;
+    entry->count = count;
+    sts__memcpy(entry->addresses, resolved, sizeof(sts_net_address_t) * count);
+    STS_NET__UNLOCK_CACHE();
+  }
+  if (count > max_addresses) count = max_addresses;
+  sts__memcpy(addresses, resolved, sizeof(sts_net_address_t) * count);
+  return count;
+}
+
+
+void sts_net_clear_resolver_cache() {
+  int i;
+  STS_NET__LOCK_CACHE();
+  for (i = 0; i < STS_NET_RESOLVER_CACHE; ++i) sts_net__cache[i].expires = 0.0;
+  STS_NET__UNLOCK_CACHE();
+}
+
+
+static int sts_net__connect_address(sts_net_socket_t* sock, const sts_net_address_t* addresses, int count, int type) {
+  const struct sockaddr*  addr;
+  int                     i, fd;
+
+  for (i = 0; i < count; ++i) {
+    addr = (const struct sockaddr*)addresses[i].data;
+    fd = (int)socket(addr->sa_family, type, 0);
+    if (fd == INVALID_SOCKET) continue;
+    if (connect(fd, addr, (socklen_t)addresses[i].length) == 0) {
+      sock->fd = fd;
+      return 0;
+    }
+    closesocket(fd);
+  }
+  return sts_net__set_error("Cannot connect to host");
+}
+
+
+int sts_net_connect_address(sts_net_socket_t* sock, const sts_net_address_t* addresses, int count) {
+  sts_net_reset_socket(sock);
+  return sts_net__connect_address(sock, addresses, count, SOCK_STREAM);
+}
+
+
+#ifndef _WIN32
+// open a unix domain socket, paths starting with '@' are in the abstract namespace (Linux only)
+static int sts_net__open_unix_socket(sts_net_socket_t* sock, const char* path, int listening, int type) {
+  struct sockaddr_un  addr;
+  struct stat         info;
+  size_t              length = strlen(path);
+  socklen_t           addr_length;
+  int                 fd;
+
+  if (length == 0 || length >= sizeof(addr.sun_path)) {
+    return sts_net__set_error("Invalid unix socket path");
+  }
+  sts__memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  sts__memcpy(addr.sun_path, path, length);
+  addr_length = (socklen_t)(sizeof(addr) - sizeof(addr.sun_path) + length + 1);
+  if (path[0] == '@') {
+    addr.sun_path[0] = '\0';
+    --addr_length;
+  }
+  fd = (int)socket(AF_UNIX, type, 0);
+  if (fd == INVALID_SOCKET) {
+    return sts_net__set_error("Could not create socket");
+  }
+  if (listening) {
+    // remove the socket file of a previous run, bind would fail otherwise
+    if (path[0] != '@' && stat(path, &info) == 0 && S_ISSOCK(info.st_mode)) unlink(path);
+    if (bind(fd, (struct sockaddr*)&addr, addr_length) == SOCKET_ERROR) {
+      closesocket(fd);
+      return sts_net__set_error("Could not bind to path");
+    }
+    if (type == SOCK_STREAM) {
+      if (listen(fd, sts_net__backlog) == SOCKET_ERROR) {
+        closesocket(fd);
+        return sts_net__set_error("Could not listen to socket");
+      }
+      sock->server = 1;
+    }
+  } else if (connect(fd, (struct sockaddr*)&addr, addr_length) == SOCKET_ERROR) {
+    closesocket(fd);
+    return sts_net__set_error("Cannot connect to host");
+  }
+  sock->fd = fd;
+  sock->datagram = (type == SOCK_DGRAM);
+  return 0;
+}
+#endif // _WIN32
+
+
+static int sts_net__open_socket(sts_net_socket_t* sock, const char* host, const char* service, int type, int reuse_port) {
+  struct addrinfo     hints;
+  struct addrinfo     *res = NULL;
+  int                 fd = INVALID_SOCKET, count;
+  sts_net_address_t   addresses[STS_NET_RESOLVER_ADDRESSES];
+
+  sts_net_reset_socket(sock);
+  if ((host && strncmp(host, "unix:", 5) == 0) || (!host && service && strncmp(service, "unix:", 5) == 0)) {
+#ifndef _WIN32
+    return sts_net__open_unix_socket(sock, host ? host + 5 : service + 5, host == NULL, type);
+#else
+    return sts_net__set_error("Unix domain sockets are not supported");
+#endif // _WIN32
+  }
+  sts__memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = type;
+
+  if (host != NULL) {
+    // try to connect to remote host
+    count = sts_net_resolve_host(host, service, addresses, STS_NET_RESOLVER_ADDRESSES);
+    if (count < 0) return -1;
+    if (sts_net__connect_address(sock, addresses, count, type) < 0) return -1;
+  } else {
+    // listen for connection (start server)
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(NULL, service, &hints, &res) != 0) return sts_net__set_error("Cannot resolve hostname");
+    fd = (int)socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd == INVALID_SOCKET) {
+      freeaddrinfo(res);
+      return sts_net__set_error("Could not create socket");
+    }
+#ifndef _WIN32
+    if (type == SOCK_STREAM) {
+      int yes = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (char*)&yes, sizeof(yes));
+    }
+#endif // _WIN32
+#ifdef SO_REUSEPORT
+    if (reuse_port) {
+      int yes = 1;
+      if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (char*)&yes, sizeof(yes)) == SOCKET_ERROR) {
+        freeaddrinfo(res);
+        closesocket(fd);
+        return sts_net__set_error("Could not set SO_REUSEPORT");
+      }
+    }
+#else
+    if (reuse_port) {
+      freeaddrinfo(res);
+      closesocket(fd);
+      return sts_net__set_error("SO_REUSEPORT is not supported");
+    }
+#endif // SO_REUSEPORT
+    if (bind(fd, res->ai_addr, (int)res->ai_addrlen) == SOCKET_ERROR) {
+      freeaddrinfo(res);
+      closesocket(fd);
+      return sts_net__set_error("Could not bind to port");
+    }
+    freeaddrinfo(res);
+    if (type == SOCK_STREAM) {
+      if (listen(fd, sts_net__backlog) == SOCKET_ERROR) {
+        closesocket(fd);
+        return sts_net__set_error("Could not listen to socket");
+      }
+      sock->server = 1;
+    }
+    sock->fd = fd;
+  }
+  sock->datagram = (type == SOCK_DGRAM);
+  return 0;
+}
+
+
+int sts_net_open_socket(sts_net_socket_t* sock, const char* host, const char* service) {
+  return sts_net__open_socket(sock, host, service, SOCK_STREAM, 0);
+}
+
+
+int sts_net_open_datagram_socket(sts_net_socket_t* sock, const char* host, const char* service) {
+  return sts_net__open_socket(sock, host, service, SOCK_DGRAM, 0);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Shared memory rings
+//
+#ifdef STS_NET__SHM
+#define STS_NET__CACHE_LINE   64
+
+// the state of one direction, the positions are free running byte counters
+typedef struct {
+  unsigned int  head;       // written by the producer
+  char          pad0[STS_NET__CACHE_LINE - sizeof(unsigned int)];
+  unsigned int  tail;       // written by the consumer
+  char          pad1[STS_NET__CACHE_LINE - sizeof(unsigned int)];
+  unsigned int  closed;     // set by the producer when it closes its socket
+  unsigned int  waiting;    // set by the producer when it waits for free space
+  char          pad2[STS_NET__CACHE_LINE - 2 * sizeof(unsigned int)];
+} sts_net__ring_header_t;
+
+typedef struct {
+  char*                   memory;   // the shared mapping: both headers followed by both rings
+  size_t                  mapped;
+  sts_net__ring_header_t* rx;
+  sts_net__ring_header_t* tx;
+  char*                   rx_data;
+  char*                   tx_data;
+  unsigned int            size;
+  int                     notify;   // eventfd of the other process
+  int                     space;    // our eventfd, signaled when the other process made space in our ring
+  int                     space_notify; // the space eventfd of the other process
+} sts_net__shared_t;
+
+
+static void sts_net__signal_eventfd(int fd) {
+  unsigned long long one = 1;
+  if (write(fd, &one, sizeof(one)) < 0) {}
+}
+
+
+static void sts_net__close_fds(int* fds, int count) {
+  int i;
+  for (i = 0; i < count; ++i) if (fds[i] >= 0) close(fds[i]);
+}
+
+
+// close all file descriptors of a received message, they would leak otherwise
+static void sts_net__close_received_fds(struct msghdr* msg) {
+  struct cmsghdr* cmsg;
+  int             fds[8], count;
+
+  for (cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+    count = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+    if (count > 8) count = 8;
+    sts__memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * count);
+    sts_net__close_fds(fds, count);
+  }
+}
+
+
+static void sts_net__futex(unsigned int* address, int op, unsigned int value, const struct timespec* timeout) {
+  syscall(SYS_futex, address, op, value, timeout, NULL, 0);
+}
+
+
+static sts_net__shared_t* sts_net__map_shared(int memfd, unsigned int size, int creator) {
+  sts_net__shared_t*  shared;
+  size_t              mapped = sizeof(sts_net__ring_header_t) * 2 + (size_t)size * 2;
+  char*               memory;
+
+  memory = (char*)mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+  if (memory == (char*)MAP_FAILED) {
+    sts_net__set_error("Cannot map shared memory");
+    return NULL;
+  }
+  if ((shared = (sts_net__shared_t*)sts__malloc(sizeof(sts_net__shared_t))) == NULL) {
+    munmap(memory, mapped);
+    sts_net__set_error("Cannot allocate shared ring");
+    return NULL;
+  }
+  // the creator sends on the first ring and receives on the second one
+  shared->memory = memory;
+  shared->mapped = mapped;
+  shared->tx = (sts_net__ring_header_t*)memory + (creator ? 0 : 1);
+  shared->rx = (sts_net__ring_header_t*)memory + (creator ? 1 : 0);
+  shared->tx_data = memory + sizeof(sts_net__ring_header_t) * 2 + (creator ? 0 : size);
+  shared->rx_data = memory + sizeof(sts_net__ring_header_t) * 2 + (creator ? size : 0);
+  shared->size = size;
+  shared->notify = shared->space = shared->space_notify = -1;
+  return shared;
+}
+
+
+int sts_net_create_shared_ring(sts_net_socket_t* socket, sts_net_socket_t* unix_socket, int size) {
+  sts_net__shared_t*  shared;
+  struct msghdr       msg;
+  struct iovec        iov;
+  struct cmsghdr*     cmsg;
+  char                control[CMSG_SPACE(sizeof(int) * 5)];
+  unsigned int        ring_size = STS_NET_SHARED_RING_SIZE;
+  int                 fds[5];   // memory, data eventfds (the other process, ours), space eventfds (ours, the other process)
+  int                 i;
+
+  if (unix_socket->fd == INVALID_SOCKET || unix_socket->server) {
+    return sts_net__set_error("Shared rings need a connected unix domain socket");
+  }
+  if (size > 0x40000000) {
+    return sts_net__set_error("Shared ring is too large");
+  }
+  if (size > 0) for (ring_size = 4096; ring_size < (unsigned int)size; ring_size *= 2) {}
+  sts_net_reset_socket(socket);
+  fds[0] = memfd_create("sts_net", MFD_CLOEXEC);
+  for (i = 1; i < 5; ++i) fds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fds[0] < 0 || fds[1] < 0 || fds[2] < 0 || fds[3] < 0 || fds[4] < 0 ||
+      ftruncate(fds[0], (off_t)(sizeof(sts_net__ring_header_t) * 2 + (size_t)ring_size * 2)) < 0 ||
+      (shared = sts_net__map_shared(fds[0], ring_size, 1)) == NULL) {
+    sts_net__close_fds(fds, 5);
+    return sts_net__set_error("Cannot create shared ring");
+  }
+  // send the size of the rings and the file descriptors
+  iov.iov_base = &ring_size;
+  iov.iov_len = sizeof(ring_size);
+  sts__memset(&msg, 0, sizeof(msg));
+  sts__memset(control, 0, sizeof(control));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * 5);
+  sts__memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * 5);
+  if (sendmsg(unix_socket->fd, &msg, 0) != (ssize_t)sizeof(ring_size)) {
+    munmap(shared->memory, shared->mapped);
+    sts__free(shared);
+    sts_net__close_fds(fds, 5);
+    return sts_net__set_error("Cannot send shared ring");
+  }
+  close(fds[0]);
+  shared->notify = fds[1];
+  shared->space = fds[3];
+  shared->space_notify = fds[4];
+  socket->fd = fds[2];
+  socket->shared = shared;
+  return 0;
+}
+
+
+int sts_net_accept_shared_ring(sts_net_socket_t* socket, sts_net_socket_t* unix_socket) {
+  sts_net__shared_t*  shared;
+  struct msghdr       msg;
+  struct iovec        iov;
+  struct cmsghdr*     cmsg;
+  struct stat         info;
+  char                control[CMSG_SPACE(sizeof(int) * 5)];
+  unsigned int        ring_size = 0;
+  ssize_t             received;
+  int                 fds[5];   // memory, data eventfds (ours, the other process), space eventfds (the other process, ours)
+
+  if (unix_socket->fd == INVALID_SOCKET || unix_socket->server) {
+    return sts_net__set_error("Shared rings need a connected unix domain socket");
+  }
+  sts_net_reset_socket(socket);
+  unix_socket->ready = 0;
+  iov.iov_base = &ring_size;
+  iov.iov_len = sizeof(ring_size);
+  sts__memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  if ((received = recvmsg(unix_socket->fd, &msg, MSG_CMSG_CLOEXEC)) != (ssize_t)sizeof(ring_size)) {
+    if (received >= 0) sts_net__close_received_fds(&msg);
+    return sts_net__set_error("Cannot receive shared ring");
+  }
+  cmsg = CMSG_FIRSTHDR(&msg);
+  if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(sizeof(int) * 5)) {
+    sts_net__close_received_fds(&msg);
+    return sts_net__set_error("Received no shared ring");
+  }
+  sts__memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * 5);
+  // the other process decides about the size, so check it against the memory
+  if ((ring_size & (ring_size - 1)) != 0 || ring_size < 4096 || fstat(fds[0], &info) < 0 ||
+      (size_t)info.st_size != sizeof(sts_net__ring_header_t) * 2 + (size_t)ring_size * 2 ||
+      (shared = sts_net__map_shared(fds[0], ring_size, 0)) == NULL) {
+    sts_net__close_fds(fds, 5);
+    return sts_net__set_error("Received invalid shared ring");
+  }
+  close(fds[0]);
+  shared->notify = fds[2];
+  shared->space = fds[4];
+  shared->space_notify = fds[3];
+  socket->fd = fds[1];
+  socket->shared = shared;
+  return 0;
+}
+
+
+// mark our side as closed and wake up the other process
+static void sts_net__close_shared(sts_net_socket_t* socket) {
+  sts_net__shared_t* shared = (sts_net__shared_t*)socket->shared;
+
+  __atomic_store_n(&shared->tx->closed, 1, __ATOMIC_SEQ_CST);
+  sts_net__signal_eventfd(shared->notify);
+  // the other process might wait for space in its ring
+  sts_net__futex(&shared->rx->tail, FUTEX_WAKE, 0x7fffffff, NULL);
+  sts_net__signal_eventfd(shared->space_notify);
+  close(shared->notify);
+  close(shared->space);
+  close(shared->space_notify);
+  munmap(shared->memory, shared->mapped);
+  sts__free(shared);
+  socket->shared = NULL;
+}
+
+
+// write the spans into the ring, waits for free space if "wait" is set
+//  returns:
+//    -1  on errors (the other side was closed)
+//    >=0 amount of written bytes (all of them if "wait" is set)
+static int sts_net__shared_write(sts_net_socket_t* socket, const struct iovec* spans, int count, int wait) {
+  sts_net__shared_t*  shared = (sts_net__shared_t*)socket->shared;
+  struct timespec     timeout = { 0, 100000000 };
+  unsigned int        head = shared->tx->head, tail, start, length, chunk;
+  int                 i, offset = 0, written = 0;
+
+  for (i = 0; i < count; ) {
+    if (__atomic_load_n(&shared->rx->closed, __ATOMIC_ACQUIRE)) {
+      return sts_net__set_error("Cannot send data");
+    }
+    tail = __atomic_load_n(&shared->tx->tail, __ATOMIC_ACQUIRE);
+    length = shared->size - (head - tail);
+    if (length == 0) {
+      if (!wait) break;
+      // announce that we wait, so the reader wakes us up (the timeout checks if the other side closed)
+      __atomic_store_n(&shared->tx->waiting, 1, __ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&shared->tx->tail, __ATOMIC_SEQ_CST) == tail) sts_net__futex(&shared->tx->tail, FUTEX_WAIT, tail, &timeout);
+      continue;
+    }
+    if (length > (unsigned int)spans[i].iov_len - offset) length = (unsigned int)spans[i].iov_len - offset;
+    start = head & (shared->size - 1);
+    chunk = shared->size - start < length ? shared->size - start : length;
+    sts__memcpy(shared->tx_data + start, (const char*)spans[i].iov_base + offset, chunk);
+    sts__memcpy(shared->tx_data, (const char*)spans[i].iov_base + offset + chunk, length - chunk);
+    // publish the data, the reader needs a wakeup if it already read everything before
+    __atomic_store_n(&shared->tx->head, head + length, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&shared->tx->tail, __ATOMIC_ACQUIRE) == head) sts_net__signal_eventfd(shared->notify);
+    head += length;
+    written += (int)length;
+    if ((offset += (int)length) == (int)spans[i].iov_len) {
+      offset = 0;
+      ++i;
+    }
+  }
+  return written;
+}
+
+
+// read from the ring into the spans, waits until there's data
+//  returns:
+//    -1  on errors
+//    0   if the other side was closed
+//    >0  amount of read bytes
+static int sts_net__shared_read(sts_net_socket_t* socket, char* data0, int length0, char* data1, int length1) {
+  sts_net__shared_t*  shared = (sts_net__shared_t*)socket->shared;
+  unsigned long long  counter;
+  unsigned int        head, tail = shared->rx->tail, start, length, chunk, part;
+  struct pollfd       fds;
+
+  while (1) {
+    // reset the wakeup before looking at the ring, so no wakeup gets lost
+    if (read(socket->fd, &counter, sizeof(counter)) < 0) {}
+    head = __atomic_load_n(&shared->rx->head, __ATOMIC_ACQUIRE);
+    if (head != tail) break;
+    if (__atomic_load_n(&shared->rx->closed, __ATOMIC_ACQUIRE) && __atomic_load_n(&shared->rx->head, __ATOMIC_ACQUIRE) == tail) return 0;
+    fds.fd = socket->fd;
+    fds.events = POLLIN;
+    if (poll(&fds, 1, -1) < 0 && errno != EINTR) {
+      return sts_net__set_error("Cannot receive data");
+    }
+  }
+  length = head - tail;
+  if (length > (unsigned int)(length0 + length1)) length = (unsigned int)(length0 + length1);
+  // copy out of the ring into the first span and the rest into the second one
+  for (part = 0; part < length; part += chunk) {
+    char* dst = part < (unsigned int)length0 ? data0 + part : data1 + (part - (unsigned int)length0);
+    start = (tail + part) & (shared->size - 1);
+    chunk = length - part;
+    if (chunk > shared->size - start) chunk = shared->size - start;
+    if (part < (unsigned int)length0 && chunk > (unsigned int)length0 - part) chunk = (unsigned int)length0 - part;
+    sts__memcpy(dst, shared->rx_data + start, chunk);
+  }
+  __atomic_store_n(&shared->rx->tail, tail + length, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&shared->rx->waiting, __ATOMIC_ACQUIRE)) {
+    __atomic_store_n(&shared->rx->waiting, 0, __ATOMIC_RELAXED);
+    sts_net__futex(&shared->rx->tail, FUTEX_WAKE, 0x7fffffff, NULL);
+    sts_net__signal_eventfd(shared->space_notify);
+  }
+  // keep the socket ready while there's data left
+  if (__atomic_load_n(&shared->rx->head, __ATOMIC_ACQUIRE) != tail + length) sts_net__signal_eventfd(socket->fd);
+  return (int)length;
+}
+
+
+// returns the eventfd to wait for if the ring is full (the reader will signal it), -1 if it has space
+static int sts_net__shared_space_fd(sts_net_socket_t* socket) {
+  sts_net__shared_t*  shared = (sts_net__shared_t*)socket->shared;
+  unsigned long long  counter;
+
+  // reset the signal before looking at the ring, so no signal gets lost
+  if (read(shared->space, &counter, sizeof(counter)) < 0) {}
+  if (__atomic_load_n(&shared->rx->closed, __ATOMIC_ACQUIRE)) return -1;
+  if (shared->tx->head - __atomic_load_n(&shared->tx->tail, __ATOMIC_ACQUIRE) < shared->size) return -1;
+  __atomic_store_n(&shared->tx->waiting, 1, __ATOMIC_SEQ_CST);
+  // the reader might have made space before it saw the flag
+  if (shared->tx->head - __atomic_load_n(&shared->tx->tail, __ATOMIC_SEQ_CST) < shared->size) return -1;
+  return shared->space;
+}
+
+
+// put the next chunk of the file buffer at the head of the queue into the ring
+static int sts_net__shared_send_file(sts_net_socket_t* socket, sts_net_buffer_t* buffer, int length) {
+  sts_net__shared_t*  shared = (sts_net__shared_t*)socket->shared;
+  char                chunk[STS_NET_FILE_CHUNK];
+  struct iovec        span;
+  unsigned int        space = shared->size - (shared->tx->head - __atomic_load_n(&shared->tx->tail, __ATOMIC_ACQUIRE));
+
+  // only read what fits into the ring right now
+  if ((unsigned int)length > space) length = (int)space;
+  if (length == 0) return 0;
+  if (pread(buffer->file, chunk, (size_t)length, (off_t)(buffer->file_offset + socket->queue_offset)) != length) {
+    return sts_net__set_error("Cannot read file");
+  }
+  span.iov_base = chunk;
+  span.iov_len = (size_t)length;
+  return sts_net__shared_write(socket, &span, 1, 0);
+}
+#else
+int sts_net_create_shared_ring(sts_net_socket_t* socket, sts_net_socket_t* unix_socket, int size) {
+  (void)socket; (void)unix_socket; (void)size;
+  return sts_net__set_error("Shared rings are not supported");
+}
+
+
+int sts_net_accept_shared_ring(sts_net_socket_t* socket, sts_net_socket_t* unix_socket) {
+  (void)socket; (void)unix_socket;
+  return sts_net__set_error("Shared rings are not supported");
+}
+#ifndef _WIN32
+// sockets never have a shared ring here
+static void sts_net__close_shared(sts_net_socket_t* socket) { (void)socket; }
+static int sts_net__shared_write(sts_net_socket_t* socket, const struct iovec* spans, int count, int wait) {
+  (void)socket; (void)spans; (void)count; (void)wait;
+  return -1;
+}
+static int sts_net__shared_read(sts_net_socket_t* socket, char* data0, int length0, char* data1, int length1) {
+  (void)socket; (void)data0; (void)length0; (void)data1; (void)length1;
+  return -1;
+}
+static int sts_net__shared_send_file(sts_net_socket_t* socket, sts_net_buffer_t* buffer, int length) {
+  (void)socket; (void)buffer; (void)length;
+  return -1;
+}
+static int sts_net__shared_space_fd(sts_net_socket_t* socket) {
+  (void)socket;
+  return -1;
+}
+#endif // _WIN32
+#endif // STS_NET__SHM
+
+
+#ifndef STS_NET_NO_PACKETS
+static void sts_net__release_buffer(sts_net_socket_t* socket);
+static void sts_net__release_unpacked(sts_net_socket_t* socket);
+#endif // STS_NET_NO_PACKETS
+static void sts_net__clear_queue(sts_net_socket_t* socket);
+#if !defined(STS_NET_NO_THREADS) && !defined(STS_NET_NO_PACKETS)
+static void sts_net__detach_serial(sts_net_socket_t* socket);
+#endif // !defined(STS_NET_NO_THREADS) && !defined(STS_NET_NO_PACKETS)
+
+
+void sts_net_close_socket(sts_net_socket_t* socket) {
+#if !defined(STS_NET_NO_THREADS) && !defined(STS_NET_NO_PACKETS)
+  if (socket->serial) sts_net__detach_serial(socket);
+#endif // !defined(STS_NET_NO_THREADS) && !defined(STS_NET_NO_PACKETS)
+#ifndef _WIN32
+  if (socket->shared) sts_net__close_shared(socket);
+#endif // _WIN32
+  if (socket->fd != INVALID_SOCKET) closesocket(socket->fd);
+  sts_net__clear_queue(socket);
+#ifndef STS_NET_NO_PACKETS
+  sts_net__release_unpacked(socket);
+  sts_net__release_buffer(socket);
+#endif // STS_NET_NO_PACKETS
+  sts_net_reset_socket(socket);
+}
+
+
+int sts_net_accept_socket(sts_net_socket_t* listen_socket, sts_net_socket_t* remote_socket) {
+  struct sockaddr_in  sock_addr;
+  socklen_t           sock_alen;
+
+  if (!listen_socket->server) {
+    return sts_net__set_error("Cannot accept on client socket");
+  }
+  if (listen_socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot accept on closed socket");
+  }
+
+  sock_alen = sizeof(sock_addr);
+  listen_socket->ready = 0;
+  sts_net_reset_socket(remote_socket);
+  remote_socket->fd = (int)accept(listen_socket->fd, (struct sockaddr*)&sock_addr, &sock_alen);
+  if (remote_socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Accept failed");
+  }
+  return 0;
+}
+
+
+#ifndef STS_NET__ACCEPT4
+static int sts_net__set_nonblocking(int fd) {
+#ifdef _WIN32
+  u_long yes = 1;
+  return ioctlsocket((SOCKET)fd, FIONBIO, &yes) == SOCKET_ERROR ? -1 : 0;
+#else
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags < 0) return -1;
+  return (flags & O_NONBLOCK) ? 0 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+#endif // _WIN32
+}
+#endif // STS_NET__ACCEPT4
+
+
+// accept a single connection, returns INVALID_SOCKET if there's none
+static int sts_net__accept_fd(int listen_fd, const sts_net_accept_options_t* options) {
+  int fd;
+#ifdef STS_NET__ACCEPT4
+  // set the flags with the same system call
+  fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC | (options->nonblocking ? SOCK_NONBLOCK : 0));
+  if (fd == INVALID_SOCKET) return INVALID_SOCKET;
+#else
+  fd = (int)accept(listen_fd, NULL, NULL);
+  if (fd == INVALID_SOCKET) return INVALID_SOCKET;
+#ifndef _WIN32
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif // _WIN32
+  if (options->nonblocking) sts_net__set_nonblocking(fd);
+#endif // STS_NET__ACCEPT4
+  if (options->nodelay) {
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (char*)&yes, sizeof(yes));
+  }
+  if (options->send_buffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, (char*)&options->send_buffer, sizeof(options->send_buffer));
+  }
+  if (options->recv_buffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (char*)&options->recv_buffer, sizeof(options->recv_buffer));
+  }
+  return fd;
+}
+
+
+// checks if another connection is waiting, a blocking accept would wait for it otherwise
+static int sts_net__can_accept(int listen_fd) {
+#ifdef _WIN32
+  fd_set          fds;
+  struct timeval  tv = { 0, 0 };
+
+  FD_ZERO(&fds);
+  FD_SET((SOCKET)listen_fd, &fds);
+  return select(listen_fd + 1, &fds, NULL, NULL, &tv) > 0;
+#else
+  (void)listen_fd;
+  return 1;
+#endif // _WIN32
+}
+
+
+int sts_net_accept_sockets(sts_net_socket_t* listen_socket, sts_net_socket_t* remote_sockets, int count, const sts_net_accept_options_t* options) {
+  sts_net_accept_options_t  defaults;
+  int                       accepted = 0, fd;
+#ifndef _WIN32
+  int                       flags;
+#endif // _WIN32
+
+  if (!listen_socket->server) {
+    return sts_net__set_error("Cannot accept on client socket");
+  }
+  if (listen_socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot accept on closed socket");
+  }
+  if (!options) {
+    sts__memset(&defaults, 0, sizeof(defaults));
+    options = &defaults;
+  }
+#ifndef _WIN32
+  // the listening socket has to be non-blocking, or the last accept would wait for a new connection.
+  // The blocking mode can't be queried on Windows, so every further accept is checked with select() there.
+  flags = fcntl(listen_socket->fd, F_GETFL, 0);
+  if (flags < 0 || (!(flags & O_NONBLOCK) && fcntl(listen_socket->fd, F_SETFL, flags | O_NONBLOCK) < 0)) {
+    return sts_net__set_error("Cannot make server socket non-blocking");
+  }
+#endif // _WIN32
+  listen_socket->ready = 0;
+  while (accepted < count) {
+    if (accepted > 0 && !sts_net__can_accept(listen_socket->fd)) break;
+    fd = sts_net__accept_fd(listen_socket->fd, options);
+    if (fd == INVALID_SOCKET) {
+#ifdef _WIN32
+      int error = WSAGetLastError();
+      if (error == WSAEWOULDBLOCK) break;
+      if (error == WSAECONNRESET) continue;
+#else
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      // the connection was closed before it was accepted, so try the next one
+      if (errno == ECONNABORTED || errno == EINTR || errno == EPROTO) continue;
+#endif // _WIN32
+      // out of file descriptors etc. Keep the already accepted sockets.
+      if (accepted > 0) break;
+      return sts_net__set_error("Accept failed");
+    }
+    sts_net_reset_socket(&remote_sockets[accepted]);
+    remote_sockets[accepted].fd = fd;
+    ++accepted;
+  }
+#ifndef _WIN32
+  if (!(flags & O_NONBLOCK)) fcntl(listen_socket->fd, F_SETFL, flags);
+#endif // _WIN32
+  return accepted;
+}
+
+
+void sts_net_set_backlog(int backlog) {
+  sts_net__backlog = backlog > 0 ? backlog : STS_NET_BACKLOG;
+}
+
+
+int sts_net_set_socket_backlog(sts_net_socket_t* listen_socket, int backlog) {
+  if (!listen_socket->server) {
+    return sts_net__set_error("Cannot set the backlog of a client socket");
+  }
+  if (listen_socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot set the backlog of a closed socket");
+  }
+  // listen() on a listening socket only updates the backlog
+  if (listen(listen_socket->fd, backlog > 0 ? backlog : sts_net__backlog) == SOCKET_ERROR) {
+    return sts_net__set_error("Could not listen to socket");
+  }
+  return 0;
+}
+
+
+int sts_net_send(sts_net_socket_t* socket, const void* data, int length) {
+  if (socket->server) {
+    return sts_net__set_error("Cannot send on server socket");
+  }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot send on closed socket");
+  }
+#ifndef _WIN32
+  if (socket->shared) {
+    struct iovec span;
+    span.iov_base = (void*)data;
+    span.iov_len = (size_t)length;
+    if (sts_net__shared_write(socket, &span, 1, 1) < 0) return -1;
+    STS_NET__COUNT(socket, bytes_out, length);
+    return 0;
+  }
+#endif // _WIN32
+  STS_NET__COUNT(socket, syscalls_out, 1);
+  if (send(socket->fd, (const char*)data, length, 0) != length) {
+    return sts_net__set_error("Cannot send data");
+  }
+  STS_NET__COUNT(socket, bytes_out, length);
+  return 0;
+}
+
+
+int sts_net_recv(sts_net_socket_t* socket, void* data, int length) {
+  int result;
+  if (socket->server) {
+    return sts_net__set_error("Cannot receive on server socket");
+  }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot receive on closed socket");
+  }
+  socket->ready = 0;
+#ifndef _WIN32
+  if (socket->shared) {
+    if ((result = sts_net__shared_read(socket, (char*)data, length, NULL, 0)) < 0) return -1;
+    STS_NET__COUNT(socket, bytes_in, result);
+    return result;
+  }
+#endif // _WIN32
+  result = recv(socket->fd, (char*)data, length, 0);
+  STS_NET__COUNT(socket, syscalls_in, 1);
+  if (result < 0) {
+    return sts_net__set_error("Cannot receive data");
+  }
+  STS_NET__COUNT(socket, bytes_in, result);
+  return result;
+}
+
+
+void sts_net_init_socket_set(sts_net_set_t* set) {
+  int i;
+  for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
+    set->sockets[i] = NULL;
+  }
+  set->timers = NULL;
+}
+
+
+int sts_net_add_socket_to_set(sts_net_socket_t *socket, sts_net_set_t *set) {
+  int i;
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot add closed socket to set");
+  }
+  for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
+    if (!set->sockets[i]) {
+      set->sockets[i] = socket;
+      return 0;
+    }
+  }
+  return sts_net__set_error("Socket set is full");
+}
+
+
+int sts_net_remove_socket_from_set(sts_net_socket_t *socket, sts_net_set_t *set) {
+  int i;
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot remove closed socket from set");
+  }
+  for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
+    if (set->sockets[i] == socket) {
+      set->sockets[i] = NULL;
+      return 0;
+    }
+  }
+  return sts_net__set_error("Socket not found in set");
+}
+
+
+static int sts_net__poll_socket_set(sts_net_set_t* set, const float timeout) {
+#ifdef _WIN32
+  fd_set            fds, write_fds;
+  struct timeval    tv;
+  int               i, max_fd, result;
+  sts_net_socket_t* socket;
+
+
+  FD_ZERO(&fds);
+  FD_ZERO(&write_fds);
+  for (i = 0, max_fd = 0; i < STS_NET_SET_SOCKETS; ++i) {
+    if ((socket = set->sockets[i]) != NULL) {
+      FD_SET(socket->fd, &fds);
+      if (socket->queued > 0) FD_SET(socket->fd, &write_fds);
+      if (socket->fd > max_fd) {
+        max_fd = socket->fd;
+      }
+    }
+  }
+  if (max_fd == 0) {
+    // nothing to wait for, but the timers might expire
+    if (set->timers && timeout > 0.0f) Sleep((DWORD)(timeout * 1000.0f + 0.999f));
+    return 0;
+  }
+
+  tv.tv_sec = (int)timeout;
+  tv.tv_usec = (int)((timeout - (float)tv.tv_sec) * 1000000.0f);
+  result = select(max_fd + 1, &fds, &write_fds, NULL, &tv);
+  if (result > 0) {
+    for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
+      if ((socket = set->sockets[i]) != NULL) {
+        if (FD_ISSET(socket->fd, &fds)) {
+          socket->ready = 1;
+        }
+        if (FD_ISSET(socket->fd, &write_fds)) {
+          socket->writable = 1;
+        }
+      }
+    }
+  } else if (result == SOCKET_ERROR) {
+    sts_net__set_error("Error on select()");
+  }
+  return result;
+#else
+  struct pollfd     fds[STS_NET_SET_SOCKETS * 2];
+  int               indices[STS_NET_SET_SOCKETS * 2];   // negative for the space eventfds of shared rings
+  int               i, count, result, writable = 0, space;
+  sts_net_socket_t* socket;
+
+  for (i = 0, count = 0; i < STS_NET_SET_SOCKETS; ++i) {
+    if ((socket = set->sockets[i]) != NULL) {
+      fds[count].fd = socket->fd;
+      fds[count].events = POLLIN | (socket->queued > 0 && !socket->shared ? POLLOUT : 0);
+      fds[count].revents = 0;
+      indices[count++] = i;
+      // the eventfd of a shared ring is always writable, so wait for the reader to make space instead
+      if (socket->queued > 0 && socket->shared) {
+        if ((space = sts_net__shared_space_fd(socket)) < 0) {
+          socket->writable = 1;
+          ++writable;
+        } else {
+          fds[count].fd = space;
+          fds[count].events = POLLIN;
+          fds[count].revents = 0;
+          indices[count++] = -1 - i;
+        }
+      }
+    }
+  }
+  if (count == 0 && !set->timers) return 0;
+
+  // round up, so small timeouts won't turn into busy loops
+  result = poll(fds, (nfds_t)count, timeout > 0.0f && writable == 0 ? (int)(timeout * 1000.0f + 0.999f) : 0);
+  if (result > 0) {
+    for (i = 0; i < count; ++i) {
+      if (indices[i] < 0) {
+        if (fds[i].revents) set->sockets[-1 - indices[i]]->writable = 1;
+        continue;
+      }
+      socket = set->sockets[indices[i]];
+      // errors and hang ups are reported as ready, so the next receive will fail / return 0
+      if (fds[i].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) {
+        socket->ready = 1;
+      }
+      if (fds[i].revents & POLLOUT) {
+        socket->writable = 1;
+      }
+    }
+  } else if (result < 0) {
+    sts_net__set_error("Error on poll()");
+    return result;
+  }
+  return result + writable;
+#endif // _WIN32
+}
+
+
+int sts_net_check_socket_set(sts_net_set_t* set, const float timeout) {
+  float   wait = timeout;
+  double  delay;
+  int     result;
+
+  if (set->timers && (delay = sts_net_get_timer_delay(set->timers)) >= 0.0 && delay < (double)wait) wait = (float)delay;
+  result = sts_net__poll_socket_set(set, wait);
+  if (result >= 0 && set->timers) result += sts_net_update_timers(set->timers);
+  return result;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Buffers
+//
+sts_net_buffer_t* sts_net_create_buffer(const void* data, int length) {
+  sts_net_buffer_t* buffer;
+
+  if (length < 0) {
+    sts_net__set_error("Invalid buffer length");
+    return NULL;
+  }
+  buffer = (sts_net_buffer_t*)sts__malloc(sizeof(sts_net_buffer_t) + (size_t)length);
+  if (!buffer) {
+    sts_net__set_error("Cannot allocate buffer");
+    return NULL;
+  }
+  buffer->refs = 1;
+  buffer->length = length;
+  buffer->data = (char*)(buffer + 1);
+  buffer->file = -1;
+  buffer->file_offset = 0;
+  if (data) sts__memcpy(buffer->data, data, length);
+  return buffer;
+}
+
+
+sts_net_buffer_t* sts_net_create_file_buffer(const char* filename, long long offset, int length) {
+  sts_net_buffer_t* buffer;
+  long long         size;
+  int               file;
+#ifdef _WIN32
+  struct _stati64   st;
+#else
+  struct stat       st;
+#endif // _WIN32
+
+  if (offset < 0) {
+    sts_net__set_error("Invalid file range");
+    return NULL;
+  }
+#ifdef _WIN32
+  if ((file = _open(filename, _O_RDONLY | _O_BINARY)) < 0) {
+    sts_net__set_error("Cannot open file");
+    return NULL;
+  }
+  size = _fstati64(file, &st) == 0 ? (long long)st.st_size : -1;
+#else
+  if ((file = open(filename, O_RDONLY)) < 0) {
+    sts_net__set_error("Cannot open file");
+    return NULL;
+  }
+  size = fstat(file, &st) == 0 ? (long long)st.st_size : -1;
+#endif // _WIN32
+  if (length < 0) {
+    if (size - offset > 0x7fffffff) {
+      sts_net__set_error("File range is too large");
+      size = -1;
+    }
+    length = (int)(size - offset);
+  }
+  if (size < 0 || offset + length > size || !(buffer = (sts_net_buffer_t*)sts__malloc(sizeof(sts_net_buffer_t)))) {
+    if (size >= 0) sts_net__set_error(offset + length > size ? "Invalid file range" : "Cannot allocate buffer");
+#ifdef _WIN32
+    _close(file);
+#else
+    close(file);
+#endif // _WIN32
+    return NULL;
+  }
+  buffer->refs = 1;
+  buffer->length = length;
+  buffer->data = NULL;
+  buffer->file = file;
+  buffer->file_offset = offset;
+  return buffer;
+}
+
+
+void sts_net_retain_buffer(sts_net_buffer_t* buffer) {
+  STS_NET__ADD(&buffer->refs, 1);
+}
+
+
+void sts_net_release_buffer(sts_net_buffer_t* buffer) {
+  if (buffer && STS_NET__ADD(&buffer->refs, -1) == 0) {
+#ifdef _WIN32
+    if (buffer->file != -1) _close(buffer->file);
+#else
+    if (buffer->file != -1) close(buffer->file);
+#endif // _WIN32
+    sts__free(buffer);
+  }
+}
+
+
+#ifdef MSG_ZEROCOPY
+// buffers which were sent with MSG_ZEROCOPY and are still used by the kernel
+typedef struct {
+  unsigned          next_id;                          // the id the kernel will give the next zerocopy send
+  int               head, count;
+  unsigned          ids[STS_NET_SEND_QUEUE * 2];
+  sts_net_buffer_t* buffers[STS_NET_SEND_QUEUE * 2];
+} sts_net__zerocopy_t;
+
+
+// release all buffers the kernel is done with
+static void sts_net__reap_zerocopy(sts_net_socket_t* socket) {
+  sts_net__zerocopy_t*      zc = (sts_net__zerocopy_t*)socket->zerocopy;
+  struct msghdr             msg;
+  struct cmsghdr*           cmsg;
+  struct sock_extended_err* err;
+  char                      control[128];
+
+  while (zc->count > 0) {
+    sts__memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(socket->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      err = (struct sock_extended_err*)CMSG_DATA(cmsg);
+      if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+      // the sends [ee_info .. ee_data] are done, they are completed in order
+      while (zc->count > 0 && (int)(err->ee_data - zc->ids[zc->head]) >= 0) {
+        sts_net_release_buffer(zc->buffers[zc->head]);
+        zc->head = (zc->head + 1) % (STS_NET_SEND_QUEUE * 2);
+        --zc->count;
+      }
+    }
+  }
+}
+#endif // MSG_ZEROCOPY
+
+
+static void sts_net__clear_queue(sts_net_socket_t* socket) {
+  for (; socket->queued > 0; --socket->queued) {
+    sts_net_release_buffer(socket->queue[socket->queue_head]);
+    socket->queue_head = (socket->queue_head + 1) % STS_NET_SEND_QUEUE;
+  }
+  socket->queue_head = socket->queue_offset = 0;
+#ifdef MSG_ZEROCOPY
+  if (socket->zerocopy) {
+    sts_net__zerocopy_t* zc = (sts_net__zerocopy_t*)socket->zerocopy;
+    for (; zc->count > 0; --zc->count) {
+      sts_net_release_buffer(zc->buffers[zc->head]);
+      zc->head = (zc->head + 1) % (STS_NET_SEND_QUEUE * 2);
+    }
+    sts__free(zc);
+    socket->zerocopy = NULL;
+  }
+#endif // MSG_ZEROCOPY
+}
+
+
+int sts_net_enable_zerocopy(sts_net_socket_t* socket) {
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+  int yes = 1;
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot enable zerocopy on closed socket");
+  }
+  if (socket->zerocopy) return 0;
+  if (setsockopt(socket->fd, SOL_SOCKET, SO_ZEROCOPY, &yes, sizeof(yes)) < 0) {
+    return sts_net__set_error("MSG_ZEROCOPY is not supported");
+  }
+  socket->zerocopy = sts__malloc(sizeof(sts_net__zerocopy_t));
+  if (!socket->zerocopy) return sts_net__set_error("Cannot allocate zerocopy state");
+  sts__memset(socket->zerocopy, 0, sizeof(sts_net__zerocopy_t));
+  return 0;
+#else
+  (void)socket;
+  return sts_net__set_error("MSG_ZEROCOPY is not supported");
+#endif // defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+}
+
+
+int sts_net_queue_buffer(sts_net_socket_t* socket, sts_net_buffer_t* buffer) {
+  if (socket->server) {
+    return sts_net__set_error("Cannot send on server socket");
+  }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot send on closed socket");
+  }
+  if (socket->queued >= STS_NET_SEND_QUEUE) {
+    return sts_net__set_error("Send queue is full");
+  }
+  sts_net_retain_buffer(buffer);
+  socket->queue[(socket->queue_head + socket->queued) % STS_NET_SEND_QUEUE] = buffer;
+  if (socket->histogram) socket->queue_times[(socket->queue_head + socket->queued) % STS_NET_SEND_QUEUE] = sts_net__time();
+  ++socket->queued;
+  STS_NET__COUNT(socket, packets_out, 1);
+#ifndef STS_NET_NO_STATS
+  if (socket->queued > STS_NET__LOAD64(&socket->stats.queue_high)) {
+    long long high = STS_NET__LOAD64(&sts_net__stats.queue_high);
+    STS_NET__STORE64(&socket->stats.queue_high, (long long)socket->queued);
+    // sockets on other threads update the global maximum too, don't overwrite a higher value
+    while (socket->queued > high && !STS_NET__CAS64(&sts_net__stats.queue_high, high, (long long)socket->queued)) {
+      high = STS_NET__LOAD64(&sts_net__stats.queue_high);
+    }
+  }
+#endif // STS_NET_NO_STATS
+  return 0;
+}
+
+
+// send the next chunk of the file buffer at the head of the queue
+//  returns:
+//    -1  on errors
+//    >=0 amount of bytes sent (0 if the socket would block)
+static int sts_net__send_file(sts_net_socket_t* socket, sts_net_buffer_t* buffer, int length) {
+  long long offset = buffer->file_offset + socket->queue_offset;
+#if defined(__linux__) || defined(__APPLE__)
+  // sendfile() has no flags, so make the socket non-blocking for the call
+  int       flags = fcntl(socket->fd, F_GETFL, 0), error;
+#ifdef __linux__
+  off_t     position = (off_t)offset;
+  ssize_t   sent;
+#else
+  off_t     sent = (off_t)length;
+#endif // __linux__
+
+  if (flags >= 0 && !(flags & O_NONBLOCK)) fcntl(socket->fd, F_SETFL, flags | O_NONBLOCK);
+#ifdef __linux__
+  sent = sendfile(socket->fd, buffer->file, &position, (size_t)length);
+#else
+  // macOS reports the amount of sent bytes in "sent", even if the call fails with EAGAIN
+  if (sendfile(buffer->file, socket->fd, (off_t)offset, &sent, NULL, 0) < 0 && (errno != EAGAIN || sent == 0)) sent = -1;
+#endif // __linux__
+  error = errno;
+  if (flags >= 0 && !(flags & O_NONBLOCK)) fcntl(socket->fd, F_SETFL, flags);
+  if (sent < 0) {
+    if (error == EAGAIN || error == EWOULDBLOCK) return 0;
+    return sts_net__set_error("Cannot send file");
+  }
+  return (int)sent;
+#else
+  // no sendfile(), so read the chunk into memory and send it
+  char      chunk[STS_NET_FILE_CHUNK];
+  int       sent;
+#ifdef _WIN32
+  if (_lseeki64(buffer->file, offset, SEEK_SET) != offset || _read(buffer->file, chunk, (unsigned)length) != length) {
+    return sts_net__set_error("Cannot read file");
+  }
+  if ((sent = send(socket->fd, chunk, length, 0)) == SOCKET_ERROR) {
+    if (WSAGetLastError() == WSAEWOULDBLOCK) return 0;
+    return sts_net__set_error("Cannot send file");
+  }
+#else
+  int       flags = MSG_DONTWAIT;
+#ifdef MSG_NOSIGNAL
+  flags |= MSG_NOSIGNAL;
+#endif // MSG_NOSIGNAL
+  if (pread(buffer->file, chunk, (size_t)length, (off_t)offset) != length) {
+    return sts_net__set_error("Cannot read file");
+  }
+  if ((sent = (int)send(socket->fd, chunk, (size_t)length, flags)) < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) return 0;
+    return sts_net__set_error("Cannot send file");
+  }
+#endif // _WIN32
+  return sent;
+#endif // defined(__linux__) || defined(__APPLE__)
+}
+
+
+int sts_net_flush_socket(sts_net_socket_t* socket) {
+  sts_net_buffer_t* buffer;
+  int               i, count, sent, zerocopy = 0;
+#ifdef _WIN32
+  WSABUF            buffers[STS_NET_SEND_QUEUE];
+  DWORD             bytes = 0;
+#else
+  struct iovec      buffers[STS_NET_SEND_QUEUE];
+  struct msghdr     msg;
+  int               flags;
+#endif // _WIN32
+  int               total;
+  double            now = 0.0;
+
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot send on closed socket");
+  }
+  socket->writable = 0;
+#ifdef MSG_ZEROCOPY
+  if (socket->zerocopy) sts_net__reap_zerocopy(socket);
+#endif // MSG_ZEROCOPY
+
+  while (socket->queued > 0) {
+    buffer = socket->queue[socket->queue_head];
+    if (buffer->file != -1) {
+      // send a chunk of the file
+      total = buffer->length - socket->queue_offset;
+      if (total > STS_NET_FILE_CHUNK) total = STS_NET_FILE_CHUNK;
+      if (total > 0) STS_NET__COUNT(socket, syscalls_out, 1);
+      if (total <= 0) {
+        sent = 0;
+#ifndef _WIN32
+      } else if (socket->shared) {
+        sent = sts_net__shared_send_file(socket, buffer, total);
+#endif // _WIN32
+      } else {
+        sent = sts_net__send_file(socket, buffer, total);
+      }
+      if (sent < 0) return -1;
+      if (sent == 0 && total > 0) return 1;
+    } else {
+      // send all queued memory buffers (up to the next file buffer) with a single call
+      for (count = 0, total = 0; count < socket->queued; ++count) {
+        buffer = socket->queue[(socket->queue_head + count) % STS_NET_SEND_QUEUE];
+        if (buffer->file != -1) break;
+#ifdef _WIN32
+        buffers[count].buf = buffer->data + (count == 0 ? socket->queue_offset : 0);
+        buffers[count].len = (ULONG)(buffer->length - (count == 0 ? socket->queue_offset : 0));
+        total += (int)buffers[count].len;
+#else
+        buffers[count].iov_base = buffer->data + (count == 0 ? socket->queue_offset : 0);
+        buffers[count].iov_len = (size_t)(buffer->length - (count == 0 ? socket->queue_offset : 0));
+        total += (int)buffers[count].iov_len;
+#endif // _WIN32
+      }
+      STS_NET__COUNT(socket, syscalls_out, 1);
+#ifdef _WIN32
+      if (WSASend((SOCKET)socket->fd, buffers, (DWORD)count, &bytes, 0, NULL, NULL) == SOCKET_ERROR) {
+        if (WSAGetLastError() == WSAEWOULDBLOCK) return 1;
+        return sts_net__set_error("Cannot send data");
+      }
+      sent = (int)bytes;
+#else
+      flags = MSG_DONTWAIT;
+#ifdef MSG_NOSIGNAL
+      flags |= MSG_NOSIGNAL;
+#endif // MSG_NOSIGNAL
+#ifdef MSG_ZEROCOPY
+      if (socket->zerocopy && total >= STS_NET_ZEROCOPY_SIZE && ((sts_net__zerocopy_t*)socket->zerocopy)->count + count <= STS_NET_SEND_QUEUE * 2) {
+        flags |= MSG_ZEROCOPY;
+        zerocopy = 1;
+      }
+#endif // MSG_ZEROCOPY
+      sts__memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = buffers;
+      msg.msg_iovlen = count;
+      if (socket->shared) {
+        // a shared ring takes what fits into it
+        if ((sent = sts_net__shared_write(socket, buffers, count, 0)) < 0) return -1;
+      } else if ((sent = (int)sendmsg(socket->fd, &msg, flags)) < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) return 1;
+        return sts_net__set_error("Cannot send data");
+      }
+#endif // _WIN32
+
+#ifdef MSG_ZEROCOPY
+      if (zerocopy) {
+        // the kernel uses the memory of all buffers it took data from, keep them alive until it's done
+        sts_net__zerocopy_t* zc = (sts_net__zerocopy_t*)socket->zerocopy;
+        int                  used = socket->queue_offset + sent;
+        for (i = 0; i < count && used > 0; ++i) {
+          buffer = socket->queue[(socket->queue_head + i) % STS_NET_SEND_QUEUE];
+          sts_net_retain_buffer(buffer);
+          zc->buffers[(zc->head + zc->count) % (STS_NET_SEND_QUEUE * 2)] = buffer;
+          zc->ids[(zc->head + zc->count) % (STS_NET_SEND_QUEUE * 2)] = zc->next_id;
+          ++zc->count;
+          used -= buffer->length;
+        }
+        ++zc->next_id;
+        zerocopy = 0;
+      }
+#else
+      (void)zerocopy;
+      (void)i;
+#endif // MSG_ZEROCOPY
+    }
+
+    STS_NET__COUNT(socket, bytes_out, sent);
+    if (sent < total) STS_NET__COUNT(socket, partial_sends, 1);
+    if (socket->histogram && now == 0.0) now = sts_net__time();
+    // drop all buffers which were sent completely (empty buffers are dropped as well)
+    for (count = sent; socket->queued > 0; ) {
+      buffer = socket->queue[socket->queue_head];
+      if (count >= buffer->length - socket->queue_offset) {
+        count -= buffer->length - socket->queue_offset;
+        if (socket->histogram) sts_net_record_latency(socket->histogram, now - socket->queue_times[socket->queue_head]);
+        sts_net_release_buffer(buffer);
+        socket->queue_head = (socket->queue_head + 1) % STS_NET_SEND_QUEUE;
+        socket->queue_offset = 0;
+        --socket->queued;
+      } else {
+        socket->queue_offset += count;
+        break;
+      }
+    }
+    // the socket can't take more data right now
+    if (sent < total) return 1;
+  }
+  return 0;
+}
+
+
+int sts_net_broadcast(sts_net_socket_t** sockets, int count, sts_net_buffer_t* buffer) {
+  int i, result = 0;
+
+  for (i = 0; i < count; ++i) {
+    if (!sockets[i] || sockets[i]->server || sockets[i]->fd == INVALID_SOCKET) continue;
+    if (sts_net_queue_buffer(sockets[i], buffer) < 0 || sts_net_flush_socket(sockets[i]) < 0) result = -1;
+  }
+  return result;
+}
+
+
+int sts_net_recv_datagrams(sts_net_socket_t* socket, sts_net_datagram_t* datagrams, int count) {
+#ifdef STS_NET__MMSG
+  struct mmsghdr  msgs[STS_NET_DATAGRAM_BATCH];
+  struct iovec    buffers[STS_NET_DATAGRAM_BATCH];
+  int             i;
+#else
+  socklen_t       address_length;
+#endif // STS_NET__MMSG
+  int             result;
+
+  if (!socket->datagram) {
+    return sts_net__set_error("Cannot receive datagrams on stream socket");
+  }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot receive on closed socket");
+  }
+  if (count <= 0) return 0;
+  socket->ready = 0;
+#ifdef STS_NET__MMSG
+  if (count > STS_NET_DATAGRAM_BATCH) count = STS_NET_DATAGRAM_BATCH;
+  sts__memset(msgs, 0, sizeof(msgs[0]) * count);
+  for (i = 0; i < count; ++i) {
+    buffers[i].iov_base = datagrams[i].data;
+    buffers[i].iov_len = (size_t)datagrams[i].size;
+    msgs[i].msg_hdr.msg_iov = &buffers[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = datagrams[i].address.data;
+    msgs[i].msg_hdr.msg_namelen = sizeof(datagrams[i].address.data);
+  }
+  // block for the first datagram only, then take everything which is already there
+  result = recvmmsg(socket->fd, msgs, (unsigned int)count, MSG_WAITFORONE, NULL);
+  STS_NET__COUNT(socket, syscalls_in, 1);
+  if (result < 0) {
+    return sts_net__set_error("Cannot receive datagrams");
+  }
+  for (i = 0; i < result; ++i) {
+    datagrams[i].length = (int)msgs[i].msg_len;
+    datagrams[i].address.length = (int)msgs[i].msg_hdr.msg_namelen;
+    STS_NET__COUNT(socket, bytes_in, datagrams[i].length);
+  }
+#else
+  address_length = sizeof(datagrams[0].address.data);
+  result = recvfrom(socket->fd, (char*)datagrams[0].data, datagrams[0].size, 0, (struct sockaddr*)datagrams[0].address.data, &address_length);
+  STS_NET__COUNT(socket, syscalls_in, 1);
+  if (result < 0) {
+    return sts_net__set_error("Cannot receive datagrams");
+  }
+  STS_NET__COUNT(socket, bytes_in, result);
+  datagrams[0].length = result;
+  datagrams[0].address.length = (int)address_length;
+  result = 1;
+#endif // STS_NET__MMSG
+  STS_NET__COUNT(socket, packets_in, result);
+  return result;
+}
+
+
+int sts_net_send_datagrams(sts_net_socket_t* socket, const sts_net_datagram_t* datagrams, int count) {
+#ifdef STS_NET__MMSG
+  struct mmsghdr  msgs[STS_NET_DATAGRAM_BATCH];
+  struct iovec    buffers[STS_NET_DATAGRAM_BATCH];
+  int             i, batch, result;
+#endif // STS_NET__MMSG
+  int             sent = 0;
+
+  if (!socket->datagram) {
+    return sts_net__set_error("Cannot send datagrams on stream socket");
+  }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot send on closed socket");
+  }
+#ifdef STS_NET__MMSG
+  while (sent < count) {
+    batch = count - sent;
+    if (batch > STS_NET_DATAGRAM_BATCH) batch = STS_NET_DATAGRAM_BATCH;
+    sts__memset(msgs, 0, sizeof(msgs[0]) * batch);
+    for (i = 0; i < batch; ++i) {
+      buffers[i].iov_base = datagrams[sent + i].data;
+      buffers[i].iov_len = (size_t)datagrams[sent + i].length;
+      msgs[i].msg_hdr.msg_iov = &buffers[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+      if (datagrams[sent + i].address.length > 0) {
+        msgs[i].msg_hdr.msg_name = (void*)datagrams[sent + i].address.data;
+        msgs[i].msg_hdr.msg_namelen = (socklen_t)datagrams[sent + i].address.length;
+      }
+    }
+    result = sendmmsg(socket->fd, msgs, (unsigned int)batch, 0);
+    STS_NET__COUNT(socket, syscalls_out, 1);
+    if (result < 0) {
+      if (sent > 0) break;
+      return sts_net__set_error("Cannot send datagrams");
+    }
+    for (i = 0; i < result; ++i) STS_NET__COUNT(socket, bytes_out, datagrams[sent + i].length);
+    sent += result;
+    if (result < batch) break;
+  }
+#else
+  for (; sent < count; ++sent) {
+    const sts_net_datagram_t* d = &datagrams[sent];
+    STS_NET__COUNT(socket, syscalls_out, 1);
+    if (sendto(socket->fd, (const char*)d->data, d->length, 0, d->address.length > 0 ? (const struct sockaddr*)d->address.data : NULL, d->address.length) != d->length) {
+      if (sent > 0) break;
+      return sts_net__set_error("Cannot send datagrams");
+    }
+    STS_NET__COUNT(socket, bytes_out, d->length);
+  }
+#endif // STS_NET__MMSG
+  STS_NET__COUNT(socket, packets_out, sent);
+  return sent;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Connections
+//
+#define STS_NET__HEADER_SIZE      9     // sequence (2), ack (2), ack bits (4), flags (1)
+#define STS_NET__HEADER_ACK       0x01  // flag if ack / ack bits are valid (the sender received a datagram)
+#define STS_NET__DATAGRAM_RECORDS 256   // sent datagrams kept to process their acknowledgments
+#define STS_NET__DATAGRAM_REFS    32    // the maximum amount of reliable fragments in a datagram
+#define STS_NET__MAX_IN_FLIGHT    32    // unacknowledged datagrams with fragments (what a single ack field covers)
+#define STS_NET__MESSAGE_RELIABLE 0x80
+#define STS_NET__MESSAGE_FRAGMENT 0x40
+
+// a fragment with its 7 byte message header has to fit into a datagram (fails to compile otherwise)
+typedef char sts_net__fragment_fits_mtu[STS_NET_FRAGMENT_SIZE + STS_NET__HEADER_SIZE + 7 <= STS_NET_CONNECTION_MTU ? 1 : -1];
+
+// a reliable message waiting for its acknowledgment
+typedef struct {
+  sts_net_buffer_t* buffer;   // the message (NULL if the slot is free)
+  int               id;
+  int               fragments;
+  int               acked;    // amount of acknowledged fragments
+  double*           sent;     // when every fragment was sent the last time (0 if never, -1 if acknowledged)
+} sts_net__outgoing_t;
+
+// a reliable message being reassembled, the received flags of the fragments live behind the data
+typedef struct {
+  sts_net_buffer_t* buffer;   // NULL if the slot is free
+  int               id;
+  int               fragments;
+  int               received; // amount of received fragments
+  int               length;   // length of the message (known when the last fragment arrived)
+} sts_net__incoming_t;
+
+typedef struct {
+  int               sequence; // -1 if unused
+  int               acked;
+  double            time;     // when it was sent
+  int               count;
+  unsigned short    ids[STS_NET__DATAGRAM_REFS];
+  unsigned char     fragments[STS_NET__DATAGRAM_REFS];
+} sts_net__record_t;
+
+// a datagram held back by the network simulation
+typedef struct sts_net__delayed_t {
+  struct sts_net__delayed_t*  next;
+  double                      time;
+  int                         length;
+} sts_net__delayed_t;
+
+struct sts_net_connection_t {
+  sts_net_socket_t*         socket;
+  sts_net_address_t         address;
+  int                       sequence;         // sequence of the next datagram
+  int                       remote_sequence;  // latest received sequence (-1 if nothing was received)
+  unsigned long             remote_bits;      // received flags of the 32 sequences before it
+  int                       ack_pending;      // flag if there are received datagrams which weren't acknowledged
+  double                    last_send, last_receive;
+  double                    srtt, rttvar, rto;
+  int                       send_id, send_base;   // id of the next / oldest unacknowledged reliable message
+  sts_net__outgoing_t       outgoing[STS_NET_CONNECTION_WINDOW];
+  int                       unreliable_id, unreliable_count;
+  sts_net_buffer_t*         unreliable[STS_NET_CONNECTION_QUEUE];
+  int                       receive_id;       // id of the next reliable message to deliver
+  int                       last_unreliable;  // id of the last delivered unreliable message (-1 if none)
+  sts_net__incoming_t       incoming[STS_NET_CONNECTION_WINDOW];
+  int                       delivered_head, delivered_count;
+  sts_net_buffer_t*         delivered[STS_NET_CONNECTION_QUEUE];
+  int                       delivered_channels[STS_NET_CONNECTION_QUEUE];
+  sts_net__record_t         records[STS_NET__DATAGRAM_RECORDS];
+  float                     loss, latency, jitter;
+  unsigned long             random;
+  sts_net__delayed_t*       delayed;
+  sts_net_connection_info_t info;
+};
+
+
+// difference of two 16 bit sequences (positive if "a" is newer than "b")
+static int sts_net__sequence_diff(int a, int b) {
+  return (int)(short)(unsigned short)((a - b) & 0xffff);
+}
+
+
+static void sts_net__write16(unsigned char* p, int value) {
+  p[0] = (unsigned char)(value >> 8);
+  p[1] = (unsigned char)value;
+}
+
+
+static int sts_net__read16(const unsigned char* p) {
+  return (p[0] << 8) | p[1];
+}
+
+
+sts_net_connection_t* sts_net_create_connection(sts_net_socket_t* socket, const sts_net_address_t* address) {
+  sts_net_connection_t* c;
+  int                   i;
+
+  if (!socket->datagram || socket->fd == INVALID_SOCKET) {
+    sts_net__set_error("Connections need an open datagram socket");
+    return NULL;
+  }
+  if ((c = (sts_net_connection_t*)sts__malloc(sizeof(sts_net_connection_t))) == NULL) {
+    sts_net__set_error("Cannot allocate connection");
+    return NULL;
+  }
+  sts__memset(c, 0, sizeof(sts_net_connection_t));
+  c->socket = socket;
+  if (address) c->address = *address;
+  c->remote_sequence = c->last_unreliable = -1;
+  c->rto = 0.2;
+  c->last_send = c->last_receive = sts_net__time();
+  c->random = (unsigned long)(size_t)c ^ 0x9e3779b9UL;
+  for (i = 0; i < STS_NET__DATAGRAM_RECORDS; ++i) c->records[i].sequence = -1;
+  return c;
+}
+
+
+void sts_net_destroy_connection(sts_net_connection_t* c) {
+  sts_net__delayed_t* delayed;
+  int                 i;
+
+  if (!c) return;
+  for (i = 0; i < STS_NET_CONNECTION_WINDOW; ++i) {
+    if (c->outgoing[i].buffer) {
+      sts_net_release_buffer(c->outgoing[i].buffer);
+      sts__free(c->outgoing[i].sent);
+    }
+    sts_net_release_buffer(c->incoming[i].buffer);
+  }
+  for (i = 0; i < c->unreliable_count; ++i) sts_net_release_buffer(c->unreliable[i]);
+  for (i = 0; i < c->delivered_count; ++i) sts_net_release_buffer(c->delivered[(c->delivered_head + i) % STS_NET_CONNECTION_QUEUE]);
+  while ((delayed = c->delayed) != NULL) {
+    c->delayed = delayed->next;
+    sts__free(delayed);
+  }
+  sts__free(c);
+}
+
+
+int sts_net_send_message(sts_net_connection_t* c, int channel, const void* data, int length) {
+  sts_net__outgoing_t*  slot;
+  int                   fragments;
+
+  if (length < 0) return sts_net__set_error("Invalid message length");
+  if (channel == STS_NET_RELIABLE) {
+    fragments = length > 0 ? (length + STS_NET_FRAGMENT_SIZE - 1) / STS_NET_FRAGMENT_SIZE : 1;
+    if (fragments > 255) return sts_net__set_error("Message is too large");
+    if (c->send_id - c->send_base >= STS_NET_CONNECTION_WINDOW) return sts_net__set_error("Send window is full");
+    slot = &c->outgoing[c->send_id % STS_NET_CONNECTION_WINDOW];
+    if ((slot->buffer = sts_net_create_buffer(data, length)) == NULL) return -1;
+    if ((slot->sent = (double*)sts__malloc(sizeof(double) * (size_t)fragments)) == NULL) {
+      sts_net_release_buffer(slot->buffer);
+      slot->buffer = NULL;
+      return sts_net__set_error("Cannot allocate message");
+    }
+    sts__memset(slot->sent, 0, sizeof(double) * (size_t)fragments);
+    slot->id = c->send_id++;
+    slot->fragments = fragments;
+    slot->acked = 0;
+    return 0;
+  }
+  if (length > STS_NET_FRAGMENT_SIZE) return sts_net__set_error("Unreliable message is too large");
+  if (c->unreliable_count >= STS_NET_CONNECTION_QUEUE) return sts_net__set_error("Send queue is full");
+  if ((c->unreliable[c->unreliable_count] = sts_net_create_buffer(data, length)) == NULL) return -1;
+  ++c->unreliable_count;
+  return 0;
+}
+
+
+static float sts_net__random(sts_net_connection_t* c) {
+  // xorshift, so the simulation doesn't touch the state of rand()
+  c->random ^= (c->random << 13) & 0xffffffffUL;
+  c->random ^= c->random >> 17;
+  c->random ^= (c->random << 5) & 0xffffffffUL;
+  return (float)(c->random & 0xffffff) / 16777216.0f;
+}
+
+
+static int sts_net__transmit(sts_net_connection_t* c, const void* data, int length) {
+  sts_net_datagram_t datagram;
+
+  datagram.data = (void*)data;
+  datagram.size = datagram.length = length;
+  datagram.address = c->address;
+  return sts_net_send_datagrams(c->socket, &datagram, 1) < 0 ? -1 : 0;
+}
+
+
+// send the datagram through the network simulation
+static int sts_net__send_datagram(sts_net_connection_t* c, const unsigned char* data, int length, double now) {
+  sts_net__delayed_t  *delayed, **p;
+  double              delay;
+
+  ++c->info.sent;
+  if (c->loss > 0.0f && sts_net__random(c) < c->loss) {
+    ++c->info.dropped;
+    return 0;
+  }
+  delay = (double)c->latency + (double)c->jitter * (double)sts_net__random(c);
+  if (delay <= 0.0) return sts_net__transmit(c, data, length);
+  if ((delayed = (sts_net__delayed_t*)sts__malloc(sizeof(sts_net__delayed_t) + (size_t)length)) == NULL) {
+    return sts_net__set_error("Cannot allocate delayed datagram");
+  }
+  delayed->time = now + delay;
+  delayed->length = length;
+  sts__memcpy(delayed + 1, data, length);
+  // keep them sorted by time, jitter might reorder them
+  for (p = &c->delayed; *p && (*p)->time <= delayed->time; p = &(*p)->next) {}
+  delayed->next = *p;
+  *p = delayed;
+  return 0;
+}
+
+
+// write the header, record the datagram and send it
+static int sts_net__emit_datagram(sts_net_connection_t* c, unsigned char* data, int length, double now) {
+  sts_net__record_t* record = &c->records[c->sequence % STS_NET__DATAGRAM_RECORDS];
+
+  sts_net__write16(&data[0], c->sequence);
+  sts_net__write16(&data[2], c->remote_sequence < 0 ? 0 : c->remote_sequence);
+  data[4] = (unsigned char)(c->remote_bits >> 24);
+  data[5] = (unsigned char)(c->remote_bits >> 16);
+  data[6] = (unsigned char)(c->remote_bits >> 8);
+  data[7] = (unsigned char)c->remote_bits;
+  data[8] = c->remote_sequence < 0 ? 0 : STS_NET__HEADER_ACK;
+  record->sequence = c->sequence;
+  record->acked = 0;
+  record->time = now;
+  c->sequence = (c->sequence + 1) & 0xffff;
+  c->last_send = now;
+  c->ack_pending = 0;
+  return sts_net__send_datagram(c, data, length, now);
+}
+
+
+int sts_net_update_connection(sts_net_connection_t* c) {
+  unsigned char         data[STS_NET_CONNECTION_MTU];
+  sts_net__record_t*    record = &c->records[c->sequence % STS_NET__DATAGRAM_RECORDS];
+  sts_net__outgoing_t*  slot;
+  sts_net__delayed_t*   delayed;
+  double                now = sts_net__time();
+  int                   i, id, f, length = STS_NET__HEADER_SIZE, size, header, in_flight = 0;
+
+  // datagrams held back by the simulation
+  while ((delayed = c->delayed) != NULL && delayed->time <= now) {
+    c->delayed = delayed->next;
+    i = sts_net__transmit(c, delayed + 1, delayed->length);
+    sts__free(delayed);
+    if (i < 0) return -1;
+  }
+  if (now - c->last_receive > STS_NET_CONNECTION_TIMEOUT) return sts_net__set_error("Connection timed out");
+
+  record->count = 0;
+  // unreliable messages
+  for (i = 0; i < c->unreliable_count; ++i) {
+    size = c->unreliable[i]->length;
+    if (length + 5 + size > STS_NET_CONNECTION_MTU) {
+      if (sts_net__emit_datagram(c, data, length, now) < 0) return -1;
+      record = &c->records[c->sequence % STS_NET__DATAGRAM_RECORDS];
+      record->count = 0;
+      length = STS_NET__HEADER_SIZE;
+    }
+    data[length] = 0;
+    sts_net__write16(&data[length + 1], c->unreliable_id++);
+    sts_net__write16(&data[length + 3], size);
+    sts__memcpy(&data[length + 5], c->unreliable[i]->data, size);
+    length += 5 + size;
+    sts_net_release_buffer(c->unreliable[i]);
+  }
+  c->unreliable_count = 0;
+
+  // don't send more datagrams with fragments than can be acknowledged by a single ack field
+  for (i = 0; i < STS_NET__DATAGRAM_RECORDS; ++i) {
+    sts_net__record_t* r = &c->records[i];
+    if (r->sequence >= 0 && r->sequence != c->sequence && !r->acked && r->count > 0 && now - r->time < c->rto) ++in_flight;
+  }
+  // reliable fragments which were never sent or whose datagram wasn't acknowledged in time
+  for (id = c->send_base; id != c->send_id && in_flight < STS_NET__MAX_IN_FLIGHT; ++id) {
+    slot = &c->outgoing[id % STS_NET_CONNECTION_WINDOW];
+    if (!slot->buffer) continue;
+    for (f = 0; f < slot->fragments; ++f) {
+      if (slot->sent[f] < 0.0 || (slot->sent[f] > 0.0 && now - slot->sent[f] < c->rto)) continue;
+      size = slot->buffer->length - f * STS_NET_FRAGMENT_SIZE;
+      if (size > STS_NET_FRAGMENT_SIZE) size = STS_NET_FRAGMENT_SIZE;
+      header = slot->fragments > 1 ? 7 : 5;
+      if (length + header + size > STS_NET_CONNECTION_MTU || record->count >= STS_NET__DATAGRAM_REFS) {
+        if (record->count > 0 && ++in_flight >= STS_NET__MAX_IN_FLIGHT) break;
+        if (sts_net__emit_datagram(c, data, length, now) < 0) return -1;
+        record = &c->records[c->sequence % STS_NET__DATAGRAM_RECORDS];
+        record->count = 0;
+        length = STS_NET__HEADER_SIZE;
+      }
+      data[length] = STS_NET__MESSAGE_RELIABLE | (slot->fragments > 1 ? STS_NET__MESSAGE_FRAGMENT : 0);
+      sts_net__write16(&data[length + 1], slot->id);
+      if (slot->fragments > 1) {
+        data[length + 3] = (unsigned char)f;
+        data[length + 4] = (unsigned char)slot->fragments;
+      }
+      sts_net__write16(&data[length + header - 2], size);
+      sts__memcpy(&data[length + header], slot->buffer->data + f * STS_NET_FRAGMENT_SIZE, size);
+      length += header + size;
+      if (slot->sent[f] > 0.0) ++c->info.resent;
+      slot->sent[f] = now;
+      record->ids[record->count] = (unsigned short)slot->id;
+      record->fragments[record->count] = (unsigned char)f;
+      ++record->count;
+    }
+  }
+
+  // send the rest, acknowledge received datagrams and keep the connection alive
+  if (length > STS_NET__HEADER_SIZE || c->ack_pending || now - c->last_send >= 1.0) {
+    if (sts_net__emit_datagram(c, data, length, now) < 0) return -1;
+  }
+  return 0;
+}
+
+
+// the datagram with this sequence was acknowledged
+static void sts_net__process_ack(sts_net_connection_t* c, int sequence, double now) {
+  sts_net__record_t*    record = &c->records[sequence % STS_NET__DATAGRAM_RECORDS];
+  sts_net__outgoing_t*  slot;
+  double                rtt;
+  int                   i;
+
+  if (record->sequence != sequence || record->acked) return;
+  record->acked = 1;
+  // smoothed round trip time and resend timeout (RFC 6298)
+  rtt = now - record->time;
+  if (c->srtt <= 0.0) {
+    c->srtt = rtt;
+    c->rttvar = rtt / 2.0;
+  } else {
+    c->rttvar = 0.75 * c->rttvar + 0.25 * (c->srtt > rtt ? c->srtt - rtt : rtt - c->srtt);
+    c->srtt = 0.875 * c->srtt + 0.125 * rtt;
+  }
+  c->rto = c->srtt + 4.0 * c->rttvar;
+  if (c->rto < STS_NET_CONNECTION_MIN_RTO) c->rto = STS_NET_CONNECTION_MIN_RTO;
+  if (c->rto > 2.0) c->rto = 2.0;
+
+  for (i = 0; i < record->count; ++i) {
+    slot = &c->outgoing[record->ids[i] % STS_NET_CONNECTION_WINDOW];
+    if (!slot->buffer || (slot->id & 0xffff) != record->ids[i] || slot->sent[record->fragments[i]] < 0.0) continue;
+    slot->sent[record->fragments[i]] = -1.0;
+    if (++slot->acked == slot->fragments) {
+      sts_net_release_buffer(slot->buffer);
+      sts__free(slot->sent);
+      slot->buffer = NULL;
+      slot->sent = NULL;
+    }
+  }
+  while (c->send_base != c->send_id && !c->outgoing[c->send_base % STS_NET_CONNECTION_WINDOW].buffer) ++c->send_base;
+}
+
+
+// move completed reliable messages into the delivered queue
+static void sts_net__deliver_messages(sts_net_connection_t* c) {
+  sts_net__incoming_t* slot;
+
+  while (c->delivered_count < STS_NET_CONNECTION_QUEUE) {
+    slot = &c->incoming[c->receive_id % STS_NET_CONNECTION_WINDOW];
+    if (!slot->buffer || slot->id != c->receive_id || slot->received < slot->fragments) break;
+    slot->buffer->length = slot->length;
+    c->delivered[(c->delivered_head + c->delivered_count) % STS_NET_CONNECTION_QUEUE] = slot->buffer;
+    c->delivered_channels[(c->delivered_head + c->delivered_count) % STS_NET_CONNECTION_QUEUE] = STS_NET_RELIABLE;
+    ++c->delivered_count;
+    slot->buffer = NULL;
+    ++c->receive_id;
+  }
+}
+
+
+static void sts_net__receive_fragment(sts_net_connection_t* c, int wire_id, int index, int count, const unsigned char* data, int length) {
+  int                   id = c->receive_id + sts_net__sequence_diff(wire_id, c->receive_id);
+  sts_net__incoming_t*  slot;
+  unsigned char*        flags;
+
+  // already delivered or too far ahead (it will be resent)
+  if (id < c->receive_id || id - c->receive_id >= STS_NET_CONNECTION_WINDOW) return;
+  if (count < 1 || index >= count || length > STS_NET_FRAGMENT_SIZE || (index < count - 1 && length != STS_NET_FRAGMENT_SIZE)) return;
+  slot = &c->incoming[id % STS_NET_CONNECTION_WINDOW];
+  if (!slot->buffer) {
+    if ((slot->buffer = sts_net_create_buffer(NULL, count * STS_NET_FRAGMENT_SIZE + count)) == NULL) return;
+    sts__memset(slot->buffer->data + count * STS_NET_FRAGMENT_SIZE, 0, (size_t)count);
+    slot->id = id;
+    slot->fragments = count;
+    slot->received = 0;
+  }
+  if (slot->fragments != count) return;
+  flags = (unsigned char*)slot->buffer->data + count * STS_NET_FRAGMENT_SIZE;
+  if (flags[index]) return;
+  flags[index] = 1;
+  sts__memcpy(slot->buffer->data + index * STS_NET_FRAGMENT_SIZE, data, length);
+  if (index == count - 1) slot->length = index * STS_NET_FRAGMENT_SIZE + length;
+  ++slot->received;
+  sts_net__deliver_messages(c);
+}
+
+
+static void sts_net__receive_unreliable(sts_net_connection_t* c, int wire_id, const unsigned char* data, int length) {
+  int id = c->last_unreliable < 0 ? wire_id : c->last_unreliable + sts_net__sequence_diff(wire_id, c->last_unreliable);
+  int index;
+
+  // sequenced: drop everything older than the last delivered message
+  if (c->last_unreliable >= 0 && id <= c->last_unreliable) return;
+  if (c->delivered_count >= STS_NET_CONNECTION_QUEUE) return;
+  c->last_unreliable = id;
+  index = (c->delivered_head + c->delivered_count) % STS_NET_CONNECTION_QUEUE;
+  if ((c->delivered[index] = sts_net_create_buffer(data, length)) == NULL) return;
+  c->delivered_channels[index] = STS_NET_UNRELIABLE;
+  ++c->delivered_count;
+}
+
+
+int sts_net_process_datagram(sts_net_connection_t* c, const void* datagram, int length) {
+  const unsigned char*  data = (const unsigned char*)datagram;
+  double                now = sts_net__time();
+  unsigned long         bits, bit;
+  int                   sequence, ack, diff, i, type, header, size;
+
+  if (length < STS_NET__HEADER_SIZE) return sts_net__set_error("Received corrupted datagram");
+  sequence = sts_net__read16(&data[0]);
+  ack = sts_net__read16(&data[2]);
+  bits = ((unsigned long)data[4] << 24) | ((unsigned long)data[5] << 16) | ((unsigned long)data[6] << 8) | (unsigned long)data[7];
+
+  // remember the sequence for our acknowledgments, ignore duplicates
+  if (c->remote_sequence < 0) {
+    c->remote_sequence = sequence;
+    c->remote_bits = 0;
+  } else if ((diff = sts_net__sequence_diff(sequence, c->remote_sequence)) > 0) {
+    c->remote_bits = diff > 32 ? 0 : ((diff == 32 ? 0 : c->remote_bits << diff) | (1UL << (diff - 1))) & 0xffffffffUL;
+    c->remote_sequence = sequence;
+  } else {
+    if (diff == 0 || diff < -32) return 0;
+    bit = 1UL << (-diff - 1);
+    if (c->remote_bits & bit) return 0;
+    c->remote_bits |= bit;
+  }
+  ++c->info.received;
+  c->last_receive = now;
+  c->ack_pending = 1;
+
+  // acknowledgments (only if the other side received something, otherwise the ack field is empty)
+  if (data[8] & STS_NET__HEADER_ACK) {
+    sts_net__process_ack(c, ack, now);
+    for (i = 0; i < 32; ++i) {
+      if (bits & (1UL << i)) sts_net__process_ack(c, (ack - 1 - i) & 0xffff, now);
+    }
+  }
+
+  // messages
+  for (i = STS_NET__HEADER_SIZE; i < length; i += header + size) {
+    type = data[i];
+    header = (type & STS_NET__MESSAGE_FRAGMENT) ? 7 : 5;
+    if (length - i < header) return sts_net__set_error("Received corrupted datagram");
+    size = sts_net__read16(&data[i + header - 2]);
+    if (size > length - i - header) return sts_net__set_error("Received corrupted datagram");
+    if (type & STS_NET__MESSAGE_RELIABLE) {
+      if (header == 7) {
+        sts_net__receive_fragment(c, sts_net__read16(&data[i + 1]), data[i + 3], data[i + 4], &data[i + header], size);
+      } else {
+        sts_net__receive_fragment(c, sts_net__read16(&data[i + 1]), 0, 1, &data[i + header], size);
+      }
+    } else {
+      sts_net__receive_unreliable(c, sts_net__read16(&data[i + 1]), &data[i + header], size);
+    }
+  }
+  return 0;
+}
+
+
+sts_net_buffer_t* sts_net_receive_message(sts_net_connection_t* c, int* channel) {
+  sts_net_buffer_t* buffer;
+
+  if (c->delivered_count == 0) return NULL;
+  buffer = c->delivered[c->delivered_head];
+  if (channel) *channel = c->delivered_channels[c->delivered_head];
+  c->delivered_head = (c->delivered_head + 1) % STS_NET_CONNECTION_QUEUE;
+  --c->delivered_count;
+  // there's room for reliable messages which were waiting
+  sts_net__deliver_messages(c);
+  return buffer;
+}
+
+
+void sts_net_simulate_network(sts_net_connection_t* c, float loss, float latency, float jitter) {
+  c->loss = loss;
+  c->latency = latency;
+  c->jitter = jitter;
+}
+
+
+void sts_net_get_connection_info(sts_net_connection_t* c, sts_net_connection_info_t* info) {
+  *info = c->info;
+  info->rtt = (float)c->srtt;
+  info->rto = (float)c->rto;
+  info->pending = c->send_id - c->send_base;
+}
+
+
+#ifndef STS_NET_NO_PACKETS
+// receive data into two buffers with a single call
+static int sts_net__recv_spans(sts_net_socket_t* socket, char* data0, int length0, char* data1, int length1) {
+#ifdef _WIN32
+  WSABUF        buffers[2];
+  DWORD         received = 0, flags = 0;
+
+  buffers[0].buf = data0; buffers[0].len = (ULONG)length0;
+  buffers[1].buf = data1; buffers[1].len = (ULONG)length1;
+  socket->ready = 0;
+  STS_NET__COUNT(socket, syscalls_in, 1);
+  if (WSARecv((SOCKET)socket->fd, buffers, length1 > 0 ? 2 : 1, &received, &flags, NULL, NULL) == SOCKET_ERROR) {
+    return sts_net__set_error("Cannot receive data");
+  }
+  STS_NET__COUNT(socket, bytes_in, received);
+  return (int)received;
+#else
+  struct iovec  buffers[2];
+  struct msghdr msg;
+  int           result;
+
+  buffers[0].iov_base = data0; buffers[0].iov_len = (size_t)length0;
+  buffers[1].iov_base = data1; buffers[1].iov_len = (size_t)length1;
+  sts__memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = buffers;
+  msg.msg_iovlen = length1 > 0 ? 2 : 1;
+  socket->ready = 0;
+  if (socket->shared) {
+    if ((result = sts_net__shared_read(socket, data0, length0, data1, length1)) < 0) return -1;
+    STS_NET__COUNT(socket, bytes_in, result);
+    return result;
+  }
+  result = (int)recvmsg(socket->fd, &msg, 0);
+  STS_NET__COUNT(socket, syscalls_in, 1);
+  if (result < 0) {
+    return sts_net__set_error("Cannot receive data");
+  }
+  STS_NET__COUNT(socket, bytes_in, result);
+  return result;
+#endif // _WIN32
+}
+
+
+// send two buffers with a single call
+static int sts_net__send_spans(sts_net_socket_t* socket, const char* data0, int length0, const char* data1, int length1) {
+#ifdef _WIN32
+  WSABUF        buffers[2];
+  DWORD         sent = 0;
+
+  buffers[0].buf = (CHAR*)data0; buffers[0].len = (ULONG)length0;
+  buffers[1].buf = (CHAR*)data1; buffers[1].len = (ULONG)length1;
+  STS_NET__COUNT(socket, syscalls_out, 1);
+  if (WSASend((SOCKET)socket->fd, buffers, length1 > 0 ? 2 : 1, &sent, 0, NULL, NULL) == SOCKET_ERROR || (int)sent != length0 + length1) {
+    return sts_net__set_error("Cannot send data");
+  }
+  STS_NET__COUNT(socket, bytes_out, sent);
+  return 0;
+#else
+  struct iovec  buffers[2];
+  struct msghdr msg;
+
+  buffers[0].iov_base = (void*)data0; buffers[0].iov_len = (size_t)length0;
+  buffers[1].iov_base = (void*)data1; buffers[1].iov_len = (size_t)length1;
+  sts__memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = buffers;
+  msg.msg_iovlen = length1 > 0 ? 2 : 1;
+  if (socket->shared) {
+    if (sts_net__shared_write(socket, buffers, length1 > 0 ? 2 : 1, 1) < 0) return -1;
+    STS_NET__COUNT(socket, bytes_out, length0 + length1);
+    return 0;
+  }
+  STS_NET__COUNT(socket, syscalls_out, 1);
+  if (sendmsg(socket->fd, &msg, 0) != length0 + length1) {
+    return sts_net__set_error("Cannot send data");
+  }
+  STS_NET__COUNT(socket, bytes_out, length0 + length1);
+  return 0;
+#endif // _WIN32
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Packet buffer pool
+//
+#define STS_NET__POOL_CLASSES   20
+
+typedef struct sts_net__pool_buffer_t {
+  struct sts_net__pool_buffer_t*  next;
+} sts_net__pool_buffer_t;
+
+static STS_NET__THREAD_LOCAL sts_net__pool_buffer_t*  sts_net__pool[STS_NET__POOL_CLASSES];
+static STS_NET__THREAD_LOCAL int                      sts_net__pool_count[STS_NET__POOL_CLASSES];
+
+
+static int sts_net__pool_class(int size) {
+  int           c;
+  unsigned long class_size;
+  for (c = 0, class_size = STS_NET_POOL_MIN_SIZE; c < STS_NET__POOL_CLASSES; ++c, class_size *= 2) {
+    if (class_size >= (unsigned long)size) return c;
+  }
+  return -1;
+}
+
+
+// get a buffer which can hold at least "size" bytes from the pool, "size" is set to the real size of the buffer
+static char* sts_net__pool_get(int* size) {
+  int                     c = sts_net__pool_class(*size);
+  sts_net__pool_buffer_t* buffer;
+
+  if (c < 0) {
+    sts_net__set_error("Packet buffer is too large");
+    return NULL;
+  }
+  buffer = sts_net__pool[c];
+  if (buffer) {
+    sts_net__pool[c] = buffer->next;
+    --sts_net__pool_count[c];
+  } else {
+    buffer = (sts_net__pool_buffer_t*)sts__malloc((size_t)STS_NET_POOL_MIN_SIZE << c);
+    if (!buffer) {
+      sts_net__set_error("Cannot allocate packet buffer");
+      return NULL;
+    }
+  }
+  *size = STS_NET_POOL_MIN_SIZE << c;
+  return (char*)buffer;
+}
+
+
+// give a buffer back to the pool
+static void sts_net__pool_put(char* data, int size) {
+  int                     c = sts_net__pool_class(size);
+  sts_net__pool_buffer_t* buffer = (sts_net__pool_buffer_t*)data;
+
+  if (sts_net__pool_count[c] < STS_NET_POOL_KEEP) {
+    buffer->next = sts_net__pool[c];
+    sts_net__pool[c] = buffer;
+    ++sts_net__pool_count[c];
+  } else {
+    sts__free(buffer);
+  }
+}
+
+
+// borrow a buffer which can hold at least "size" bytes
+static int sts_net__borrow_buffer(sts_net_socket_t* socket, int size) {
+  char* buffer = sts_net__pool_get(&size);
+
+  if (!buffer) return -1;
+  socket->data = buffer;
+  socket->size = size;
+  return 0;
+}
+
+
+// give the buffer of the socket back to the pool
+static void sts_net__release_buffer(sts_net_socket_t* socket) {
+  if (!socket->data) return;
+  sts_net__pool_put(socket->data, socket->size);
+  socket->data = NULL;
+  socket->size = 0;
+  socket->offset = 0;
+}
+
+
+// give the buffer of the decompressed packet back to the pool
+static void sts_net__release_unpacked(sts_net_socket_t* socket) {
+  if (!socket->unpacked) return;
+  sts_net__pool_put(socket->unpacked, socket->unpacked_size);
+  socket->unpacked = NULL;
+  socket->unpacked_length = 0;
+  socket->unpacked_size = 0;
+}
+
+
+// move all received data into a bigger buffer, so a large packet fits into it
+static int sts_net__grow_buffer(sts_net_socket_t* socket, int size) {
+  sts_net_socket_t  old = *socket;
+  int               first;
+
+  if (sts_net__borrow_buffer(socket, size) < 0) return -1;
+  first = old.size - old.offset;
+  if (first >= old.received) {
+    sts__memcpy(socket->data, &old.data[old.offset], old.received);
+  } else {
+    sts__memcpy(socket->data, &old.data[old.offset], first);
+    sts__memcpy(&socket->data[first], old.data, old.received - first);
+  }
+  socket->offset = 0;
+  sts_net__release_buffer(&old);
+  return 0;
+}
+
+
+#ifdef STS_NET__URING
+// append data to the ring buffer of the socket (used if the data wasn't received by sts_net_refill_packet_data)
+static int sts_net__append_packet_data(sts_net_socket_t* socket, const char* data, int length) {
+  int end, first;
+
+  if (!socket->data) {
+    if (sts_net__borrow_buffer(socket, length > STS_NET_POOL_MIN_SIZE ? length : STS_NET_POOL_MIN_SIZE) < 0) return -1;
+  } else if (socket->size - socket->received < length) {
+    if (sts_net__grow_buffer(socket, socket->received + length) < 0) return -1;
+  }
+  end = (socket->offset + socket->received) % socket->size;
+  first = socket->size - end;
+  if (first >= length) {
+    sts__memcpy(&socket->data[end], data, length);
+  } else {
+    sts__memcpy(&socket->data[end], data, first);
+    sts__memcpy(socket->data, &data[first], length - first);
+  }
+  socket->received += length;
+  return 0;
+}
+#endif // STS_NET__URING
+
+
+void sts_net_trim_pool() {
+  int                     c;
+  sts_net__pool_buffer_t* buffer;
+
+  for (c = 0; c < STS_NET__POOL_CLASSES; ++c) {
+    while ((buffer = sts_net__pool[c]) != NULL) {
+      sts_net__pool[c] = buffer->next;
+      sts__free(buffer);
+    }
+    sts_net__pool_count[c] = 0;
+  }
+}
+
+
+int sts_net_refill_packet_data(sts_net_socket_t* socket) {
+  int end, space, first, received;
+
+  if (!socket->ready) return 0;
+  if (socket->server) {
+    return sts_net__set_error("Cannot receive on server socket");
+  }
+  if (socket->datagram) {
+    return sts_net__set_error("Cannot receive packets on datagram socket");
+  }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot receive on closed socket");
+  }
+  if (!socket->data && sts_net__borrow_buffer(socket, STS_NET_POOL_MIN_SIZE) < 0) return -1;
+  space = socket->size - socket->received;
+  if (space <= 0) return 0;
+  // the free part of the ring buffer might wrap around, so receive into both spans at once
+  end = (socket->offset + socket->received) % socket->size;
+  first = socket->size - end;
+  if (first > space) first = space;
+  received = sts_net__recv_spans(socket, &socket->data[end], first, &socket->data[0], space - first);
+  if (received < 0) return -1;
+  if (received == 0) return sts_net__set_error("Connection closed by remote host");
+  socket->received += received;
+  return 1;
+}
+
+
+// get a byte of the received data
+static int sts_net__peek_byte(sts_net_socket_t* socket, int index) {
+  return (unsigned char)socket->data[(socket->offset + index) % socket->size];
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Packet compression
+//
+//  A small LZ codec (similar to LZ4) which doesn't need any state, so it works well for small packets.
+//  Every sequence starts with a token byte: the high nibble is the amount of literals, the low nibble
+//  the match length minus 4. A nibble of 15 is followed by bytes which are added to it until a byte
+//  is less than 255. The literals follow, then the match offset (2 bytes, little endian) and the
+//  extra bytes of the match length. The last sequence only has literals.
+//  Matches can reach back into the preset dictionary, which is treated as data before the packet.
+//
+#define STS_NET__LZ_HASH_BITS   12
+#define STS_NET__LZ_MAX_OFFSET  65535
+
+static const unsigned char* sts_net__dictionary = NULL;
+static int                  sts_net__dictionary_length = 0;
+static int                  sts_net__dictionary_hash[1 << STS_NET__LZ_HASH_BITS];
+
+// The hash table of the compressor. Entries written by an older call are stale and fall back to
+// the hash table of the dictionary, so it doesn't have to be copied for every packet.
+typedef struct {
+  unsigned int  epoch;      // the call which wrote the entry
+  int           position;
+} sts_net__lz_entry_t;
+
+static STS_NET__THREAD_LOCAL sts_net__lz_entry_t  sts_net__lz_table[1 << STS_NET__LZ_HASH_BITS];
+static STS_NET__THREAD_LOCAL unsigned int         sts_net__lz_epoch = 0;
+
+
+static int sts_net__lz_hash(const unsigned char* p) {
+  unsigned long v = (unsigned long)p[0] | ((unsigned long)p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+  return (int)(((v * 2654435761UL) & 0xffffffffUL) >> (32 - STS_NET__LZ_HASH_BITS));
+}
+
+
+void sts_net_set_compression_dictionary(const void* dictionary, int length) {
+  int i;
+
+  if (!dictionary || length < 0) length = 0;
+  if (length > STS_NET__LZ_MAX_OFFSET) {
+    dictionary = (const unsigned char*)dictionary + length - STS_NET__LZ_MAX_OFFSET;
+    length = STS_NET__LZ_MAX_OFFSET;
+  }
+  sts_net__dictionary = (const unsigned char*)dictionary;
+  sts_net__dictionary_length = length;
+  // the hash table of the dictionary is the starting point of every compression
+  for (i = 0; i < (1 << STS_NET__LZ_HASH_BITS); ++i) sts_net__dictionary_hash[i] = -1;
+  for (i = 0; i + 4 <= length; ++i) sts_net__dictionary_hash[sts_net__lz_hash(&sts_net__dictionary[i])] = i;
+}
+
+
+// write a nibble overflow, returns the new output position or -1 if it doesn't fit
+static int sts_net__lz_write_length(unsigned char* dst, int op, int capacity, int length) {
+  for (; length >= 255; length -= 255) {
+    if (op >= capacity) return -1;
+    dst[op++] = 255;
+  }
+  if (op >= capacity) return -1;
+  dst[op++] = (unsigned char)length;
+  return op;
+}
+
+
+// compress "length" bytes, returns the compressed size or -1 if it doesn't fit into "capacity" bytes
+static int sts_net__lz_compress(const unsigned char* src, int length, unsigned char* dst, int capacity) {
+  const unsigned char*  dict = sts_net__dictionary;
+  int                   dict_length = sts_net__dictionary_length;
+  sts_net__lz_entry_t*  table = sts_net__lz_table;
+  unsigned int          epoch;
+  int                   i = 0, anchor = 0, op = 0, h, ref, match, literals, token;
+
+  // start with a fresh table, clear it only when the epoch wraps around
+  if ((epoch = ++sts_net__lz_epoch) == 0) {
+    sts__memset(sts_net__lz_table, 0, sizeof(sts_net__lz_table));
+    epoch = sts_net__lz_epoch = 1;
+  }
+  // positions are counted from the start of the dictionary, so matches can refer to it
+  while (i + 4 <= length) {
+    h = sts_net__lz_hash(&src[i]);
+    ref = table[h].epoch == epoch ? table[h].position : sts_net__dictionary_hash[h];
+    table[h].epoch = epoch;
+    table[h].position = dict_length + i;
+    if (ref < 0 || dict_length + i - ref > STS_NET__LZ_MAX_OFFSET) {
+      ++i;
+      continue;
+    }
+    for (match = 0; i + match < length; ++match) {
+      int p = ref + match;
+      if ((p < dict_length ? dict[p] : src[p - dict_length]) != src[i + match]) break;
+    }
+    if (match < 4) {
+      ++i;
+      continue;
+    }
+    // emit the literals and the match
+    literals = i - anchor;
+    token = (literals < 15 ? literals : 15) << 4 | (match - 4 < 15 ? match - 4 : 15);
+    if (op >= capacity) return -1;
+    dst[op++] = (unsigned char)token;
+    if (literals >= 15 && (op = sts_net__lz_write_length(dst, op, capacity, literals - 15)) < 0) return -1;
+    if (capacity - op < literals + 2) return -1;
+    sts__memcpy(&dst[op], &src[anchor], literals);
+    op += literals;
+    dst[op++] = (unsigned char)(dict_length + i - ref);
+    dst[op++] = (unsigned char)((dict_length + i - ref) >> 8);
+    if (match - 4 >= 15 && (op = sts_net__lz_write_length(dst, op, capacity, match - 4 - 15)) < 0) return -1;
+    i += match;
+    anchor = i;
+  }
+  // the last literals
+  literals = length - anchor;
+  if (op >= capacity) return -1;
+  dst[op++] = (unsigned char)((literals < 15 ? literals : 15) << 4);
+  if (literals >= 15 && (op = sts_net__lz_write_length(dst, op, capacity, literals - 15)) < 0) return -1;
+  if (capacity - op < literals) return -1;
+  sts__memcpy(&dst[op], &src[anchor], literals);
+  return op + literals;
+}
+
+
+// decompress exactly "size" bytes, returns -1 if the data is corrupted
+static int sts_net__lz_decompress(const unsigned char* src, int length, unsigned char* dst, int size) {
+  const unsigned char*  dict = sts_net__dictionary;
+  int                   dict_length = sts_net__dictionary_length;
+  int                   ip = 0, op = 0, literals, match, offset, c, p;
+
+  while (ip < length) {
+    c = src[ip++];
+    literals = c >> 4;
+    if (literals == 15) {
+      do {
+        if (ip >= length) return -1;
+        literals += src[ip];
+      } while (src[ip++] == 255 && literals < size);
+    }
+    if (literals > length - ip || literals > size - op) return -1;
+    sts__memcpy(&dst[op], &src[ip], literals);
+    ip += literals;
+    op += literals;
+    if (ip == length) break;  // the last sequence has no match
+    if (length - ip < 2) return -1;
+    offset = src[ip] | (src[ip + 1] << 8);
+    ip += 2;
+    match = c & 15;
+    if (match == 15) {
+      do {
+        if (ip >= length) return -1;
+        match += src[ip];
+      } while (src[ip++] == 255 && match < size);
+    }
+    match += 4;
+    if (offset == 0 || offset > op + dict_length || match > size - op) return -1;
+    if (offset <= op && offset >= match) {
+      sts__memcpy(&dst[op], &dst[op - offset], match);
+      op += match;
+    } else {
+      // overlapping or in the dictionary
+      for (; match > 0; --match, ++op) {
+        p = op - offset;
+        dst[op] = p >= 0 ? dst[p] : dict[dict_length + p];
+      }
+    }
+  }
+  return op == size ? 0 : -1;
+}
+
+
+// write a compressed packet (header + size + LZ sequences) into "dst" which can hold "capacity" bytes
+// returns the size of the packet or -1 if it wouldn't be smaller than "capacity"
+static int sts_net__compress_packet(unsigned char* dst, int capacity, const void* data, int length) {
+  int op = 6, compressed, size = length;
+
+  // the decompressed size, 7 bits per byte
+  do {
+    if (op >= capacity) return -1;
+    dst[op++] = (unsigned char)((size & 0x7f) | (size > 0x7f ? 0x80 : 0));
+    size >>= 7;
+  } while (size != 0);
+  if ((compressed = sts_net__lz_compress((const unsigned char*)data, length, &dst[op], capacity - op)) < 0) return -1;
+  compressed += op - 6;
+  dst[0] = dst[1] = 0xff;
+  dst[2] = (unsigned char)(0x80 | (compressed >> 24));
+  dst[3] = (unsigned char)(compressed >> 16);
+  dst[4] = (unsigned char)(compressed >> 8);
+  dst[5] = (unsigned char)compressed;
+  return compressed + 6;
+}
+
+
+// decompress the current packet into a buffer from the pool
+static int sts_net__unpack_packet(sts_net_socket_t* socket) {
+  const unsigned char*  src;
+  char*                 buffer;
+  int                   first = socket->size - socket->offset, length = socket->packet_length, size = 0, shift = 0, i = 0, c, total;
+
+  // the decompressed size
+  do {
+    if (i >= length || shift > 28) return sts_net__set_error("Received corrupted compressed packet");
+    c = sts_net__peek_byte(socket, i++);
+    size |= (c & 0x7f) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  if (size < 0 || size > STS_NET_PACKET_SIZE) return sts_net__set_error("Received packet was too large");
+  // if the packet wraps around the end of the ring, the compressed data is copied behind the decompressed data
+  total = size + (first < length ? length : 0);
+  if ((buffer = sts_net__pool_get(&total)) == NULL) return -1;
+  if (first < length) {
+    sts__memcpy(&buffer[size], &socket->data[socket->offset], first);
+    sts__memcpy(&buffer[size + first], socket->data, length - first);
+    src = (const unsigned char*)&buffer[size];
+  } else {
+    src = (const unsigned char*)&socket->data[socket->offset];
+  }
+  if (sts_net__lz_decompress(src + i, length - i, (unsigned char*)buffer, size) < 0) {
+    sts_net__pool_put(buffer, total);
+    return sts_net__set_error("Received corrupted compressed packet");
+  }
+  socket->unpacked = buffer;
+  socket->unpacked_length = size;
+  socket->unpacked_size = total;
+  return 0;
+}
+
+
+
+
+int sts_net_receive_packet(sts_net_socket_t* socket) {
+  int header = 2;
+
+  if (socket->packet_length < 0) {
+    socket->compressed = 0;
+    if (socket->received < 2) return 0;
+    socket->packet_length = sts_net__peek_byte(socket, 0) * 256 + sts_net__peek_byte(socket, 1);
+    if (socket->packet_length == 0xffff) {
+      // wide length prefix
+      if (socket->received < 6) {
+        socket->packet_length = -1;
+        return 0;
+      }
+      // the highest bit marks compressed packets
+      socket->compressed = (sts_net__peek_byte(socket, 2) & 0x80) != 0;
+      socket->packet_length = (int)(((unsigned long)(sts_net__peek_byte(socket, 2) & 0x7f) << 24) | ((unsigned long)sts_net__peek_byte(socket, 3) << 16) |
+                                    ((unsigned long)sts_net__peek_byte(socket, 4) << 8) | (unsigned long)sts_net__peek_byte(socket, 5));
+      header = 6;
+    }
+    if (socket->packet_length < 0 || socket->packet_length > STS_NET_PACKET_SIZE) {
+      sts_net_close_socket(socket);
+      return sts_net__set_error("Received packet was too large");
+    }
+    socket->received -= header;
+    socket->offset = (socket->offset + header) % socket->size;
+    if (socket->packet_length > socket->size && sts_net__grow_buffer(socket, socket->packet_length) < 0) {
+      sts_net_close_socket(socket);
+      return -1;
+    }
+  }
+  if (socket->received < socket->packet_length) return 0;
+  if (socket->compressed && !socket->unpacked && sts_net__unpack_packet(socket) < 0) {
+    sts_net_close_socket(socket);
+    return -1;
+  }
+  return 1;
+}
+
+
+void sts_net_get_packet(sts_net_socket_t* socket, sts_net_packet_t* packet) {
+  int first = socket->size - socket->offset;
+
+  if (socket->unpacked) {
+    packet->data[0] = socket->unpacked;
+    packet->length[0] = socket->unpacked_length;
+    packet->data[1] = NULL;
+    packet->length[1] = 0;
+  } else if (first >= socket->packet_length) {
+    packet->data[0] = socket->data ? &socket->data[socket->offset] : NULL;
+    packet->length[0] = socket->packet_length;
+    packet->data[1] = NULL;
+    packet->length[1] = 0;
+  } else {
+    packet->data[0] = &socket->data[socket->offset];
+    packet->length[0] = first;
+    packet->data[1] = &socket->data[0];
+    packet->length[1] = socket->packet_length - first;
+  }
+}
+
+
+void sts_net_drop_packet(sts_net_socket_t* socket) {
+  if ((socket->packet_length >= 0) && (socket->received >= socket->packet_length)) {
+    STS_NET__COUNT(socket, packets_in, 1);
+    sts_net__release_unpacked(socket);
+    socket->compressed = 0;
+    socket->received -= socket->packet_length;
+    if (socket->received == 0) {
+      // nothing pending anymore, so the buffer can be used by other sockets
+      sts_net__release_buffer(socket);
+    } else {
+      socket->offset = (socket->offset + socket->packet_length) % socket->size;
+    }
+    socket->packet_length = -1;
+  }
+}
+
+
+// write the packet size prefix, returns the length of the prefix
+static int sts_net__write_packet_header(unsigned char* header, int length) {
+  if (length < 0xffff) {
+    header[0] = (unsigned char)(length >> 8);
+    header[1] = (unsigned char)length;
+    return 2;
+  }
+  header[0] = header[1] = 0xff;
+  header[2] = (unsigned char)(length >> 24);
+  header[3] = (unsigned char)(length >> 16);
+  header[4] = (unsigned char)(length >> 8);
+  header[5] = (unsigned char)length;
+  return 6;
+}
+
+
+int sts_net_send_packet(sts_net_socket_t* socket, const void* data, int length) {
+  unsigned char header[6];
+
+  if (socket->server) {
+    return sts_net__set_error("Cannot send on server socket");
+  }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot send on closed socket");
+  }
+  if (length < 0 || length > STS_NET_PACKET_SIZE) {
+    return sts_net__set_error("Packet is too large");
+  }
+  if (sts_net__send_spans(socket, (const char*)header, sts_net__write_packet_header(header, length), (const char*)data, length) < 0) return -1;
+  STS_NET__COUNT(socket, packets_out, 1);
+  return 0;
+}
+
+
+sts_net_buffer_t* sts_net_create_packet_buffer(const void* data, int length) {
+  unsigned char     header[6];
+  int               header_length;
+  sts_net_buffer_t* buffer;
+
+  if (length < 0 || length > STS_NET_PACKET_SIZE) {
+    sts_net__set_error("Packet is too large");
+    return NULL;
+  }
+  header_length = sts_net__write_packet_header(header, length);
+  buffer = sts_net_create_buffer(NULL, header_length + length);
+  if (!buffer) return NULL;
+  sts__memcpy(buffer->data, header, header_length);
+  sts__memcpy(buffer->data + header_length, data, length);
+  return buffer;
+}
+
+
+int sts_net_send_compressed_packet(sts_net_socket_t* socket, const void* data, int length) {
+  char* buffer;
+  int   size, capacity, result;
+
+  if (socket->server) {
+    return sts_net__set_error("Cannot send on server socket");
+  }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot send on closed socket");
+  }
+  if (length < 0 || length > STS_NET_PACKET_SIZE) {
+    return sts_net__set_error("Packet is too large");
+  }
+  // only use the compressed packet if it's smaller than the uncompressed one
+  capacity = size = length + (length < 0xffff ? 2 : 6);
+  if ((buffer = sts_net__pool_get(&size)) == NULL) return -1;
+  if ((capacity = sts_net__compress_packet((unsigned char*)buffer, capacity - 1, data, length)) < 0) {
+    result = sts_net_send_packet(socket, data, length);
+  } else if ((result = sts_net__send_spans(socket, buffer, capacity, NULL, 0)) == 0) {
+    STS_NET__COUNT(socket, packets_out, 1);
+  }
+  sts_net__pool_put(buffer, size);
+  return result;
+}
+
+
+sts_net_buffer_t* sts_net_create_compressed_packet_buffer(const void* data, int length) {
+  sts_net_buffer_t* buffer;
+  int               capacity, size;
+
+  if (length < 0 || length > STS_NET_PACKET_SIZE) {
+    sts_net__set_error("Packet is too large");
+    return NULL;
+  }
+  capacity = length + (length < 0xffff ? 2 : 6);
+  if ((buffer = sts_net_create_buffer(NULL, capacity)) == NULL) return NULL;
+  if ((size = sts_net__compress_packet((unsigned char*)buffer->data, capacity - 1, data, length)) < 0) {
+    sts_net_release_buffer(buffer);
+    return sts_net_create_packet_buffer(data, length);
+  }
+  // the buffer stays a bit larger, but only "length" bytes are sent
+  buffer->length = size;
+  return buffer;
+}
+
+
+#endif // STS_NET_NO_PACKETS
+
+
+#ifndef STS_NET_NO_THREADS
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Threads
+//
+typedef struct {
+  void  (*func)(void*);
+  void* arg;
+} sts_net__thread_start_t;
+
+
+#ifdef _WIN32
+static DWORD WINAPI sts_net__thread_main(LPVOID arg) {
+#else
+static void* sts_net__thread_main(void* arg) {
+#endif // _WIN32
+  sts_net__thread_start_t start = *(sts_net__thread_start_t*)arg;
+  sts__free(arg);
+  start.func(start.arg);
+#ifndef STS_NET_NO_PACKETS
+  sts_net_trim_pool();
+#endif // STS_NET_NO_PACKETS
+  return 0;
+}
+
+
+static int sts_net__start_thread(void** thread, void (*func)(void*), void* arg) {
+  sts_net__thread_start_t* start = (sts_net__thread_start_t*)sts__malloc(sizeof(sts_net__thread_start_t));
+
+  if (!start) return sts_net__set_error("Cannot allocate thread");
+  start->func = func;
+  start->arg = arg;
+#ifdef _WIN32
+  *thread = (void*)CreateThread(NULL, 0, sts_net__thread_main, start, 0, NULL);
+  if (*thread == NULL) {
+    sts__free(start);
+    return sts_net__set_error("Cannot create thread");
+  }
+#else
+  *thread = sts__malloc(sizeof(pthread_t));
+  if (!*thread || pthread_create((pthread_t*)*thread, NULL, sts_net__thread_main, start) != 0) {
+    sts__free(*thread);
+    sts__free(start);
+    *thread = NULL;
+    return sts_net__set_error("Cannot create thread");
+  }
+#endif // _WIN32
+  return 0;
+}
+
+
+static void sts_net__join_thread(void* thread) {
+  if (!thread) return;
+#ifdef _WIN32
+  WaitForSingleObject((HANDLE)thread, INFINITE);
+  CloseHandle((HANDLE)thread);
+#else
+  pthread_join(*(pthread_t*)thread, NULL);
+  sts__free(thread);
+#endif // _WIN32
+}
+
+
+// create two connected sockets, used to wake up threads waiting in sts_net_check_socket_set
+static int sts_net__open_socket_pair(sts_net_socket_t* reader, sts_net_socket_t* writer) {
+  sts_net_reset_socket(reader);
+  sts_net_reset_socket(writer);
+#ifdef _WIN32
+  {
+    struct sockaddr_in  addr;
+    socklen_t           addr_length = sizeof(addr);
+    SOCKET              listener = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (listener == INVALID_SOCKET) return sts_net__set_error("Could not create socket");
+    sts__memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        getsockname(listener, (struct sockaddr*)&addr, &addr_length) == SOCKET_ERROR ||
+        listen(listener, 1) == SOCKET_ERROR) {
+      closesocket(listener);
+      return sts_net__set_error("Could not create socket pair");
+    }
+    writer->fd = (int)socket(AF_INET, SOCK_STREAM, 0);
+    if (writer->fd == INVALID_SOCKET || connect(writer->fd, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+      closesocket(listener);
+      sts_net_close_socket(writer);
+      return sts_net__set_error("Could not create socket pair");
+    }
+    reader->fd = (int)accept(listener, NULL, NULL);
+    closesocket(listener);
+    if (reader->fd == INVALID_SOCKET) {
+      sts_net_close_socket(writer);
+      return sts_net__set_error("Could not create socket pair");
+    }
+  }
+#else
+  {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) return sts_net__set_error("Could not create socket pair");
+    reader->fd = fds[0];
+    writer->fd = fds[1];
+  }
+#endif // _WIN32
+  return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Reactor
+//
+static void sts_net__shard_main(void* arg) {
+  sts_net_shard_t* shard = (sts_net_shard_t*)arg;
+  shard->func(shard);
+}
+
+
+static void sts_net__close_shard(sts_net_shard_t* shard) {
+  sts_net_message_t* message;
+
+  sts_net_close_socket(&shard->listen_socket);
+  sts_net_close_socket(&shard->wakeup_socket);
+  sts_net_close_socket(&shard->notify_socket);
+  while ((message = sts_net_next_message(shard)) != NULL) sts_net_free_message(message);
+}
+
+
+int sts_net_start_reactor(sts_net_reactor_t* reactor, const char* service, int num_shards, sts_net_shard_func func, void* userdata) {
+  int               i;
+  sts_net_shard_t*  shard;
+
+#ifdef _WIN32
+  (void)service; (void)num_shards; (void)func; (void)userdata;
+  reactor->running = 0;
+  reactor->num_shards = 0;
+  return sts_net__set_error("The reactor is not supported on Windows");
+#else
+  if (num_shards < 1 || num_shards > STS_NET_REACTOR_SHARDS) {
+    return sts_net__set_error("Invalid amount of shards");
+  }
+  reactor->running = 1;
+  reactor->num_shards = 0;
+  for (i = 0; i < num_shards; ++i) {
+    shard = &reactor->shards[i];
+    shard->index = i;
+    shard->reactor = reactor;
+    shard->userdata = userdata;
+    shard->func = func;
+    shard->inbox = shard->head = NULL;
+    shard->thread = NULL;
+    sts_net_init_socket_set(&shard->set);
+    if (sts_net__open_socket(&shard->listen_socket, NULL, service, SOCK_STREAM, 1) < 0) break;
+    if (sts_net__open_socket_pair(&shard->wakeup_socket, &shard->notify_socket) < 0) {
+      sts_net_close_socket(&shard->listen_socket);
+      break;
+    }
+    sts_net_add_socket_to_set(&shard->listen_socket, &shard->set);
+    sts_net_add_socket_to_set(&shard->wakeup_socket, &shard->set);
+    ++reactor->num_shards;
+  }
+  if (reactor->num_shards == num_shards) {
+    for (i = 0; i < num_shards; ++i) {
+      if (sts_net__start_thread(&reactor->shards[i].thread, sts_net__shard_main, &reactor->shards[i]) < 0) break;
+    }
+    if (i == num_shards) return 0;
+  }
+  // something failed, so clean up everything
+  sts_net_stop_reactor(reactor);
+  return -1;
+#endif // _WIN32
+}
+
+
+void sts_net_stop_reactor(sts_net_reactor_t* reactor) {
+  int i;
+
+  STS_NET__STORE(&reactor->running, 0);
+  for (i = 0; i < reactor->num_shards; ++i) {
+    send(reactor->shards[i].notify_socket.fd, "", 1, 0);
+  }
+  for (i = 0; i < reactor->num_shards; ++i) {
+    sts_net__join_thread(reactor->shards[i].thread);
+    reactor->shards[i].thread = NULL;
+    sts_net__close_shard(&reactor->shards[i]);
+  }
+  reactor->num_shards = 0;
+}
+
+
+int sts_net_is_reactor_running(sts_net_reactor_t* reactor) {
+  return STS_NET__LOAD(&reactor->running);
+}
+
+
+int sts_net_post_message(sts_net_reactor_t* reactor, int shard, const void* data, int length) {
+  sts_net_message_t*  message;
+  sts_net_message_t*  head;
+  sts_net_shard_t*    target;
+
+  if (shard < 0 || shard >= reactor->num_shards) {
+    return sts_net__set_error("Invalid shard");
+  }
+  target = &reactor->shards[shard];
+  message = (sts_net_message_t*)sts__malloc(sizeof(sts_net_message_t) + (size_t)length);
+  if (!message) return sts_net__set_error("Cannot allocate message");
+  message->length = length;
+  message->data = (char*)(message + 1);
+  sts__memcpy(message->data, data, length);
+  // lock-free push onto the inbox, the shard will take all messages at once
+  do {
+    head = (sts_net_message_t*)STS_NET__LOAD_PTR(&target->inbox);
+    message->next = head;
+  } while (!STS_NET__CAS_PTR(&target->inbox, head, message));
+  // only wake up the shard if the inbox was empty before
+  if (head == NULL) send(target->notify_socket.fd, "", 1, 0);
+  return 0;
+}
+
+
+sts_net_message_t* sts_net_next_message(sts_net_shard_t* shard) {
+  sts_net_message_t*  message;
+  sts_net_message_t*  reversed = NULL;
+  char                buffer[64];
+
+  if (!shard->head) {
+    // drain the wakeup notifications before looking into the inbox, so no wakeup will get lost
+    if (shard->wakeup_socket.ready) sts_net_recv(&shard->wakeup_socket, buffer, sizeof(buffer));
+    message = (sts_net_message_t*)STS_NET__EXCHANGE_PTR(&shard->inbox, NULL);
+    if (!message) return NULL;
+    // the inbox is in LIFO order, so reverse it
+    while (message) {
+      sts_net_message_t* next = message->next;
+      message->next = reversed;
+      reversed = message;
+      message = next;
+    }
+    shard->head = reversed;
+  }
+  message = shard->head;
+  shard->head = message->next;
+  message->next = NULL;
+  return message;
+}
+
+
+void sts_net_free_message(sts_net_message_t* message) {
+  sts__free(message);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Resolver
+//
+// lock-free push, returns non-zero if the list was empty before
+static int sts_net__push_resolved(sts_net_resolved_t** list, sts_net_resolved_t* resolved) {
+  sts_net_resolved_t* head;
+  do {
+    head = (sts_net_resolved_t*)STS_NET__LOAD_PTR(list);
+    resolved->next = head;
+  } while (!STS_NET__CAS_PTR(list, head, resolved));
+  return head == NULL;
+}
+
+
+// take all entries of the list in the order they were pushed
+static sts_net_resolved_t* sts_net__take_resolved(sts_net_resolved_t** list) {
+  sts_net_resolved_t  *resolved = (sts_net_resolved_t*)STS_NET__EXCHANGE_PTR(list, NULL), *reversed = NULL, *next;
+  while (resolved) {
+    next = resolved->next;
+    resolved->next = reversed;
+    reversed = resolved;
+    resolved = next;
+  }
+  return reversed;
+}
+
+
+static void sts_net__resolver_main(void* arg) {
+  sts_net_resolver_t* resolver = (sts_net_resolver_t*)arg;
+  sts_net_resolved_t  *resolved, *next;
+  char                buffer[64];
+
+  while (STS_NET__LOAD(&resolver->running)) {
+    // wait for new requests
+    if (recv(resolver->worker_socket.fd, buffer, sizeof(buffer), 0) <= 0) break;
+    for (resolved = sts_net__take_resolved(&resolver->requests); resolved; resolved = next) {
+      next = resolved->next;
+      resolved->count = sts_net_resolve_host(resolved->host, resolved->service, resolved->addresses, STS_NET_RESOLVER_ADDRESSES);
+      if (sts_net__push_resolved(&resolver->done, resolved)) send(resolver->notify_socket.fd, "", 1, 0);
+    }
+  }
+}
+
+
+int sts_net_start_resolver(sts_net_resolver_t* resolver) {
+  resolver->requests = resolver->done = resolver->head = NULL;
+  resolver->thread = NULL;
+  resolver->running = 1;
+  if (sts_net__open_socket_pair(&resolver->wakeup_socket, &resolver->notify_socket) < 0) {
+    sts_net_reset_socket(&resolver->worker_socket);
+    sts_net_reset_socket(&resolver->request_socket);
+    resolver->running = 0;
+    return -1;
+  }
+  if (sts_net__open_socket_pair(&resolver->worker_socket, &resolver->request_socket) < 0 ||
+      sts_net__start_thread(&resolver->thread, sts_net__resolver_main, resolver) < 0) {
+    sts_net_stop_resolver(resolver);
+    return -1;
+  }
+  return 0;
+}
+
+
+void sts_net_stop_resolver(sts_net_resolver_t* resolver) {
+  sts_net_resolved_t  *resolved, *next;
+
+  STS_NET__STORE(&resolver->running, 0);
+  if (resolver->thread) {
+    send(resolver->request_socket.fd, "", 1, 0);
+    sts_net__join_thread(resolver->thread);
+    resolver->thread = NULL;
+  }
+  sts_net_close_socket(&resolver->wakeup_socket);
+  sts_net_close_socket(&resolver->notify_socket);
+  sts_net_close_socket(&resolver->worker_socket);
+  sts_net_close_socket(&resolver->request_socket);
+  for (resolved = sts_net__take_resolved(&resolver->requests); resolved; resolved = next) {
+    next = resolved->next;
+    sts_net_free_resolved(resolved);
+  }
+  while ((resolved = sts_net_next_resolved(resolver)) != NULL) sts_net_free_resolved(resolved);
+}
+
+
+int sts_net_resolve(sts_net_resolver_t* resolver, const char* host, const char* service, void* userdata) {
+  sts_net_resolved_t* resolved;
+  size_t              host_length, service_length;
+
+  if (!STS_NET__LOAD(&resolver->running)) {
+    return sts_net__set_error("Resolver is not running");
+  }
+  if (!host) return sts_net__set_error("Cannot resolve without host name");
+  if (!service) service = "";
+  host_length = strlen(host) + 1;
+  service_length = strlen(service) + 1;
+  resolved = (sts_net_resolved_t*)sts__malloc(sizeof(sts_net_resolved_t) + host_length + service_length);
+  if (!resolved) return sts_net__set_error("Cannot allocate resolve request");
+  resolved->userdata = userdata;
+  resolved->host = (char*)(resolved + 1);
+  resolved->service = resolved->host + host_length;
+  sts__memcpy(resolved->host, host, host_length);
+  sts__memcpy(resolved->service, service, service_length);
+  // cached host names are done right away, everything else is resolved by the worker
+  resolved->count = 0;
+  if (STS_NET_RESOLVER_TTL > 0 && host_length <= sizeof(sts_net__cache[0].host) && service_length <= sizeof(sts_net__cache[0].service)) {
+    resolved->count = sts_net__lookup_cache(host, service, resolved->addresses, STS_NET_RESOLVER_ADDRESSES);
+  }
+  if (resolved->count > 0) {
+    if (sts_net__push_resolved(&resolver->done, resolved)) send(resolver->notify_socket.fd, "", 1, 0);
+  } else {
+    if (sts_net__push_resolved(&resolver->requests, resolved)) send(resolver->request_socket.fd, "", 1, 0);
+  }
+  return 0;
+}
+
+
+sts_net_resolved_t* sts_net_next_resolved(sts_net_resolver_t* resolver) {
+  sts_net_resolved_t* resolved;
+  char                buffer[64];
+
+  if (!resolver->head) {
+    // drain the wakeup notifications before looking at the done requests, so no wakeup will get lost
+    if (resolver->wakeup_socket.ready) sts_net_recv(&resolver->wakeup_socket, buffer, sizeof(buffer));
+    resolver->head = sts_net__take_resolved(&resolver->done);
+    if (!resolver->head) return NULL;
+  }
+  resolved = resolver->head;
+  resolver->head = resolved->next;
+  resolved->next = NULL;
+  return resolved;
+}
+
+
+void sts_net_free_resolved(sts_net_resolved_t* resolved) {
+  sts__free(resolved);
+}
+#endif // STS_NET_NO_THREADS
+
+
+#if !defined(STS_NET_NO_THREADS) && !defined(STS_NET_NO_PACKETS)
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Dispatcher
+//
+#define STS_NET__LOCK(p)    while (STS_NET__EXCHANGE_PTR((p), (void*)1) != NULL)
+#define STS_NET__UNLOCK(p)  (void)STS_NET__EXCHANGE_PTR((p), NULL)
+
+// the serial queue of a socket, it's in the queue of at most one worker at a time
+typedef struct sts_net__serial_t {
+  struct sts_net__serial_t* prev;       // links in the queue of a worker
+  struct sts_net__serial_t* next;
+  sts_net_socket_t*         socket;     // NULL if the socket was closed (only used by the polling thread)
+  void*                     lock;
+  sts_net_job_t*            first;      // jobs waiting to be handled
+  sts_net_job_t*            last;
+  int                       scheduled;  // flag if it's queued or running on a worker
+  int                       refs;       // the socket, all jobs and replies
+  int                       blocked;    // flag if replies are pending (only used by the polling thread)
+} sts_net__serial_t;
+
+typedef struct sts_net__reply_t {
+  struct sts_net__reply_t*  next;
+  sts_net__serial_t*        serial;
+  sts_net_buffer_t*         buffer;
+} sts_net__reply_t;
 
 
-const char *sts_net_get_last_error() {
-  return sts_net__error_message;
+static void sts_net__release_serial(sts_net__serial_t* serial, int count) {
+  if (STS_NET__ADD(&serial->refs, -count) == 0) sts__free(serial);
 }
 
 
-int sts_net_init() {
-  #ifdef _WIN32
-    WSADATA wsa_data;
-    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
-      return sts_net__set_error("Windows Sockets failed to start");
-    }
-    return 0;
-  #else
-    return 0;
-  #endif // _WIN32
+// the socket is closed, replies to it will be dropped
+static void sts_net__detach_serial(sts_net_socket_t* socket) {
+  sts_net__serial_t* serial = (sts_net__serial_t*)socket->serial;
+
+  serial->socket = NULL;
+  socket->serial = NULL;
+  sts_net__release_serial(serial, 1);
 }
 
 
-void sts_net_shutdown() {
-  #ifdef _WIN32
-    WSACleanup();
-  #endif // _WIN32
+// put the serial queue into the queue of a worker, prefer sleeping workers
+static void sts_net__schedule_serial(sts_net_dispatcher_t* dispatcher, sts_net__serial_t* serial) {
+  sts_net_worker_t* worker = NULL;
+  int               i, wake;
+
+  for (i = 0; i < dispatcher->num_workers && !worker; ++i) {
+    if (STS_NET__LOAD(&dispatcher->workers[i].sleeping)) worker = &dispatcher->workers[i];
+  }
+  if (!worker) {
+    worker = &dispatcher->workers[dispatcher->next_worker];
+    dispatcher->next_worker = (dispatcher->next_worker + 1) % dispatcher->num_workers;
+  }
+  STS_NET__LOCK(&worker->lock);
+  serial->next = NULL;
+  serial->prev = (sts_net__serial_t*)worker->last;
+  if (worker->last) ((sts_net__serial_t*)worker->last)->next = serial; else worker->first = serial;
+  worker->last = serial;
+  wake = worker->sleeping;
+  STS_NET__STORE(&worker->sleeping, 0);
+  STS_NET__UNLOCK(&worker->lock);
+  if (wake) send(worker->notify_socket.fd, "", 1, 0);
 }
 
 
-int sts_net_open_socket(sts_net_socket_t* sock, const char* host, const char* service) {
-  struct addrinfo     hints;
-  struct addrinfo     *res = NULL, *r = NULL;
-  int                 fd = INVALID_SOCKET;
+// take a serial queue from a worker, the newest one from our own queue or the oldest one when stealing
+static sts_net__serial_t* sts_net__pop_serial(sts_net_worker_t* worker, int steal) {
+  sts_net__serial_t* serial;
 
-  sts_net_reset_socket(sock);
-  sts__memset(&hints, 0, sizeof(hints));
-  hints.ai_family = AF_UNSPEC;
-  hints.ai_socktype = SOCK_STREAM;
+  STS_NET__LOCK(&worker->lock);
+  serial = (sts_net__serial_t*)(steal ? worker->first : worker->last);
+  if (serial) {
+    if (serial->prev) serial->prev->next = serial->next; else worker->first = serial->next;
+    if (serial->next) serial->next->prev = serial->prev; else worker->last = serial->prev;
+  }
+  STS_NET__UNLOCK(&worker->lock);
+  return serial;
+}
 
-  if (host != NULL) {
-    // try to connect to remote host
-    if (getaddrinfo(host, service, &hints, &res) != 0) return sts_net__set_error("Cannot resolve hostname");
-    for (r = res; r; r = r->ai_next) {
-      fd = (int)socket(r->ai_family, r->ai_socktype, r->ai_protocol);
-      if (fd == INVALID_SOCKET) continue;
-      if (connect(fd, r->ai_addr, (int)r->ai_addrlen) == 0) break;
-      closesocket(fd);
-    }
-    freeaddrinfo(res);
-    if (!r) return sts_net__set_error("Cannot connect to host");
-    sock->fd = fd;
-  } else {
-    // listen for connection (start server)
-    hints.ai_flags = AI_PASSIVE;
-    if (getaddrinfo(NULL, service, &hints, &res) != 0) return sts_net__set_error("Cannot resolve hostname");
-    fd = (int)socket(res->ai_family, res->ai_socktype, res->ai_protocol);
-    if (fd == INVALID_SOCKET) {
-      freeaddrinfo(res);
-      return sts_net__set_error("Could not create socket");
+
+// handle the jobs of the serial queue until it's empty
+static void sts_net__run_serial(sts_net_dispatcher_t* dispatcher, sts_net__serial_t* serial) {
+  sts_net_job_t *job, *next;
+  int           handled = 0;
+
+  while (1) {
+    STS_NET__LOCK(&serial->lock);
+    job = serial->first;
+    serial->first = serial->last = NULL;
+    if (!job) serial->scheduled = 0;
+    STS_NET__UNLOCK(&serial->lock);
+    if (!job) break;
+    for (; job; job = next) {
+      next = job->next;
+      if (STS_NET__LOAD(&dispatcher->running)) dispatcher->func(job);
+      sts__free(job);
+      ++handled;
     }
-#ifndef _WIN32
-    {
-      int yes = 1;
-      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (char*)&yes, sizeof(yes));
+  }
+  // the references of the jobs keep the queue alive until we are done with it
+  if (handled > 0) sts_net__release_serial(serial, handled);
+}
+
+
+static void sts_net__worker_main(void* arg) {
+  sts_net_worker_t*     worker = (sts_net_worker_t*)arg;
+  sts_net_dispatcher_t* dispatcher = worker->dispatcher;
+  sts_net__serial_t*    serial;
+  char                  buffer[64];
+  int                   i, sleep;
+
+  while (STS_NET__LOAD(&dispatcher->running)) {
+    serial = sts_net__pop_serial(worker, 0);
+    for (i = 1; !serial && i < dispatcher->num_workers; ++i) {
+      serial = sts_net__pop_serial(&dispatcher->workers[(worker->index + i) % dispatcher->num_workers], 1);
     }
-#endif // _WIN32
-    if (bind(fd, res->ai_addr, (int)res->ai_addrlen) == SOCKET_ERROR) {
-      freeaddrinfo(res);
-      closesocket(fd);
-      return sts_net__set_error("Could not bind to port");
+    if (serial) {
+      sts_net__run_serial(dispatcher, serial);
+      continue;
     }
-    freeaddrinfo(res);
-    if (listen(fd, STS_NET_BACKLOG) == SOCKET_ERROR) {
-      closesocket(fd);
-      return sts_net__set_error("Could not listen to socket");
+    // nothing to do, wait until something gets into our queue
+    STS_NET__LOCK(&worker->lock);
+    sleep = (worker->first == NULL);
+    if (sleep) STS_NET__STORE(&worker->sleeping, 1);
+    STS_NET__UNLOCK(&worker->lock);
+    if (sleep && recv(worker->wakeup_socket.fd, buffer, sizeof(buffer), 0) <= 0) break;
+  }
+}
+
+
+int sts_net_start_dispatcher(sts_net_dispatcher_t* dispatcher, int num_workers, sts_net_job_func func, void* userdata) {
+  sts_net_worker_t* worker;
+  int               i;
+
+  if (num_workers < 1 || num_workers > STS_NET_DISPATCH_WORKERS) {
+    return sts_net__set_error("Invalid amount of workers");
+  }
+  dispatcher->userdata = userdata;
+  dispatcher->func = func;
+  dispatcher->running = 1;
+  dispatcher->num_workers = 0;
+  dispatcher->next_worker = 0;
+  dispatcher->replies = dispatcher->head = NULL;
+  dispatcher->pending = 0;
+  if (sts_net__open_socket_pair(&dispatcher->wakeup_socket, &dispatcher->notify_socket) < 0) {
+    dispatcher->running = 0;
+    return -1;
+  }
+  for (i = 0; i < num_workers; ++i) {
+    worker = &dispatcher->workers[i];
+    worker->dispatcher = dispatcher;
+    worker->index = i;
+    worker->lock = worker->first = worker->last = NULL;
+    worker->sleeping = 0;
+    worker->thread = NULL;
+    if (sts_net__open_socket_pair(&worker->wakeup_socket, &worker->notify_socket) < 0) break;
+    ++dispatcher->num_workers;
+  }
+  if (dispatcher->num_workers == num_workers) {
+    for (i = 0; i < num_workers; ++i) {
+      if (sts_net__start_thread(&dispatcher->workers[i].thread, sts_net__worker_main, &dispatcher->workers[i]) < 0) break;
     }
-    sock->server = 1;
-    sock->fd = fd;
+    if (i == num_workers) return 0;
   }
-  return 0;
+  // something failed, so clean up everything
+  sts_net_stop_dispatcher(dispatcher);
+  return -1;
 }
 
 
-void sts_net_close_socket(sts_net_socket_t* socket) {
-  if (socket->fd != INVALID_SOCKET) closesocket(socket->fd);
-  sts_net_reset_socket(socket);
+void sts_net_stop_dispatcher(sts_net_dispatcher_t* dispatcher) {
+  sts_net_worker_t*   worker;
+  sts_net__serial_t*  serial;
+  sts_net__reply_t    *reply, *next;
+  int                 i;
+
+  STS_NET__STORE(&dispatcher->running, 0);
+  for (i = 0; i < dispatcher->num_workers; ++i) {
+    send(dispatcher->workers[i].notify_socket.fd, "", 1, 0);
+  }
+  for (i = 0; i < dispatcher->num_workers; ++i) {
+    worker = &dispatcher->workers[i];
+    sts_net__join_thread(worker->thread);
+    worker->thread = NULL;
+    // drop the jobs which weren't handled
+    while ((serial = sts_net__pop_serial(worker, 0)) != NULL) sts_net__run_serial(dispatcher, serial);
+    sts_net_close_socket(&worker->wakeup_socket);
+    sts_net_close_socket(&worker->notify_socket);
+  }
+  dispatcher->num_workers = 0;
+  sts_net_close_socket(&dispatcher->wakeup_socket);
+  sts_net_close_socket(&dispatcher->notify_socket);
+  for (i = 0; i < 2; ++i) {
+    reply = (sts_net__reply_t*)(i == 0 ? STS_NET__EXCHANGE_PTR(&dispatcher->replies, NULL) : dispatcher->head);
+    for (; reply; reply = next) {
+      next = reply->next;
+      sts_net_release_buffer(reply->buffer);
+      sts_net__release_serial(reply->serial, 1);
+      sts__free(reply);
+    }
+  }
+  dispatcher->head = NULL;
+  dispatcher->pending = 0;
 }
 
 
-int sts_net_accept_socket(sts_net_socket_t* listen_socket, sts_net_socket_t* remote_socket) {
-  struct sockaddr_in  sock_addr;
-  socklen_t           sock_alen;
+int sts_net_dispatch_packets(sts_net_dispatcher_t* dispatcher, sts_net_socket_t* socket) {
+  sts_net__serial_t*  serial = (sts_net__serial_t*)socket->serial;
+  sts_net_packet_t    packet;
+  sts_net_job_t*      job;
+  int                 count = 0, schedule;
 
-  if (!listen_socket->server) {
-    return sts_net__set_error("Cannot accept on client socket");
+  if (!STS_NET__LOAD(&dispatcher->running)) {
+    return sts_net__set_error("Dispatcher is not running");
   }
-  if (listen_socket->fd == INVALID_SOCKET) {
-    return sts_net__set_error("Cannot accept on closed socket");
+  if (!serial) {
+    if ((serial = (sts_net__serial_t*)sts__malloc(sizeof(sts_net__serial_t))) == NULL) {
+      return sts_net__set_error("Cannot allocate serial queue");
+    }
+    sts__memset(serial, 0, sizeof(sts_net__serial_t));
+    serial->socket = socket;
+    serial->refs = 1;
+    socket->serial = serial;
   }
+  while (sts_net_receive_packet(socket)) {
+    sts_net_get_packet(socket, &packet);
+    job = (sts_net_job_t*)sts__malloc(sizeof(sts_net_job_t) + (size_t)(packet.length[0] + packet.length[1]));
+    if (!job) return sts_net__set_error("Cannot allocate job");
+    job->next = NULL;
+    job->dispatcher = dispatcher;
+    job->socket = socket;
+    job->serial = serial;
+    job->length = packet.length[0] + packet.length[1];
+    job->data = (char*)(job + 1);
+    sts__memcpy(job->data, packet.data[0], packet.length[0]);
+    if (packet.length[1] > 0) sts__memcpy(job->data + packet.length[0], packet.data[1], packet.length[1]);
+    sts_net_drop_packet(socket);
+    STS_NET__ADD(&serial->refs, 1);
+    STS_NET__LOCK(&serial->lock);
+    if (serial->last) serial->last->next = job; else serial->first = job;
+    serial->last = job;
+    schedule = !serial->scheduled;
+    serial->scheduled = 1;
+    STS_NET__UNLOCK(&serial->lock);
+    if (schedule) sts_net__schedule_serial(dispatcher, serial);
+    ++count;
+  }
+  return count;
+}
 
-  sock_alen = sizeof(sock_addr);
-  listen_socket->ready = 0;
-  remote_socket->ready = 0;
-  remote_socket->server = 0;
-  remote_socket->fd = (int)accept(listen_socket->fd, (struct sockaddr*)&sock_addr, &sock_alen);
-  if (remote_socket->fd == INVALID_SOCKET) {
-    return sts_net__set_error("Accept failed");
+
+int sts_net_reply(sts_net_job_t* job, const void* data, int length) {
+  sts_net_dispatcher_t* dispatcher = job->dispatcher;
+  sts_net__reply_t*     reply;
+  sts_net__reply_t*     head;
+
+  if ((reply = (sts_net__reply_t*)sts__malloc(sizeof(sts_net__reply_t))) == NULL) {
+    return sts_net__set_error("Cannot allocate reply");
+  }
+  if ((reply->buffer = sts_net_create_packet_buffer(data, length)) == NULL) {
+    sts__free(reply);
+    return -1;
   }
+  reply->serial = (sts_net__serial_t*)job->serial;
+  STS_NET__ADD(&reply->serial->refs, 1);
+  // lock-free push, the handlers of a socket run one after another, so its replies stay in order
+  do {
+    head = (sts_net__reply_t*)STS_NET__LOAD_PTR(&dispatcher->replies);
+    reply->next = head;
+  } while (!STS_NET__CAS_PTR(&dispatcher->replies, head, reply));
+  if (head == NULL) send(dispatcher->notify_socket.fd, "", 1, 0);
   return 0;
 }
 
 
-int sts_net_send(sts_net_socket_t* socket, const void* data, int length) {
-  if (socket->server) {
-    return sts_net__set_error("Cannot send on server socket");
+int sts_net_send_replies(sts_net_dispatcher_t* dispatcher) {
+  sts_net__reply_t    *reply, *next, *reversed = NULL, **tail;
+  sts_net_socket_t*   socket;
+  char                buffer[64];
+  int                 count = 0, result = 0;
+
+  // drain the wakeup notifications before taking the replies, so no wakeup will get lost
+  if (dispatcher->wakeup_socket.ready) sts_net_recv(&dispatcher->wakeup_socket, buffer, sizeof(buffer));
+  for (reply = (sts_net__reply_t*)STS_NET__EXCHANGE_PTR(&dispatcher->replies, NULL); reply; reply = next) {
+    next = reply->next;
+    reply->next = reversed;
+    reversed = reply;
   }
-  if (socket->fd == INVALID_SOCKET) {
-    return sts_net__set_error("Cannot send on closed socket");
+  // the pending replies go first
+  for (tail = (sts_net__reply_t**)&dispatcher->head; *tail; tail = &(*tail)->next);
+  *tail = reversed;
+  reply = (sts_net__reply_t*)dispatcher->head;
+  dispatcher->head = NULL;
+  dispatcher->pending = 0;
+  tail = (sts_net__reply_t**)&dispatcher->head;
+  for (; reply; reply = next) {
+    next = reply->next;
+    socket = reply->serial->socket;
+    if (socket && socket->fd != INVALID_SOCKET) {
+      // make room in the send queue
+      if (!reply->serial->blocked && socket->queued >= STS_NET_SEND_QUEUE && sts_net_flush_socket(socket) < 0) result = -1;
+      if (reply->serial->blocked || socket->queued >= STS_NET_SEND_QUEUE) {
+        // keep it until the socket can take more data, the following replies of the socket have to wait as well
+        reply->serial->blocked = 1;
+        reply->next = NULL;
+        *tail = reply;
+        tail = &reply->next;
+        ++dispatcher->pending;
+        continue;
+      }
+      if (sts_net_queue_buffer(socket, reply->buffer) < 0) {
+        result = -1;
+      } else {
+        ++count;
+        // send everything for this socket at once
+        if ((!next || next->serial != reply->serial) && sts_net_flush_socket(socket) < 0) result = -1;
+      }
+    }
+    sts_net_release_buffer(reply->buffer);
+    sts_net__release_serial(reply->serial, 1);
+    sts__free(reply);
   }
-  if (send(socket->fd, (const char*)data, length, 0) != length) {
-    return sts_net__set_error("Cannot send data");
+  for (reply = (sts_net__reply_t*)dispatcher->head; reply; reply = reply->next) reply->serial->blocked = 0;
+  return result < 0 ? -1 : count;
+}
+#endif // !defined(STS_NET_NO_THREADS) && !defined(STS_NET_NO_PACKETS)
+
+
+#ifndef STS_NET_NO_PACKETS
+////////////////////////////////////////////////////////////////////////////////
+//
+//    io_uring
+//
+#ifdef STS_NET__URING
+enum {
+  STS_NET__URING_TAG_ACCEPT,
+  STS_NET__URING_TAG_RECV,
+  STS_NET__URING_TAG_SEND,
+  STS_NET__URING_TAG_CANCEL
+};
+
+
+#define STS_NET__URING_DATA(socket, tag)  ((unsigned long long)(size_t)(socket) | (tag))
+#define STS_NET__URING_SOCKET(data)       ((sts_net_socket_t*)(size_t)((data) & ~3ULL))
+#define STS_NET__URING_TAG(data)          ((int)((data) & 3ULL))
+
+
+static int sts_net__uring_enter(sts_net_uring_t* ring, unsigned to_submit, unsigned min_complete, const float timeout) {
+  struct io_uring_getevents_arg arg;
+  struct __kernel_timespec      ts;
+  unsigned                      flags = 0;
+
+  sts__memset(&arg, 0, sizeof(arg));
+  if (min_complete > 0) {
+    flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+    ts.tv_sec = (long long)timeout;
+    ts.tv_nsec = (long long)((timeout - (float)ts.tv_sec) * 1000000000.0f);
+    arg.ts = (unsigned long long)(size_t)&ts;
   }
-  return 0;
+  return (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete, flags, min_complete > 0 ? &arg : NULL, sizeof(arg));
 }
 
 
-int sts_net_recv(sts_net_socket_t* socket, void* data, int length) {
+static int sts_net__uring_submit(sts_net_uring_t* ring, unsigned min_complete, const float timeout) {
   int result;
-  if (socket->server) {
-    return sts_net__set_error("Cannot receive on server socket");
+
+  __atomic_store_n(ring->sq_tail_ptr, ring->sq_tail, __ATOMIC_RELEASE);
+  result = sts_net__uring_enter(ring, ring->sq_tail - ring->sq_submitted, min_complete, timeout);
+  if (result < 0 && errno != ETIME && errno != EINTR) {
+    return sts_net__set_error("io_uring_enter() failed");
   }
-  if (socket->fd == INVALID_SOCKET) {
-    return sts_net__set_error("Cannot receive on closed socket");
+  if (result > 0) ring->sq_submitted += (unsigned)result;
+  return 0;
+}
+
+
+static struct io_uring_sqe* sts_net__uring_get_sqe(sts_net_uring_t* ring, sts_net_socket_t* socket, int tag) {
+  struct io_uring_sqe* sqe;
+
+  if (ring->sq_tail - __atomic_load_n(ring->sq_head_ptr, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+    // submission queue is full, so submit everything right now
+    if (sts_net__uring_submit(ring, 0, 0.0f) < 0) return NULL;
+    if (ring->sq_tail - __atomic_load_n(ring->sq_head_ptr, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+      sts_net__set_error("io_uring submission queue is full");
+      return NULL;
+    }
   }
-  socket->ready = 0;
-  result = recv(socket->fd, (char*)data, length, 0);
-  if (result < 0) {
-    return sts_net__set_error("Cannot receive data");
+  sqe = &((struct io_uring_sqe*)ring->sqes)[ring->sq_tail & *ring->sq_mask_ptr];
+  ++ring->sq_tail;
+  sts__memset(sqe, 0, sizeof(*sqe));
+  sqe->user_data = STS_NET__URING_DATA(socket, tag);
+  return sqe;
+}
+
+
+// give a receive buffer back to the kernel
+static void sts_net__uring_recycle_buffer(sts_net_uring_t* ring, int id) {
+  struct io_uring_buf_ring* buffer_ring = (struct io_uring_buf_ring*)ring->buffer_ring;
+  // don't use buffer_ring->bufs, the flexible array member has a different offset in C++
+  struct io_uring_buf*      buffer = (struct io_uring_buf*)ring->buffer_ring + (buffer_ring->tail & (STS_NET_URING_BUFFERS - 1));
+
+  buffer->addr = (unsigned long long)(size_t)&ring->buffers[(size_t)id * STS_NET_URING_BUFFER_SIZE];
+  buffer->len = STS_NET_URING_BUFFER_SIZE;
+  buffer->bid = (unsigned short)id;
+  __atomic_store_n(&buffer_ring->tail, (unsigned short)(buffer_ring->tail + 1), __ATOMIC_RELEASE);
+}
+
+
+// checks if the kernel supports all used opcodes (IORING_REGISTER_PROBE needs Linux 5.6)
+static int sts_net__uring_probe_opcodes(sts_net_uring_t* ring) {
+  static const unsigned char  opcodes[] = { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ASYNC_CANCEL };
+  struct io_uring_probe*      probe;
+  struct io_uring_probe_op*   ops;
+  size_t                      size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+  int                         i, result = 0;
+
+  if ((probe = (struct io_uring_probe*)sts__malloc(size)) == NULL) return -1;
+  sts__memset(probe, 0, size);
+  // don't use probe->ops, the flexible array member has a different offset in C++
+  ops = (struct io_uring_probe_op*)(probe + 1);
+  if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PROBE, probe, 256) < 0) result = -1;
+  for (i = 0; result == 0 && i < (int)sizeof(opcodes); ++i) {
+    if (opcodes[i] >= probe->ops_len || !(ops[opcodes[i]].flags & IO_URING_OP_SUPPORTED)) result = -1;
   }
+  sts__free(probe);
   return result;
 }
 
 
-void sts_net_init_socket_set(sts_net_set_t* set) {
-  int i;
-  for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
-    set->sockets[i] = NULL;
-  }
+// checks if the kernel supports multishot recv (Linux 6.0), the opcode probe can't tell.
+// A multishot recv on an invalid descriptor fails with EBADF, older kernels reject the flag with EINVAL.
+static int sts_net__uring_probe_multishot(sts_net_uring_t* ring) {
+  struct io_uring_sqe*  sqe;
+  struct io_uring_cqe*  cqe;
+  unsigned              head;
+  int                   result;
+
+  if ((sqe = sts_net__uring_get_sqe(ring, NULL, STS_NET__URING_TAG_CANCEL)) == NULL) return -1;
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = -1;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = 0;
+  if (sts_net__uring_submit(ring, 1, 1.0f) < 0) return -1;
+  head = *ring->cq_head_ptr;
+  if (head == __atomic_load_n(ring->cq_tail_ptr, __ATOMIC_ACQUIRE)) return -1;
+  cqe = &((struct io_uring_cqe*)ring->cqes)[head & *ring->cq_mask_ptr];
+  result = cqe->res;
+  __atomic_store_n(ring->cq_head_ptr, head + 1, __ATOMIC_RELEASE);
+  return result == -EINVAL ? -1 : 0;
 }
+#endif // STS_NET__URING
 
 
-int sts_net_add_socket_to_set(sts_net_socket_t *socket, sts_net_set_t *set) {
-  int i;
-  if (socket->fd == INVALID_SOCKET) {
-    return sts_net__set_error("Cannot add closed socket to set");
+int sts_net_uring_init(sts_net_uring_t* ring, unsigned entries) {
+#ifdef STS_NET__URING
+  struct io_uring_params  params;
+  struct io_uring_buf_reg reg;
+  int                     i;
+  unsigned                *array;
+
+  sts__memset(ring, 0, sizeof(*ring));
+  sts__memset(&params, 0, sizeof(params));
+  // fails on old kernels, with seccomp filters or if io_uring is disabled (kernel.io_uring_disabled)
+  ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+  if (ring->fd < 0) {
+    ring->fd = -1;
+    return sts_net__set_error("io_uring is not available");
   }
-  for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
-    if (!set->sockets[i]) {
-      set->sockets[i] = socket;
-      return 0;
-    }
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+    sts_net_uring_shutdown(ring);
+    return sts_net__set_error("io_uring is missing needed features");
   }
-  return sts_net__set_error("Socket set is full");
+  if (sts_net__uring_probe_opcodes(ring) < 0) {
+    sts_net_uring_shutdown(ring);
+    return sts_net__set_error("io_uring is missing needed opcodes");
+  }
+  // map the rings
+  ring->ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  if (params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe) > ring->ring_size) {
+    ring->ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  }
+  ring->ring = mmap(NULL, ring->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+    sts_net_uring_shutdown(ring);
+    return sts_net__set_error("Cannot map io_uring");
+  }
+  ring->sq_entries = params.sq_entries;
+  ring->sq_head_ptr = (unsigned*)((char*)ring->ring + params.sq_off.head);
+  ring->sq_tail_ptr = (unsigned*)((char*)ring->ring + params.sq_off.tail);
+  ring->sq_mask_ptr = (unsigned*)((char*)ring->ring + params.sq_off.ring_mask);
+  ring->cq_head_ptr = (unsigned*)((char*)ring->ring + params.cq_off.head);
+  ring->cq_tail_ptr = (unsigned*)((char*)ring->ring + params.cq_off.tail);
+  ring->cq_mask_ptr = (unsigned*)((char*)ring->ring + params.cq_off.ring_mask);
+  ring->cqes = (char*)ring->ring + params.cq_off.cqes;
+  array = (unsigned*)((char*)ring->ring + params.sq_off.array);
+  for (i = 0; i < (int)params.sq_entries; ++i) array[i] = (unsigned)i;
+  ring->sq_tail = ring->sq_submitted = *ring->sq_tail_ptr;
+
+  // register the provided receive buffers
+  ring->buffer_ring_size = STS_NET_URING_BUFFERS * sizeof(struct io_uring_buf);
+  ring->buffer_ring = mmap(NULL, ring->buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ring->buffers = (char*)sts__malloc((size_t)STS_NET_URING_BUFFERS * STS_NET_URING_BUFFER_SIZE);
+  if (ring->buffer_ring == MAP_FAILED || !ring->buffers) {
+    sts_net_uring_shutdown(ring);
+    return sts_net__set_error("Cannot allocate io_uring buffers");
+  }
+  sts__memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = (unsigned long long)(size_t)ring->buffer_ring;
+  reg.ring_entries = STS_NET_URING_BUFFERS;
+  reg.bgid = 0;
+  if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    sts_net_uring_shutdown(ring);
+    return sts_net__set_error("Cannot register io_uring buffers");
+  }
+  for (i = 0; i < STS_NET_URING_BUFFERS; ++i) sts_net__uring_recycle_buffer(ring, i);
+  if (sts_net__uring_probe_multishot(ring) < 0) {
+    sts_net_uring_shutdown(ring);
+    return sts_net__set_error("io_uring doesn't support multishot recv");
+  }
+  return 0;
+#else
+  (void)entries;
+  ring->fd = -1;
+  return sts_net__set_error("io_uring is not available");
+#endif // STS_NET__URING
 }
 
 
-int sts_net_remove_socket_from_set(sts_net_socket_t *socket, sts_net_set_t *set) {
-  int i;
-  if (socket->fd == INVALID_SOCKET) {
-    return sts_net__set_error("Cannot remove closed socket from set");
+void sts_net_uring_shutdown(sts_net_uring_t* ring) {
+#ifdef STS_NET__URING
+  if (ring->buffer_ring && ring->buffer_ring != MAP_FAILED) munmap(ring->buffer_ring, ring->buffer_ring_size);
+  if (ring->sqes && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+  if (ring->ring && ring->ring != MAP_FAILED) munmap(ring->ring, ring->ring_size);
+  if (ring->fd >= 0) close(ring->fd);
+  sts__free(ring->buffers);
+  sts__memset(ring, 0, sizeof(*ring));
+#endif // STS_NET__URING
+  ring->fd = -1;
+}
+
+
+int sts_net_uring_accept(sts_net_uring_t* ring, sts_net_socket_t* socket) {
+#ifdef STS_NET__URING
+  struct io_uring_sqe* sqe;
+
+  if (!socket->server) {
+    return sts_net__set_error("Cannot accept on client socket");
   }
-  for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
-    if (set->sockets[i] == socket) {
-      set->sockets[i] = NULL;
-      return 0;
-    }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot accept on closed socket");
   }
-  return sts_net__set_error("Socket not found in set");
+  if ((sqe = sts_net__uring_get_sqe(ring, socket, STS_NET__URING_TAG_ACCEPT)) == NULL) return -1;
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = socket->fd;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  return 0;
+#else
+  (void)ring; (void)socket;
+  return sts_net__set_error("io_uring is not available");
+#endif // STS_NET__URING
 }
 
 
-int sts_net_check_socket_set(sts_net_set_t* set, const float timeout) {
-  fd_set          fds;
-  struct timeval  tv;
-  int             i, max_fd, result;
+int sts_net_uring_accept_socket(const sts_net_uring_event_t* event, sts_net_socket_t* remote_socket) {
+  if (event->type != STS_NET_URING_ACCEPT || event->result < 0) {
+    return sts_net__set_error("Not an accept event");
+  }
+  sts_net_reset_socket(remote_socket);
+  remote_socket->fd = event->result;
+  return 0;
+}
 
 
-  FD_ZERO(&fds);
-  for (i = 0, max_fd = 0; i < STS_NET_SET_SOCKETS; ++i) {
-    if (set->sockets[i]) {
-      FD_SET(set->sockets[i]->fd, &fds);
-      if (set->sockets[i]->fd > max_fd) {
-        max_fd = set->sockets[i]->fd;
-      }
-    }
-  }
-  if (max_fd == 0) return 0;
+int sts_net_uring_recv(sts_net_uring_t* ring, sts_net_socket_t* socket) {
+#ifdef STS_NET__URING
+  struct io_uring_sqe* sqe;
 
-  tv.tv_sec = (int)timeout;
-  tv.tv_usec = (int)((timeout - (float)tv.tv_sec) * 1000000.0f);
-  result = select(max_fd + 1, &fds, NULL, NULL, &tv);
-  if (result > 0) {
-    for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
-      if (set->sockets[i]) {
-        if (FD_ISSET(set->sockets[i]->fd, &fds)) {
-          set->sockets[i]->ready = 1;
-        }
-      }
-    }
-  } else if (result == SOCKET_ERROR) {
-    sts_net__set_error("Error on select()");
+  if (socket->server) {
+    return sts_net__set_error("Cannot receive on server socket");
   }
-  return result;
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot receive on closed socket");
+  }
+  if ((sqe = sts_net__uring_get_sqe(ring, socket, STS_NET__URING_TAG_RECV)) == NULL) return -1;
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = socket->fd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = 0;
+  return 0;
+#else
+  (void)ring; (void)socket;
+  return sts_net__set_error("io_uring is not available");
+#endif // STS_NET__URING
 }
 
 
-#ifndef STS_NET_NO_PACKETS
-int sts_net_refill_packet_data(sts_net_socket_t* socket) {
-  if (socket->ready) return 0;
-  int received = sts_net_recv(socket, &socket->data[socket->received], STS_NET_PACKET_SIZE - socket->received);
-  if (received < 0) return -1;
-  socket->received += received;
-  return 1;
+int sts_net_uring_send(sts_net_uring_t* ring, sts_net_socket_t* socket, const void* data, int length) {
+#ifdef STS_NET__URING
+  struct io_uring_sqe* sqe;
+
+  if (socket->server) {
+    return sts_net__set_error("Cannot send on server socket");
+  }
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot send on closed socket");
+  }
+  if ((sqe = sts_net__uring_get_sqe(ring, socket, STS_NET__URING_TAG_SEND)) == NULL) return -1;
+  sqe->opcode = IORING_OP_SEND;
+  sqe->fd = socket->fd;
+  sqe->addr = (unsigned long long)(size_t)data;
+  sqe->len = (unsigned)length;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  return 0;
+#else
+  (void)ring; (void)socket; (void)data; (void)length;
+  return sts_net__set_error("io_uring is not available");
+#endif // STS_NET__URING
 }
 
 
-int sts_net_receive_packet(sts_net_socket_t* socket) {
-  if (socket->packet_length < 0) {
-    if (socket->received >= 2) {
-      socket->packet_length = socket->data[0] * 256 + socket->data[1];
-      if (socket->packet_length > STS_NET_PACKET_SIZE) {
-        sts_net_close_socket(socket);
-        return sts_net__set_error("Received packet was too large");
-      }
-      socket->received -= 2;
-      sts__memcpy(&socket->data[0], &socket->data[2], socket->received);
-    }
+int sts_net_uring_cancel(sts_net_uring_t* ring, sts_net_socket_t* socket) {
+#ifdef STS_NET__URING
+  struct io_uring_sqe* sqe;
+
+  if (socket->fd == INVALID_SOCKET) {
+    return sts_net__set_error("Cannot cancel on closed socket");
   }
-  return ((socket->packet_length >= 0) && (socket->received >= socket->packet_length));
+  if ((sqe = sts_net__uring_get_sqe(ring, socket, STS_NET__URING_TAG_CANCEL)) == NULL) return -1;
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = socket->fd;
+  sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+  // submit right now, so the cancelation happens before the socket gets closed
+  return sts_net__uring_submit(ring, 0, 0.0f);
+#else
+  (void)ring; (void)socket;
+  return sts_net__set_error("io_uring is not available");
+#endif // STS_NET__URING
 }
 
 
-void sts_net_drop_packet(sts_net_socket_t* socket) {
-  if ((socket->packet_length >= 0) && (socket->received >= socket->packet_length)) {
-    sts__memcpy(&socket->data[0], &socket->data[socket->packet_length], socket->received - socket->packet_length);
-    socket->received -= socket->packet_length;
-    socket->packet_length = -1;
+int sts_net_uring_wait(sts_net_uring_t* ring, sts_net_uring_event_t* events, int max_events, const float timeout) {
+#ifdef STS_NET__URING
+  struct io_uring_cqe*    cqe;
+  sts_net_uring_event_t*  event;
+  sts_net_socket_t*       socket;
+  unsigned                head, tail;
+  int                     count = 0, tag, id;
+
+  head = *ring->cq_head_ptr;
+  tail = __atomic_load_n(ring->cq_tail_ptr, __ATOMIC_ACQUIRE);
+  // only wait if there are no completions yet
+  if (sts_net__uring_submit(ring, (head == tail && timeout > 0.0f) ? 1 : 0, timeout) < 0) return -1;
+  tail = __atomic_load_n(ring->cq_tail_ptr, __ATOMIC_ACQUIRE);
+  for (; head != tail && count < max_events; ++head) {
+    cqe = &((struct io_uring_cqe*)ring->cqes)[head & *ring->cq_mask_ptr];
+    tag = STS_NET__URING_TAG(cqe->user_data);
+    socket = STS_NET__URING_SOCKET(cqe->user_data);
+    event = &events[count];
+    event->socket = socket;
+    event->result = cqe->res;
+    if (tag == STS_NET__URING_TAG_CANCEL || cqe->res == -ECANCELED) {
+      // nothing to report
+    } else if (tag == STS_NET__URING_TAG_ACCEPT) {
+      event->type = cqe->res >= 0 ? STS_NET_URING_ACCEPT : STS_NET_URING_ERROR;
+      ++count;
+      // the multishot accept has stopped, so start it again
+      if (!(cqe->flags & IORING_CQE_F_MORE) && socket->fd != INVALID_SOCKET) sts_net_uring_accept(ring, socket);
+    } else if (tag == STS_NET__URING_TAG_RECV) {
+      if (cqe->flags & IORING_CQE_F_BUFFER) {
+        id = (int)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        if (cqe->res > 0 && socket->fd != INVALID_SOCKET) {
+          STS_NET__COUNT(socket, bytes_in, cqe->res);
+          if (sts_net__append_packet_data(socket, &ring->buffers[(size_t)id * STS_NET_URING_BUFFER_SIZE], cqe->res) < 0) {
+            event->result = -ENOMEM;
+          }
+        }
+        sts_net__uring_recycle_buffer(ring, id);
+      }
+      if (cqe->res == -ENOBUFS) {
+        // ran out of provided buffers, the multishot recv stopped
+        if (socket->fd != INVALID_SOCKET) sts_net_uring_recv(ring, socket);
+      } else if (socket->fd != INVALID_SOCKET) {
+        event->type = cqe->res > 0 ? (event->result > 0 ? STS_NET_URING_RECV : STS_NET_URING_ERROR) : (cqe->res == 0 ? STS_NET_URING_CLOSED : STS_NET_URING_ERROR);
+        ++count;
+        if (cqe->res > 0 && !(cqe->flags & IORING_CQE_F_MORE)) sts_net_uring_recv(ring, socket);
+      }
+    } else if (tag == STS_NET__URING_TAG_SEND) {
+      event->type = cqe->res >= 0 ? STS_NET_URING_SEND : STS_NET_URING_ERROR;
+      if (cqe->res > 0) STS_NET__COUNT(socket, bytes_out, cqe->res);
+      ++count;
+    }
   }
+  __atomic_store_n(ring->cq_head_ptr, head, __ATOMIC_RELEASE);
+  return count;
+#else
+  (void)ring; (void)events; (void)max_events; (void)timeout;
+  return sts_net__set_error("io_uring is not available");
+#endif // STS_NET__URING
 }
 #endif // STS_NET_NO_PACKETS
 
@@ -518,18 +5426,18 @@ void panic(const char* msg) {
 
 
 int main(int argc, char *argv[]) {
-  int               i, j, bytes;
+  int               i, bytes;
   sts_net_set_t     set;
   sts_net_socket_t  server;
   sts_net_socket_t  clients[STS_NET_SET_SOCKETS];
+  sts_net_buffer_t* packet;
   char              buffer[256];
 
   (void)(argc);
   (void)(argv);
 
   for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
-    clients[i].ready = 0;
-    clients[i].fd = INVALID_SOCKET;
+    sts_net_reset_socket(&clients[i]);
   }
 
   sts_net_init();
@@ -553,6 +5461,9 @@ int main(int argc, char *argv[]) {
     }
     // check clients
     for (i = 0; i < STS_NET_SET_SOCKETS; ++i) {
+      if (clients[i].writable) {
+        if (sts_net_flush_socket(&clients[i]) < 0) panic(sts_net_get_last_error());
+      }
       if (clients[i].ready) {
         memset(buffer, 0, sizeof(buffer));
         bytes = sts_net_recv(&clients[i], buffer, sizeof(buffer) - 1);
@@ -561,12 +5472,10 @@ int main(int argc, char *argv[]) {
           sts_net_close_socket(&clients[i]);
           puts("Client disconnected");
         } else {
-          // broadcast
-          for (j = 0; j < STS_NET_SET_SOCKETS; ++j) {
-            if (clients[j].fd != INVALID_SOCKET) {
-              if (sts_net_send(&clients[j], buffer, bytes) < 0) panic(sts_net_get_last_error());
-            }
-          }
+          // broadcast (the same buffer is queued on all clients)
+          if ((packet = sts_net_create_buffer(buffer, bytes)) == NULL) panic(sts_net_get_last_error());
+          if (sts_net_broadcast(set.sockets, STS_NET_SET_SOCKETS, packet) < 0) panic(sts_net_get_last_error());
+          sts_net_release_buffer(packet);
           printf("Broadcast: %s\n", buffer);
         }
       }
@@ -0,0 +1,564 @@
+////////////////////////////////////////////////////////////////////////////////
+/*
+ sts_net_bench.c - public domain
+ loopback benchmark for sts_net.h
+
+  ABOUT
+    Runs a server and its clients over loopback, using the packet API. Reports
+    messages/sec, MB/s and p50/p99 latency for these workloads:
+      echo        every client sends a packet and waits for the server to send it back
+      broadcast   one client sends a packet, the server broadcasts it to all clients
+    The clients always use a socket set in the main thread. Every workload runs
+    on each server backend which is available at runtime:
+      poll        the server uses the same socket set in the main thread
+      reactor     the server runs on BENCH_SHARDS reactor shards, each with its own socket set
+      io_uring    the server runs on a single reactor shard driven by io_uring (Linux 6.0+)
+
+  BUILD
+    cc -O2 -o sts_net_bench sts_net_bench.c -lpthread (Linux / macOS)
+    cl /O2 sts_net_bench.c                            (Windows)
+
+  USAGE
+    sts_net_bench [seconds per run] [port]
+
+*/
+////////////////////////////////////////////////////////////////////////////////
+// include sts_net.h first, so it can enable _GNU_SOURCE (accept4, recvmmsg and shared rings on Linux)
+#define STS_NET_SET_SOCKETS   2048
+#define STS_NET_BACKLOG       1024
+#define STS_NET_PACKET_SIZE   65536
+#define STS_NET_IMPLEMENTATION
+#include "sts_net.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define BENCH_MAX_CONNECTIONS 100     // select() on Windows can't handle more
+#else
+#include <sys/resource.h>
+#define BENCH_MAX_CONNECTIONS 1000
+#define BENCH_THREADS                 // the reactor isn't available on Windows
+#endif // _WIN32
+
+#define BENCH_SHARDS          4       // shards of the reactor backend
+#define BENCH_URING_QUEUE     16      // sends waiting for the io_uring send of a socket to finish
+
+
+enum {
+  BENCH_POLL,
+  BENCH_REACTOR,
+  BENCH_URING,
+  BENCH_BACKENDS
+};
+
+static const char*  bench_backends[BENCH_BACKENDS] = { "poll", "reactor", "io_uring" };
+
+
+static const int  bench_connections[] = { 10, 100, 1000 };
+static const int  bench_sizes[] = { 16, 256, 4096, 65536 };
+
+
+typedef struct {
+  int                 backend;
+  const char*         name;
+  int                 broadcast;
+  int                 connections;
+  int                 size;
+  double              seconds;
+  // results
+  long long           messages;
+  long long           bytes;
+  sts_net_histogram_t latency;
+} bench_run_t;
+
+
+static sts_net_socket_t   bench_server;
+static sts_net_socket_t   bench_clients[BENCH_MAX_CONNECTIONS];
+static sts_net_socket_t   bench_remotes[BENCH_MAX_CONNECTIONS];
+static sts_net_set_t      bench_set;
+static char               bench_buffer[STS_NET_PACKET_SIZE];
+
+
+#ifdef BENCH_THREADS
+// a server socket accepted by a shard
+typedef struct {
+  sts_net_socket_t  socket;   // the first member, so io_uring events can be mapped back
+  sts_net_buffer_t* queue[BENCH_URING_QUEUE];
+  int               head, count, offset;
+} bench_remote_t;
+
+// the server side of the reactor and io_uring backends, every shard has its own remotes
+typedef struct {
+  int               broadcast;
+  int               accepted;   // updated atomically by the shards
+  int               remotes[BENCH_SHARDS];   // amount of accepted sockets of every shard
+  bench_remote_t    shard_remotes[BENCH_SHARDS][BENCH_MAX_CONNECTIONS];
+  char              shard_buffers[BENCH_SHARDS][STS_NET_PACKET_SIZE];
+} bench_server_t;
+
+static sts_net_reactor_t  bench_reactor;
+static bench_server_t*    bench_threaded;
+#endif // BENCH_THREADS
+
+
+static void panic(const char* msg) {
+  fprintf(stderr, "PANIC: %s (%s)\n\n", msg, sts_net_get_last_error());
+  exit(EXIT_FAILURE);
+}
+
+
+static double bench_time() {
+#ifdef _WIN32
+  LARGE_INTEGER counter, frequency;
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+#endif // _WIN32
+}
+
+
+// copy the current packet into "buffer" and return its length
+static int bench_read_packet(sts_net_socket_t* socket, char* buffer) {
+  sts_net_packet_t packet;
+
+  sts_net_get_packet(socket, &packet);
+  memcpy(buffer, packet.data[0], packet.length[0]);
+  if (packet.length[1] > 0) memcpy(buffer + packet.length[0], packet.data[1], packet.length[1]);
+  sts_net_drop_packet(socket);
+  return packet.length[0] + packet.length[1];
+}
+
+
+// send a packet with the current time as payload
+static void bench_send(sts_net_socket_t* socket, int size) {
+  double now = bench_time();
+  memcpy(bench_buffer, &now, sizeof(now));
+  if (sts_net_send_packet(socket, bench_buffer, size) < 0) panic("Cannot send packet");
+}
+
+
+#ifdef BENCH_THREADS
+////////////////////////////////////////////////////////////////////////////////
+//
+//  reactor and io_uring servers
+//
+// send the data to all remotes of the shard with the socket sets
+static void bench_shard_broadcast(bench_remote_t* remotes, int count, const char* data, int length) {
+  sts_net_socket_t* sockets[BENCH_MAX_CONNECTIONS];
+  sts_net_buffer_t* buffer = sts_net_create_packet_buffer(data, length);
+  int               i;
+
+  if (!buffer) panic("Cannot create buffer");
+  for (i = 0; i < count; ++i) sockets[i] = remotes[i].socket.fd != INVALID_SOCKET ? &remotes[i].socket : NULL;
+  if (sts_net_broadcast(sockets, count, buffer) < 0) panic("Cannot broadcast");
+  sts_net_release_buffer(buffer);
+}
+
+
+static void bench_shard_poll(sts_net_shard_t* shard) {
+  bench_server_t*     server = (bench_server_t*)shard->userdata;
+  bench_remote_t*     remotes = server->shard_remotes[shard->index];
+  char*               buffer = server->shard_buffers[shard->index];
+  int*                count = &server->remotes[shard->index];
+  sts_net_socket_t    accepted[64];
+  sts_net_message_t*  message;
+  int                 i, n, length;
+
+  while (sts_net_is_reactor_running(shard->reactor)) {
+    if (sts_net_check_socket_set(&shard->set, 0.1f) < 0) panic("Cannot check socket set");
+    if (shard->listen_socket.ready) {
+      // the sockets are accepted into an array of sockets, the remotes have a different stride
+      n = sts_net_accept_sockets(&shard->listen_socket, accepted, BENCH_MAX_CONNECTIONS - *count < 64 ? BENCH_MAX_CONNECTIONS - *count : 64, NULL);
+      if (n < 0) panic("Cannot accept");
+      for (i = 0; i < n; ++i) {
+        remotes[*count].socket = accepted[i];
+        if (sts_net_add_socket_to_set(&remotes[(*count)++].socket, &shard->set) < 0) panic("Cannot add remote to set");
+      }
+      __atomic_add_fetch(&server->accepted, n, __ATOMIC_RELEASE);
+    }
+    // broadcasts of the other shards
+    while ((message = sts_net_next_message(shard)) != NULL) {
+      bench_shard_broadcast(remotes, *count, message->data, message->length);
+      sts_net_free_message(message);
+    }
+    for (i = 0; i < *count; ++i) {
+      sts_net_socket_t* socket = &remotes[i].socket;
+      if (socket->fd == INVALID_SOCKET) continue;
+      if (socket->writable && sts_net_flush_socket(socket) < 0) panic("Cannot flush");
+      if (!socket->ready) continue;
+      if (sts_net_refill_packet_data(socket) < 0) {
+        // the client is gone
+        sts_net_remove_socket_from_set(socket, &shard->set);
+        sts_net_close_socket(socket);
+        continue;
+      }
+      while (sts_net_receive_packet(socket)) {
+        length = bench_read_packet(socket, buffer);
+        if (!server->broadcast) {
+          // queue the packet, a blocking send could wait for the client thread which waits for us
+          sts_net_buffer_t* packet = sts_net_create_packet_buffer(buffer, length);
+          if (!packet || sts_net_queue_buffer(socket, packet) < 0 || sts_net_flush_socket(socket) < 0) panic("Cannot echo packet");
+          sts_net_release_buffer(packet);
+        } else {
+          bench_shard_broadcast(remotes, *count, buffer, length);
+          for (n = 0; n < shard->reactor->num_shards; ++n) {
+            if (n != shard->index && sts_net_post_message(shard->reactor, n, buffer, length) < 0) panic("Cannot post message");
+          }
+        }
+      }
+    }
+  }
+  for (i = 0; i < *count; ++i) sts_net_close_socket(&remotes[i].socket);
+}
+
+
+// queue the buffer on the remote, only one io_uring send per socket is in flight so the data keeps its order
+static void bench_uring_send(sts_net_uring_t* ring, bench_remote_t* remote, sts_net_buffer_t* buffer) {
+  if (remote->count == BENCH_URING_QUEUE) panic("io_uring send queue is full");
+  sts_net_retain_buffer(buffer);
+  remote->queue[(remote->head + remote->count++) % BENCH_URING_QUEUE] = buffer;
+  if (remote->count == 1 && sts_net_uring_send(ring, &remote->socket, buffer->data, buffer->length) < 0) panic("Cannot send");
+}
+
+
+// a send of the remote has finished, start the next one
+static void bench_uring_sent(sts_net_uring_t* ring, bench_remote_t* remote, int sent) {
+  sts_net_buffer_t* buffer = remote->queue[remote->head];
+
+  if ((remote->offset += sent) < buffer->length) {
+    if (sts_net_uring_send(ring, &remote->socket, buffer->data + remote->offset, buffer->length - remote->offset) < 0) panic("Cannot send");
+    return;
+  }
+  sts_net_release_buffer(buffer);
+  remote->head = (remote->head + 1) % BENCH_URING_QUEUE;
+  remote->offset = 0;
+  if (--remote->count > 0) {
+    buffer = remote->queue[remote->head];
+    if (sts_net_uring_send(ring, &remote->socket, buffer->data, buffer->length) < 0) panic("Cannot send");
+  }
+}
+
+
+static void bench_uring_close(sts_net_uring_t* ring, bench_remote_t* remote) {
+  sts_net_uring_cancel(ring, &remote->socket);
+  sts_net_close_socket(&remote->socket);
+  for (; remote->count > 0; --remote->count) {
+    sts_net_release_buffer(remote->queue[remote->head]);
+    remote->head = (remote->head + 1) % BENCH_URING_QUEUE;
+  }
+}
+
+
+static void bench_shard_uring(sts_net_shard_t* shard) {
+  bench_server_t*       server = (bench_server_t*)shard->userdata;
+  bench_remote_t*       remotes = server->shard_remotes[shard->index];
+  char*                 buffer = server->shard_buffers[shard->index];
+  int*                  count = &server->remotes[shard->index];
+  sts_net_uring_t       ring;
+  sts_net_uring_event_t events[64];
+  sts_net_buffer_t*     packet;
+  bench_remote_t*       remote;
+  int                   i, j, n, length;
+
+  if (sts_net_uring_init(&ring, 1024) < 0) panic("Cannot initialize io_uring");
+  if (sts_net_uring_accept(&ring, &shard->listen_socket) < 0) panic("Cannot accept");
+  while (sts_net_is_reactor_running(shard->reactor)) {
+    if ((n = sts_net_uring_wait(&ring, events, 64, 0.1f)) < 0) panic("Cannot wait for io_uring");
+    for (i = 0; i < n; ++i) {
+      remote = (bench_remote_t*)events[i].socket;
+      switch (events[i].type) {
+        case STS_NET_URING_ACCEPT:
+          if (*count == BENCH_MAX_CONNECTIONS) panic("Too many connections");
+          remote = &remotes[(*count)++];
+          remote->head = remote->count = remote->offset = 0;
+          if (sts_net_uring_accept_socket(&events[i], &remote->socket) < 0) panic("Cannot accept");
+          if (sts_net_uring_recv(&ring, &remote->socket) < 0) panic("Cannot receive");
+          __atomic_add_fetch(&server->accepted, 1, __ATOMIC_RELEASE);
+          break;
+        case STS_NET_URING_RECV:
+          while (sts_net_receive_packet(&remote->socket)) {
+            length = bench_read_packet(&remote->socket, buffer);
+            if ((packet = sts_net_create_packet_buffer(buffer, length)) == NULL) panic("Cannot create buffer");
+            if (!server->broadcast) {
+              bench_uring_send(&ring, remote, packet);
+            } else {
+              for (j = 0; j < *count; ++j) if (remotes[j].socket.fd != INVALID_SOCKET) bench_uring_send(&ring, &remotes[j], packet);
+            }
+            sts_net_release_buffer(packet);
+          }
+          break;
+        case STS_NET_URING_SEND:
+          if (remote->socket.fd != INVALID_SOCKET) bench_uring_sent(&ring, remote, events[i].result);
+          break;
+        case STS_NET_URING_CLOSED:
+        case STS_NET_URING_ERROR:
+          // the listening socket only fails when the shard stops
+          if (events[i].socket != &shard->listen_socket && remote->socket.fd != INVALID_SOCKET) bench_uring_close(&ring, remote);
+          break;
+      }
+    }
+  }
+  for (i = 0; i < *count; ++i) if (remotes[i].socket.fd != INVALID_SOCKET) bench_uring_close(&ring, &remotes[i]);
+  sts_net_uring_cancel(&ring, &shard->listen_socket);
+  sts_net_uring_wait(&ring, events, 64, 0.0f);
+  sts_net_uring_shutdown(&ring);
+}
+
+
+// checks if the backend can run on this machine
+static int bench_backend_available(int backend) {
+  sts_net_uring_t ring;
+
+  if (backend != BENCH_URING) return 1;
+  if (sts_net_uring_init(&ring, 8) < 0) return 0;
+  sts_net_uring_shutdown(&ring);
+  return 1;
+}
+#else
+static int bench_backend_available(int backend) {
+  return backend == BENCH_POLL;
+}
+#endif // BENCH_THREADS
+
+
+static void bench_connect(int backend, int broadcast, int connections, const char* port) {
+  int     i, accepted = 0, n;
+#ifdef BENCH_THREADS
+  double  end;
+
+  if (backend != BENCH_POLL) {
+    // the shards accept the connections, the main thread only runs the clients
+    if ((bench_threaded = (bench_server_t*)calloc(1, sizeof(bench_server_t))) == NULL) panic("Cannot allocate server");
+    bench_threaded->broadcast = broadcast;
+    if (sts_net_start_reactor(&bench_reactor, port, backend == BENCH_REACTOR ? BENCH_SHARDS : 1,
+                              backend == BENCH_REACTOR ? bench_shard_poll : bench_shard_uring, bench_threaded) < 0) {
+      panic("Cannot start reactor");
+    }
+    sts_net_init_socket_set(&bench_set);
+    for (i = 0; i < connections; ++i) {
+      if (sts_net_open_socket(&bench_clients[i], "127.0.0.1", port) < 0) panic("Cannot connect");
+      if (sts_net_add_socket_to_set(&bench_clients[i], &bench_set) < 0) panic("Cannot add client to set");
+    }
+    end = bench_time() + 10.0;
+    while (__atomic_load_n(&bench_threaded->accepted, __ATOMIC_ACQUIRE) < connections) {
+      if (bench_time() > end) panic("The server didn't accept all connections");
+      sts_net_check_socket_set(&bench_set, 0.01f);
+    }
+    return;
+  }
+#endif // BENCH_THREADS
+  (void)backend; (void)broadcast;
+
+  sts_net_init_socket_set(&bench_set);
+  if (sts_net_open_socket(&bench_server, NULL, port) < 0) panic("Cannot open server");
+  for (i = 0; i < connections; ++i) {
+    if (sts_net_open_socket(&bench_clients[i], "127.0.0.1", port) < 0) panic("Cannot connect");
+    // accept from time to time, so the backlog won't be exhausted
+    if ((i % 64) == 63 || i == connections - 1) {
+      while ((n = sts_net_accept_sockets(&bench_server, &bench_remotes[accepted], i + 1 - accepted, NULL)) > 0) accepted += n;
+      if (n < 0) panic("Cannot accept");
+    }
+  }
+  while (accepted < connections) {
+    if ((n = sts_net_accept_sockets(&bench_server, &bench_remotes[accepted], connections - accepted, NULL)) < 0) panic("Cannot accept");
+    accepted += n;
+  }
+  for (i = 0; i < connections; ++i) {
+    if (sts_net_add_socket_to_set(&bench_clients[i], &bench_set) < 0) panic("Cannot add client to set");
+    if (sts_net_add_socket_to_set(&bench_remotes[i], &bench_set) < 0) panic("Cannot add remote to set");
+  }
+}
+
+
+static void bench_disconnect(int backend, int connections) {
+  int i;
+  for (i = 0; i < connections; ++i) {
+    sts_net_close_socket(&bench_clients[i]);
+    if (backend == BENCH_POLL) sts_net_close_socket(&bench_remotes[i]);
+  }
+  if (backend == BENCH_POLL) sts_net_close_socket(&bench_server);
+#ifdef BENCH_THREADS
+  if (backend != BENCH_POLL) {
+    sts_net_stop_reactor(&bench_reactor);
+    free(bench_threaded);
+    bench_threaded = NULL;
+  }
+#endif // BENCH_THREADS
+}
+
+
+// receive all pending packets of a socket, returns the amount of received packets
+static int bench_receive(sts_net_socket_t* socket, bench_run_t* run, int is_client) {
+  int     count = 0, length;
+  double  sent;
+
+  if (!socket->ready) return 0;
+  if (sts_net_refill_packet_data(socket) < 0) panic("Cannot receive");
+  while (sts_net_receive_packet(socket)) {
+    length = bench_read_packet(socket, bench_buffer);
+    ++count;
+    if (is_client) {
+      memcpy(&sent, bench_buffer, sizeof(sent));
+      sts_net_record_latency(&run->latency, bench_time() - sent);
+      ++run->messages;
+      run->bytes += length;
+    } else if (!run->broadcast) {
+      // echo it back
+      if (sts_net_send_packet(socket, bench_buffer, length) < 0) panic("Cannot echo packet");
+    } else {
+      // broadcast it to all clients
+      sts_net_buffer_t* buffer = sts_net_create_packet_buffer(bench_buffer, length);
+      sts_net_socket_t* remotes[BENCH_MAX_CONNECTIONS];
+      int               i;
+      if (!buffer) panic("Cannot create buffer");
+      for (i = 0; i < run->connections; ++i) remotes[i] = &bench_remotes[i];
+      if (sts_net_broadcast(remotes, run->connections, buffer) < 0) panic("Cannot broadcast");
+      sts_net_release_buffer(buffer);
+    }
+  }
+  return count;
+}
+
+
+static void bench_execute(bench_run_t* run) {
+  double  start, end;
+  int     i, received;
+
+  sts_net_reset_histogram(&run->latency);
+  run->messages = run->bytes = 0;
+  start = bench_time();
+  end = start + run->seconds;
+  if (run->broadcast) {
+    bench_send(&bench_clients[0], run->size);
+  } else {
+    for (i = 0; i < run->connections; ++i) bench_send(&bench_clients[i], run->size);
+  }
+  received = 0;
+  while (bench_time() < end) {
+    if (sts_net_check_socket_set(&bench_set, 0.1f) < 0) panic("Cannot check socket set");
+    for (i = 0; i < run->connections && run->backend == BENCH_POLL; ++i) {
+      if (bench_remotes[i].writable && sts_net_flush_socket(&bench_remotes[i]) < 0) panic("Cannot flush");
+      bench_receive(&bench_remotes[i], run, 0);
+    }
+    for (i = 0; i < run->connections; ++i) {
+      int n = bench_receive(&bench_clients[i], run, 1);
+      if (!run->broadcast) {
+        // one packet in flight per client
+        for (; n > 0; --n) bench_send(&bench_clients[i], run->size);
+      } else if ((received += n) >= run->connections) {
+        // every client got the broadcast, so send the next one
+        received -= run->connections;
+        bench_send(&bench_clients[0], run->size);
+      }
+    }
+  }
+  run->seconds = bench_time() - start;
+  // drain everything which is still in flight
+  while (sts_net_check_socket_set(&bench_set, 0.1f) > 0) {
+    for (i = 0; i < run->connections; ++i) {
+      if (run->backend == BENCH_POLL && bench_remotes[i].writable && sts_net_flush_socket(&bench_remotes[i]) < 0) panic("Cannot flush");
+      if (run->backend == BENCH_POLL && bench_remotes[i].ready) {
+        if (sts_net_refill_packet_data(&bench_remotes[i]) < 0) panic("Cannot receive");
+        while (sts_net_receive_packet(&bench_remotes[i])) sts_net_drop_packet(&bench_remotes[i]);
+      }
+      if (bench_clients[i].ready) {
+        if (sts_net_refill_packet_data(&bench_clients[i]) < 0) panic("Cannot receive");
+        while (sts_net_receive_packet(&bench_clients[i])) sts_net_drop_packet(&bench_clients[i]);
+      }
+    }
+  }
+}
+
+
+// run all workloads on the backend
+static void bench_backend(int backend, double seconds, const char* port) {
+  bench_run_t     run;
+  sts_net_stats_t stats;
+  int             c, s, w;
+
+  for (w = 0; w < 2; ++w) {
+    for (c = 0; c < (int)(sizeof(bench_connections) / sizeof(bench_connections[0])); ++c) {
+      if (bench_connections[c] > BENCH_MAX_CONNECTIONS) continue;
+      bench_connect(backend, w, bench_connections[c], port);
+      for (s = 0; s < (int)(sizeof(bench_sizes) / sizeof(bench_sizes[0])); ++s) {
+        run.backend = backend;
+        run.name = w ? "broadcast" : "echo";
+        run.broadcast = w;
+        run.connections = bench_connections[c];
+        run.size = bench_sizes[s];
+        run.seconds = seconds;
+        sts_net_reset_stats();
+        bench_execute(&run);
+        sts_net_get_stats(&stats);
+        printf("%-9s %-10s %6d %6d %12.0f %10.1f %10.0f %10.0f %9.2f\n", bench_backends[backend], run.name, run.connections, run.size,
+               (double)run.messages / run.seconds, (double)run.bytes / run.seconds / (1024.0 * 1024.0),
+               sts_net_get_latency(&run.latency, 50.0) * 1000000.0, sts_net_get_latency(&run.latency, 99.0) * 1000000.0,
+               run.messages > 0 ? (double)(stats.syscalls_in + stats.syscalls_out) / (double)run.messages : 0.0);
+        fflush(stdout);
+      }
+      bench_disconnect(backend, bench_connections[c]);
+    }
+  }
+}
+
+
+int main(int argc, char *argv[]) {
+  int             b;
+  double          seconds = argc > 1 ? atof(argv[1]) : 1.0;
+  const char*     port = argc > 2 ? argv[2] : "4041";
+
+#ifndef _WIN32
+  {
+    // every connection needs two file descriptors
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < BENCH_MAX_CONNECTIONS * 2 + 64) {
+      limit.rlim_cur = limit.rlim_max < BENCH_MAX_CONNECTIONS * 2 + 64 ? limit.rlim_max : BENCH_MAX_CONNECTIONS * 2 + 64;
+      setrlimit(RLIMIT_NOFILE, &limit);
+    }
+  }
+#endif // _WIN32
+
+  if (sts_net_init() < 0) panic("Cannot initialize sts_net");
+  printf("%-9s %-10s %6s %6s %12s %10s %10s %10s %9s\n", "backend", "workload", "conns", "size", "msgs/sec", "MB/s", "p50 us", "p99 us", "sys/msg");
+  for (b = 0; b < BENCH_BACKENDS; ++b) {
+    if (!bench_backend_available(b)) {
+      fprintf(stderr, "%s is not available (%s), skipping it\n", bench_backends[b], sts_net_get_last_error());
+      continue;
+    }
+    bench_backend(b, seconds, port);
+  }
+  sts_net_shutdown();
+  return 0;
+}
+/*
+  This is free and unencumbered software released into the public domain.
+
+  Anyone is free to copy, modify, publish, use, compile, sell, or
+  distribute this software, either in source code form or as a compiled
+  binary, for any purpose, commercial or non-commercial, and by any
+  means.
+
+  In jurisdictions that recognize copyright laws, the author or authors
+  of this software dedicate any and all copyright interest in the
+  software to the public domain. We make this dedication for the benefit
+  of the public at large and to the detriment of our heirs and
+  successors. We intend this dedication to be an overt act of
+  relinquishment in perpetuity of all present and future rights to this
+  software under copyright law.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+  OTHER DEALINGS IN THE SOFTWARE.
+
+  For more information, please refer to <http://unlicense.org/>
+*/
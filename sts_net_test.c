@@ -0,0 +1,368 @@
+////////////////////////////////////////////////////////////////////////////////
+/*
+ sts_net_test.c - public domain
+ regression tests for sts_net.h
+
+  ABOUT
+    Runs servers and clients in a single process over loopback and checks the
+    behavior of the packet API which is hard to see in the benchmark.
+
+  BUILD
+    cc -O2 -o sts_net_test sts_net_test.c -lpthread     (Linux / macOS)
+    cl /O2 sts_net_test.c                               (Windows)
+
+  USAGE
+    sts_net_test [port]
+
+*/
+////////////////////////////////////////////////////////////////////////////////
+// include sts_net.h first, so it can enable _GNU_SOURCE (accept4, recvmmsg and shared rings on Linux)
+#define STS_NET_IMPLEMENTATION
+#include "sts_net.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+
+static const char*  test_port = "4042";
+static int          test_failed = 0;
+
+
+#define TEST_CHECK(cond, msg)   do { if (!(cond)) { test_fail(__LINE__, msg); return; } } while (0)
+
+
+static void test_fail(int line, const char* msg) {
+  fprintf(stderr, "  line %d: %s (%s)\n", line, msg, sts_net_get_last_error());
+  ++test_failed;
+}
+
+
+static double test_time() {
+#ifdef _WIN32
+  LARGE_INTEGER counter, frequency;
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&frequency);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+#endif // _WIN32
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  dispatcher
+//
+#define TEST_DISPATCH_CLIENTS   4
+#define TEST_DISPATCH_REQUESTS  (STS_NET_SEND_QUEUE * 4)
+
+
+static void test_echo(sts_net_job_t* job) {
+  sts_net_reply(job, job->data, job->length);
+}
+
+
+// more replies than fit into the send queue are in flight for every socket
+static void test_dispatcher_replies() {
+  sts_net_dispatcher_t  dispatcher;
+  sts_net_socket_t      server, clients[TEST_DISPATCH_CLIENTS], remotes[TEST_DISPATCH_CLIENTS];
+  sts_net_set_t         set;
+  sts_net_packet_t      packet;
+  int                   i, j, expected[TEST_DISPATCH_CLIENTS], received = 0, value;
+  double                end;
+
+  TEST_CHECK(sts_net_start_dispatcher(&dispatcher, 4, test_echo, NULL) == 0, "Cannot start dispatcher");
+  TEST_CHECK(sts_net_open_socket(&server, NULL, test_port) == 0, "Cannot open server");
+  sts_net_init_socket_set(&set);
+  sts_net_add_socket_to_set(&dispatcher.wakeup_socket, &set);
+  for (i = 0; i < TEST_DISPATCH_CLIENTS; ++i) {
+    TEST_CHECK(sts_net_open_socket(&clients[i], "127.0.0.1", test_port) == 0, "Cannot connect");
+    TEST_CHECK(sts_net_accept_socket(&server, &remotes[i]) == 0, "Cannot accept");
+    sts_net_add_socket_to_set(&clients[i], &set);
+    sts_net_add_socket_to_set(&remotes[i], &set);
+    expected[i] = 0;
+    for (j = 0; j < TEST_DISPATCH_REQUESTS; ++j) {
+      TEST_CHECK(sts_net_send_packet(&clients[i], &j, sizeof(j)) == 0, "Cannot send request");
+    }
+  }
+
+  end = test_time() + 5.0;
+  while (received < TEST_DISPATCH_CLIENTS * TEST_DISPATCH_REQUESTS && test_time() < end) {
+    TEST_CHECK(sts_net_check_socket_set(&set, 0.1f) >= 0, "Cannot check socket set");
+    for (i = 0; i < TEST_DISPATCH_CLIENTS; ++i) {
+      if (remotes[i].ready) {
+        TEST_CHECK(sts_net_refill_packet_data(&remotes[i]) >= 0, "Cannot receive requests");
+        TEST_CHECK(sts_net_dispatch_packets(&dispatcher, &remotes[i]) >= 0, "Cannot dispatch");
+      }
+      if (remotes[i].writable) TEST_CHECK(sts_net_flush_socket(&remotes[i]) >= 0, "Cannot flush");
+    }
+    if (dispatcher.wakeup_socket.ready || dispatcher.pending > 0) sts_net_send_replies(&dispatcher);
+    for (i = 0; i < TEST_DISPATCH_CLIENTS; ++i) {
+      if (!clients[i].ready) continue;
+      TEST_CHECK(sts_net_refill_packet_data(&clients[i]) >= 0, "Cannot receive replies");
+      while (sts_net_receive_packet(&clients[i])) {
+        sts_net_get_packet(&clients[i], &packet);
+        TEST_CHECK(packet.length[0] + packet.length[1] == sizeof(value), "Wrong reply size");
+        memcpy(&value, packet.data[0], packet.length[0]);
+        if (packet.length[1] > 0) memcpy((char*)&value + packet.length[0], packet.data[1], packet.length[1]);
+        TEST_CHECK(value == expected[i], "Replies are out of order");
+        ++expected[i];
+        ++received;
+        sts_net_drop_packet(&clients[i]);
+      }
+    }
+  }
+  TEST_CHECK(received == TEST_DISPATCH_CLIENTS * TEST_DISPATCH_REQUESTS, "Not all replies arrived");
+  TEST_CHECK(dispatcher.pending == 0, "Replies are still pending");
+
+  sts_net_stop_dispatcher(&dispatcher);
+  for (i = 0; i < TEST_DISPATCH_CLIENTS; ++i) {
+    sts_net_close_socket(&clients[i]);
+    sts_net_close_socket(&remotes[i]);
+  }
+  sts_net_close_socket(&server);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  connections
+//
+// receive all pending datagrams of the socket and pass them to the connection (except the first "drop" ones),
+// returns the amount of received datagrams
+static int test_receive_datagrams(sts_net_set_t* set, sts_net_socket_t* socket, sts_net_connection_t** connection, int drop) {
+  char                buffers[4][STS_NET_CONNECTION_MTU];
+  sts_net_datagram_t  datagrams[4];
+  int                 i, n, received = 0;
+
+  while (sts_net_check_socket_set(set, 0.0f) > 0 && socket->ready) {
+    for (i = 0; i < 4; ++i) {
+      datagrams[i].data = buffers[i];
+      datagrams[i].size = sizeof(buffers[i]);
+    }
+    if ((n = sts_net_recv_datagrams(socket, datagrams, 4)) < 0) return -1;
+    for (i = 0; i < n; ++i, ++received) {
+      if (!*connection && (*connection = sts_net_create_connection(socket, &datagrams[i].address)) == NULL) return -1;
+      if (received < drop) continue;
+      if (sts_net_process_datagram(*connection, datagrams[i].data, datagrams[i].length) < 0) return -1;
+    }
+  }
+  return received;
+}
+
+
+// the first datagram of the server carries a reliable message and gets lost, the client
+// must not acknowledge it before it received anything
+static void test_connection_first_datagram() {
+  sts_net_socket_t      server, client;
+  sts_net_set_t         server_set, client_set;
+  sts_net_connection_t  *server_connection = NULL, *client_connection;
+  sts_net_buffer_t*     message;
+  int                   channel, received = 0, welcomed = 0, sent_welcome = 0;
+  double                end;
+
+  TEST_CHECK(sts_net_open_datagram_socket(&server, NULL, test_port) == 0, "Cannot open server");
+  TEST_CHECK(sts_net_open_datagram_socket(&client, "127.0.0.1", test_port) == 0, "Cannot open client");
+  sts_net_init_socket_set(&server_set);
+  sts_net_init_socket_set(&client_set);
+  sts_net_add_socket_to_set(&server, &server_set);
+  sts_net_add_socket_to_set(&client, &client_set);
+  TEST_CHECK((client_connection = sts_net_create_connection(&client, NULL)) != NULL, "Cannot create connection");
+
+  end = test_time() + 3.0;
+  while (!welcomed && test_time() < end) {
+    TEST_CHECK(sts_net_send_message(client_connection, STS_NET_UNRELIABLE, "hello", 5) == 0, "Cannot send hello");
+    TEST_CHECK(sts_net_update_connection(client_connection) == 0, "Cannot update client");
+    TEST_CHECK(test_receive_datagrams(&server_set, &server, &server_connection, 0) >= 0, "Cannot receive on server");
+    if (server_connection) {
+      if (!sent_welcome) {
+        TEST_CHECK(sts_net_send_message(server_connection, STS_NET_RELIABLE, "welcome", 7) == 0, "Cannot send welcome");
+        sent_welcome = 1;
+      }
+      TEST_CHECK(sts_net_update_connection(server_connection) == 0, "Cannot update server");
+    }
+    // drop the first datagram the client gets
+    TEST_CHECK(sts_net_check_socket_set(&client_set, 0.01f) >= 0, "Cannot check socket set");
+    if (client.ready) {
+      int n = test_receive_datagrams(&client_set, &client, &client_connection, received == 0 ? 1 : 0);
+      TEST_CHECK(n >= 0, "Cannot receive on client");
+      received += n;
+    }
+    while ((message = sts_net_receive_message(client_connection, &channel)) != NULL) {
+      if (channel == STS_NET_RELIABLE && message->length == 7 && memcmp(message->data, "welcome", 7) == 0) welcomed = 1;
+      sts_net_release_buffer(message);
+    }
+  }
+  TEST_CHECK(received > 1, "The server didn't send enough datagrams");
+  TEST_CHECK(welcomed, "The lost reliable message was never resent");
+
+  sts_net_destroy_connection(client_connection);
+  sts_net_destroy_connection(server_connection);
+  sts_net_close_socket(&client);
+  sts_net_close_socket(&server);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  accepting
+//
+#define TEST_ACCEPT_CLIENTS     3
+
+
+// accepting all pending connections at once must leave a blocking server socket blocking
+static void test_accept_sockets() {
+  sts_net_socket_t  server, clients[TEST_ACCEPT_CLIENTS], remotes[TEST_ACCEPT_CLIENTS * 2];
+  sts_net_set_t     set;
+  int               i, n, accepted = 0;
+  double            end;
+
+  TEST_CHECK(sts_net_open_socket(&server, NULL, test_port) == 0, "Cannot open server");
+  TEST_CHECK(sts_net_set_socket_backlog(&server, TEST_ACCEPT_CLIENTS * 2) == 0, "Cannot change the backlog");
+  for (i = 0; i < TEST_ACCEPT_CLIENTS; ++i) {
+    TEST_CHECK(sts_net_open_socket(&clients[i], "127.0.0.1", test_port) == 0, "Cannot open client");
+  }
+  sts_net_init_socket_set(&set);
+  sts_net_add_socket_to_set(&server, &set);
+  end = test_time() + 3.0;
+  while (accepted < TEST_ACCEPT_CLIENTS && test_time() < end) {
+    TEST_CHECK(sts_net_check_socket_set(&set, 0.1f) >= 0, "Cannot check socket set");
+    if (!server.ready) continue;
+    n = sts_net_accept_sockets(&server, &remotes[accepted], TEST_ACCEPT_CLIENTS * 2 - accepted, NULL);
+    TEST_CHECK(n >= 0, "Cannot accept");
+    accepted += n;
+  }
+  TEST_CHECK(accepted == TEST_ACCEPT_CLIENTS, "Not all connections were accepted");
+#ifndef _WIN32
+  TEST_CHECK(!(fcntl(server.fd, F_GETFL, 0) & O_NONBLOCK), "The server socket was left non-blocking");
+#endif // _WIN32
+
+  for (i = 0; i < accepted; ++i) sts_net_close_socket(&remotes[i]);
+  for (i = 0; i < TEST_ACCEPT_CLIENTS; ++i) sts_net_close_socket(&clients[i]);
+  sts_net_close_socket(&server);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  shared rings
+//
+#ifdef __linux__
+// a full ring must not be writable in the socket set until the reader made space
+static void test_shared_ring_full() {
+  sts_net_socket_t  server, link, remote, writer, reader;
+  sts_net_set_t     set;
+  sts_net_buffer_t* buffer;
+  char              data[4096];
+  double            start;
+  int               i;
+
+  TEST_CHECK(sts_net_open_socket(&server, NULL, "unix:@sts_net_test") == 0, "Cannot open unix server");
+  TEST_CHECK(sts_net_open_socket(&link, "unix:@sts_net_test", NULL) == 0, "Cannot connect unix socket");
+  TEST_CHECK(sts_net_accept_socket(&server, &remote) == 0, "Cannot accept unix socket");
+  TEST_CHECK(sts_net_create_shared_ring(&writer, &remote, 4096) == 0, "Cannot create shared ring");
+  TEST_CHECK(sts_net_accept_shared_ring(&reader, &link) == 0, "Cannot accept shared ring");
+
+  // two rings worth of data, so some of it stays queued
+  TEST_CHECK((buffer = sts_net_create_buffer(NULL, 8192)) != NULL, "Cannot create buffer");
+  memset(buffer->data, 'x', 8192);
+  TEST_CHECK(sts_net_queue_buffer(&writer, buffer) == 0, "Cannot queue buffer");
+  sts_net_release_buffer(buffer);
+  TEST_CHECK(sts_net_flush_socket(&writer) == 1, "The ring took more than it can hold");
+
+  sts_net_init_socket_set(&set);
+  sts_net_add_socket_to_set(&writer, &set);
+  start = test_time();
+  for (i = 0; i < 10; ++i) {
+    TEST_CHECK(sts_net_check_socket_set(&set, 0.01f) >= 0, "Cannot check socket set");
+    TEST_CHECK(!writer.writable, "A full ring is writable");
+  }
+  TEST_CHECK(test_time() - start >= 0.05, "Waiting on a full ring returned early");
+
+  // reading makes space and wakes up the writer
+  TEST_CHECK(sts_net_recv(&reader, data, sizeof(data)) > 0, "Cannot read from the ring");
+  TEST_CHECK(sts_net_check_socket_set(&set, 1.0f) > 0 && writer.writable, "The writer wasn't woken up");
+  TEST_CHECK(sts_net_flush_socket(&writer) == 0, "Cannot send the rest");
+#ifndef STS_NET_NO_STATS
+  {
+    sts_net_stats_t stats;
+    sts_net_get_socket_stats(&writer, &stats);
+    TEST_CHECK(stats.bytes_out == 8192 && stats.packets_out == 1 && stats.queue_high == 1, "Wrong socket statistics");
+  }
+#endif // STS_NET_NO_STATS
+
+  sts_net_close_socket(&reader);
+  sts_net_close_socket(&writer);
+  sts_net_close_socket(&remote);
+  sts_net_close_socket(&link);
+  sts_net_close_socket(&server);
+}
+#endif // __linux__
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  main
+//
+typedef struct {
+  const char* name;
+  void        (*func)();
+} test_t;
+
+
+static const test_t tests[] = {
+  { "dispatcher replies", test_dispatcher_replies },
+  { "connection first datagram", test_connection_first_datagram },
+  { "accept sockets", test_accept_sockets },
+#ifdef __linux__
+  { "shared ring full", test_shared_ring_full },
+#endif // __linux__
+};
+
+
+int main(int argc, char *argv[]) {
+  int i, failed;
+
+  if (argc > 1) test_port = argv[1];
+  if (sts_net_init() < 0) {
+    fprintf(stderr, "Cannot initialize sts_net (%s)\n", sts_net_get_last_error());
+    return EXIT_FAILURE;
+  }
+  for (i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); ++i) {
+    failed = test_failed;
+    tests[i].func();
+    printf("%-30s %s\n", tests[i].name, failed == test_failed ? "ok" : "FAILED");
+    fflush(stdout);
+  }
+  sts_net_shutdown();
+  return test_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+/*
+  This is free and unencumbered software released into the public domain.
+
+  Anyone is free to copy, modify, publish, use, compile, sell, or
+  distribute this software, either in source code form or as a compiled
+  binary, for any purpose, commercial or non-commercial, and by any
+  means.
+
+  In jurisdictions that recognize copyright laws, the author or authors
+  of this software dedicate any and all copyright interest in the
+  software to the public domain. We make this dedication for the benefit
+  of the public at large and to the detriment of our heirs and
+  successors. We intend this dedication to be an overt act of
+  relinquishment in perpetuity of all present and future rights to this
+  software under copyright law.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+  OTHER DEALINGS IN THE SOFTWARE.
+
+  For more information, please refer to <http://unlicense.org/>
+*/
@@ -0,0 +1,576 @@
+////////////////////////////////////////////////////////////////////////////////
+/*
+ sts_snapshot.h - v0.01 - public domain
+
+  VERSION HISTORY
+    0.01 (2026-10-19) initial version
+
+  LICENSE
+    Public domain. See "unlicense" statement at the end of this file.
+
+  ABOUT
+    Delta compressed replication of game state snapshots on top of the sts_net.h packet API.
+    A snapshot is a fixed amount of objects with the same fields. Every field is quantized to
+    the amount of bits given in the schema. The sender keeps the snapshots it sent to a peer
+    and only encodes the fields which changed since the last snapshot the peer acknowledged.
+
+  USAGE
+    Sender (once per tick and client):
+      sts_snapshot_set_float(&world, object, FIELD_X, x);
+      ...
+      packet = sts_snapshot_create_packet(&client->peer, &world);
+      sts_net_queue_buffer(&client->socket, packet);
+      sts_net_release_buffer(packet);
+      ...when the client acknowledged a snapshot: sts_snapshot_ack(&client->peer, sequence);
+
+    Receiver:
+      if (sts_snapshot_decode_packet(&peer, &packet, &world) > 0) {
+        ...send world.sequence back to the sender, so it can be used as baseline...
+        x = sts_snapshot_get_float(&world, object, FIELD_X);
+      }
+
+  DEPENDENCIES
+    sts_net
+
+*/
+////////////////////////////////////////////////////////////////////////////////
+#ifndef __INCLUDED__STS_SNAPSHOT_H__
+#define __INCLUDED__STS_SNAPSHOT_H__
+
+
+#include "sts_net.h"
+
+
+#ifndef STS_SNAPSHOT_HISTORY
+// the amount of sent / received snapshots kept for every peer, older snapshots can't be used as baseline
+// (at most 255, the distance to the baseline is sent with 8 bits)
+#define STS_SNAPSHOT_HISTORY    32
+#endif // STS_SNAPSHOT_HISTORY
+
+
+// the field types
+enum {
+  STS_SNAPSHOT_UINT,        // unsigned integer with "bits" bits
+  STS_SNAPSHOT_INT,         // signed integer with "bits" bits
+  STS_SNAPSHOT_FLOAT        // float between "min" and "max" quantized to "bits" bits
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Structures
+//
+typedef struct {
+  int   type;           // one of STS_SNAPSHOT_*
+  int   bits;           // bits used on the wire (1 - 32)
+  float min, max;       // range of float fields
+} sts_snapshot_field_t;
+
+
+// Describes the layout of a snapshot. Both sides have to use the same schema.
+typedef struct {
+  const sts_snapshot_field_t* fields;     // the fields of every object
+  int                         field_count;
+  int                         object_count; // the amount of objects of a snapshot
+} sts_snapshot_schema_t;
+
+
+typedef struct {
+  const sts_snapshot_schema_t*  schema;
+  int                           sequence;   // number of this snapshot (set by sts_snapshot_create_packet / sts_snapshot_decode_packet)
+  unsigned char*                active;     // flag for every object if it exists
+  unsigned int*                 values;     // the quantized values (object_count * field_count)
+} sts_snapshot_t;
+
+
+// The replication state of one peer. The sender needs one for every client, the receiver one for the sender.
+typedef struct {
+  const sts_snapshot_schema_t*  schema;
+  int                           sequence;   // sequence of the last sent / received snapshot (-1 if none)
+  int                           acked;      // sequence of the last acknowledged snapshot (-1 if none)
+  sts_snapshot_t                history[STS_SNAPSHOT_HISTORY];
+} sts_snapshot_peer_t;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Snapshots
+//
+// Initialize the snapshot, all objects will be inactive and all values 0.
+// Returns -1 if the memory couldn't be allocated.
+int sts_snapshot_init(sts_snapshot_t* snapshot, const sts_snapshot_schema_t* schema);
+
+// Free the memory of the snapshot.
+void sts_snapshot_free(sts_snapshot_t* snapshot);
+
+// Copy all objects and values (both snapshots need the same schema).
+void sts_snapshot_copy(sts_snapshot_t* dst, const sts_snapshot_t* src);
+
+// Mark the object as existing or not. Fields of inactive objects are not sent.
+void sts_snapshot_set_active(sts_snapshot_t* snapshot, int object, int active);
+int sts_snapshot_is_active(const sts_snapshot_t* snapshot, int object);
+
+// Set / get a field of an object. Values are quantized, so you will get the quantized value back.
+void sts_snapshot_set_int(sts_snapshot_t* snapshot, int object, int field, int value);
+int sts_snapshot_get_int(const sts_snapshot_t* snapshot, int object, int field);
+void sts_snapshot_set_float(sts_snapshot_t* snapshot, int object, int field, float value);
+float sts_snapshot_get_float(const sts_snapshot_t* snapshot, int object, int field);
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Replication
+//
+// Initialize the peer. Returns -1 if the memory couldn't be allocated.
+int sts_snapshot_init_peer(sts_snapshot_peer_t* peer, const sts_snapshot_schema_t* schema);
+
+// Free the memory of the peer.
+void sts_snapshot_free_peer(sts_snapshot_peer_t* peer);
+
+// The sender got the acknowledgment of the snapshot with this sequence, it will be the baseline of the next snapshots.
+void sts_snapshot_ack(sts_snapshot_peer_t* peer, int sequence);
+
+// The maximum amount of bytes an encoded snapshot of the schema needs.
+int sts_snapshot_max_size(const sts_snapshot_schema_t* schema);
+
+// Encode the snapshot as the next snapshot of the peer relative to the last acknowledged snapshot.
+// The snapshot gets the next sequence of the peer.
+//  returns:
+//    -1  on errors (the data doesn't fit into "capacity" bytes)
+//    >0  the amount of bytes written to "data"
+int sts_snapshot_encode(sts_snapshot_peer_t* peer, sts_snapshot_t* snapshot, void* data, int capacity);
+
+// Decode a snapshot of the peer into "snapshot". The data might be split into two spans (pass NULL / 0 if not).
+//  returns:
+//    -1  on errors (corrupted data or the baseline isn't known anymore)
+//     0  if the snapshot is older than the last decoded snapshot (it will be ignored)
+//     1  if "snapshot" holds the new snapshot
+int sts_snapshot_decode(sts_snapshot_peer_t* peer, const void* data0, int length0, const void* data1, int length1, sts_snapshot_t* snapshot);
+
+#ifndef STS_NET_NO_PACKETS
+// Encode the snapshot into a packet buffer (see sts_snapshot_encode).
+sts_net_buffer_t* sts_snapshot_create_packet(sts_snapshot_peer_t* peer, sts_snapshot_t* snapshot);
+
+// Decode the packet (see sts_snapshot_decode).
+int sts_snapshot_decode_packet(sts_snapshot_peer_t* peer, const sts_net_packet_t* packet, sts_snapshot_t* snapshot);
+#endif // STS_NET_NO_PACKETS
+
+// Get the last error.
+const char* sts_snapshot_get_last_error();
+
+
+#endif // __INCLUDED__STS_SNAPSHOT_H__
+
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////
+////    IMPLEMENTATION
+////
+////
+#ifdef STS_SNAPSHOT_IMPLEMENTATION
+#include <string.h>   // memcpy, memset
+
+
+#ifndef sts__memcpy
+#define sts__memcpy     memcpy
+#endif // sts__memcpy
+#ifndef sts__memset
+#define sts__memset     memset
+#endif // sts__memset
+#ifndef sts__malloc
+#include <stdlib.h>
+#define sts__malloc     malloc
+#define sts__free       free
+#endif // sts__malloc
+
+
+static const char* sts_snapshot__error_message = "";
+
+
+static int sts_snapshot__set_error(const char* message) {
+  sts_snapshot__error_message = message;
+  return -1;
+}
+
+
+const char* sts_snapshot_get_last_error() {
+  return sts_snapshot__error_message;
+}
+
+
+// all bits of a field
+static unsigned int sts_snapshot__mask(int bits) {
+  return bits >= 32 ? 0xffffffffU : (1U << bits) - 1U;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Bit streams
+//
+typedef struct {
+  unsigned char*        data;
+  int                   capacity;
+  int                   length;       // amount of written bytes
+  int                   count;        // amount of bits in "bits"
+  unsigned long long    bits;
+} sts_snapshot__writer_t;
+
+
+typedef struct {
+  const unsigned char*  data[2];
+  int                   length[2];
+  int                   position;     // next byte to read
+  int                   count;        // amount of bits in "bits"
+  unsigned long long    bits;
+} sts_snapshot__reader_t;
+
+
+static void sts_snapshot__write(sts_snapshot__writer_t* w, unsigned int value, int bits) {
+  w->bits = (w->bits << bits) | (value & sts_snapshot__mask(bits));
+  w->count += bits;
+  while (w->count >= 8) {
+    w->count -= 8;
+    if (w->length < w->capacity) w->data[w->length] = (unsigned char)(w->bits >> w->count);
+    ++w->length;
+  }
+}
+
+
+// write the remaining bits, returns the amount of bytes or -1 if they didn't fit
+static int sts_snapshot__flush(sts_snapshot__writer_t* w) {
+  if (w->count > 0) sts_snapshot__write(w, 0, 8 - w->count);
+  return w->length <= w->capacity ? w->length : -1;
+}
+
+
+// read "bits" bits, returns -1 if there is not enough data
+static int sts_snapshot__read(sts_snapshot__reader_t* r, int bits, unsigned int* value) {
+  int i;
+  while (r->count < bits) {
+    i = r->position++;
+    if (i < r->length[0]) {
+      r->bits = (r->bits << 8) | r->data[0][i];
+    } else if (i - r->length[0] < r->length[1]) {
+      r->bits = (r->bits << 8) | r->data[1][i - r->length[0]];
+    } else {
+      return -1;
+    }
+    r->count += 8;
+  }
+  r->count -= bits;
+  *value = (unsigned int)(r->bits >> r->count) & sts_snapshot__mask(bits);
+  return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Snapshots
+//
+int sts_snapshot_init(sts_snapshot_t* snapshot, const sts_snapshot_schema_t* schema) {
+  size_t count = (size_t)schema->object_count * (size_t)schema->field_count;
+
+  snapshot->schema = schema;
+  snapshot->sequence = -1;
+  snapshot->active = (unsigned char*)sts__malloc((size_t)schema->object_count);
+  snapshot->values = (unsigned int*)sts__malloc(sizeof(unsigned int) * count);
+  if (!snapshot->active || !snapshot->values) {
+    sts_snapshot_free(snapshot);
+    return sts_snapshot__set_error("Cannot allocate snapshot");
+  }
+  sts__memset(snapshot->active, 0, (size_t)schema->object_count);
+  sts__memset(snapshot->values, 0, sizeof(unsigned int) * count);
+  return 0;
+}
+
+
+void sts_snapshot_free(sts_snapshot_t* snapshot) {
+  if (snapshot->active) sts__free(snapshot->active);
+  if (snapshot->values) sts__free(snapshot->values);
+  snapshot->active = NULL;
+  snapshot->values = NULL;
+}
+
+
+void sts_snapshot_copy(sts_snapshot_t* dst, const sts_snapshot_t* src) {
+  const sts_snapshot_schema_t* schema = src->schema;
+
+  dst->sequence = src->sequence;
+  sts__memcpy(dst->active, src->active, (size_t)schema->object_count);
+  sts__memcpy(dst->values, src->values, sizeof(unsigned int) * (size_t)schema->object_count * (size_t)schema->field_count);
+}
+
+
+void sts_snapshot_set_active(sts_snapshot_t* snapshot, int object, int active) {
+  snapshot->active[object] = active ? 1 : 0;
+}
+
+
+int sts_snapshot_is_active(const sts_snapshot_t* snapshot, int object) {
+  return snapshot->active[object];
+}
+
+
+void sts_snapshot_set_int(sts_snapshot_t* snapshot, int object, int field, int value) {
+  const sts_snapshot_field_t* f = &snapshot->schema->fields[field];
+  snapshot->values[object * snapshot->schema->field_count + field] = (unsigned int)value & sts_snapshot__mask(f->bits);
+}
+
+
+int sts_snapshot_get_int(const sts_snapshot_t* snapshot, int object, int field) {
+  const sts_snapshot_field_t* f = &snapshot->schema->fields[field];
+  unsigned int                value = snapshot->values[object * snapshot->schema->field_count + field];
+
+  // sign extend signed integers
+  if (f->type == STS_SNAPSHOT_INT && f->bits < 32 && (value >> (f->bits - 1)) & 1U) value |= ~sts_snapshot__mask(f->bits);
+  return (int)value;
+}
+
+
+void sts_snapshot_set_float(sts_snapshot_t* snapshot, int object, int field, float value) {
+  const sts_snapshot_field_t* f = &snapshot->schema->fields[field];
+  double                      steps = (double)sts_snapshot__mask(f->bits), q;
+
+  if (f->type != STS_SNAPSHOT_FLOAT) {
+    sts_snapshot_set_int(snapshot, object, field, (int)value);
+    return;
+  }
+  q = f->max > f->min ? ((double)value - (double)f->min) / ((double)f->max - (double)f->min) * steps + 0.5 : 0.0;
+  if (q < 0.0) q = 0.0;
+  if (q > steps) q = steps;
+  snapshot->values[object * snapshot->schema->field_count + field] = (unsigned int)q;
+}
+
+
+float sts_snapshot_get_float(const sts_snapshot_t* snapshot, int object, int field) {
+  const sts_snapshot_field_t* f = &snapshot->schema->fields[field];
+  unsigned int                value = snapshot->values[object * snapshot->schema->field_count + field];
+
+  if (f->type != STS_SNAPSHOT_FLOAT) return (float)sts_snapshot_get_int(snapshot, object, field);
+  return (float)((double)f->min + (double)value / (double)sts_snapshot__mask(f->bits) * ((double)f->max - (double)f->min));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//    Replication
+//
+//  Wire format (bit packed, most significant bit first):
+//    16 bits   sequence of the snapshot (lowest 16 bits)
+//     8 bits   distance to the baseline sequence (0 if there's no baseline, so all values are relative to 0)
+//  for every object:
+//     1 bit    changed flag, the following is only present if the object changed
+//     1 bit    active flag, the following is only present if the object is active
+//  for every field:
+//     1 bit    changed flag, followed by the value if it changed
+//
+int sts_snapshot_init_peer(sts_snapshot_peer_t* peer, const sts_snapshot_schema_t* schema) {
+  int i;
+
+  peer->schema = schema;
+  peer->sequence = peer->acked = -1;
+  for (i = 0; i < STS_SNAPSHOT_HISTORY; ++i) {
+    peer->history[i].active = NULL;
+    peer->history[i].values = NULL;
+  }
+  for (i = 0; i < STS_SNAPSHOT_HISTORY; ++i) {
+    if (sts_snapshot_init(&peer->history[i], schema) < 0) {
+      sts_snapshot_free_peer(peer);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+
+void sts_snapshot_free_peer(sts_snapshot_peer_t* peer) {
+  int i;
+  for (i = 0; i < STS_SNAPSHOT_HISTORY; ++i) sts_snapshot_free(&peer->history[i]);
+}
+
+
+void sts_snapshot_ack(sts_snapshot_peer_t* peer, int sequence) {
+  if (sequence > peer->acked && sequence <= peer->sequence) peer->acked = sequence;
+}
+
+
+int sts_snapshot_max_size(const sts_snapshot_schema_t* schema) {
+  int i, bits = 2;
+
+  for (i = 0; i < schema->field_count; ++i) bits += 1 + schema->fields[i].bits;
+  return (24 + schema->object_count * bits + 7) / 8;
+}
+
+
+// get the snapshot with this sequence from the history (NULL if it's not there anymore)
+static sts_snapshot_t* sts_snapshot__find(sts_snapshot_peer_t* peer, int sequence) {
+  sts_snapshot_t* snapshot;
+
+  if (sequence < 0) return NULL;
+  snapshot = &peer->history[sequence % STS_SNAPSHOT_HISTORY];
+  return snapshot->sequence == sequence ? snapshot : NULL;
+}
+
+
+int sts_snapshot_encode(sts_snapshot_peer_t* peer, sts_snapshot_t* snapshot, void* data, int capacity) {
+  const sts_snapshot_schema_t*  schema = peer->schema;
+  sts_snapshot_t*               baseline;
+  sts_snapshot__writer_t        w;
+  const unsigned int            *values, *base;
+  int                           sequence = peer->sequence + 1, i, j, changed, length;
+
+  // the baseline is the last acknowledged snapshot, if it's still in the history
+  baseline = sequence - peer->acked < STS_SNAPSHOT_HISTORY ? sts_snapshot__find(peer, peer->acked) : NULL;
+  w.data = (unsigned char*)data;
+  w.capacity = capacity;
+  w.length = w.count = 0;
+  w.bits = 0;
+  sts_snapshot__write(&w, (unsigned int)sequence, 16);
+  sts_snapshot__write(&w, baseline ? (unsigned int)(sequence - baseline->sequence) : 0U, 8);
+  for (i = 0; i < schema->object_count; ++i) {
+    values = &snapshot->values[i * schema->field_count];
+    // the values of inactive objects are 0 on the other side
+    base = baseline && baseline->active[i] ? &baseline->values[i * schema->field_count] : NULL;
+    changed = snapshot->active[i] != (baseline ? baseline->active[i] : 0);
+    for (j = 0; !changed && snapshot->active[i] && j < schema->field_count; ++j) {
+      changed = values[j] != (base ? base[j] : 0U);
+    }
+    sts_snapshot__write(&w, (unsigned int)changed, 1);
+    if (!changed) continue;
+    sts_snapshot__write(&w, snapshot->active[i], 1);
+    if (!snapshot->active[i]) continue;
+    for (j = 0; j < schema->field_count; ++j) {
+      changed = values[j] != (base ? base[j] : 0U);
+      sts_snapshot__write(&w, (unsigned int)changed, 1);
+      if (changed) sts_snapshot__write(&w, values[j], schema->fields[j].bits);
+    }
+  }
+  if ((length = sts_snapshot__flush(&w)) < 0) return sts_snapshot__set_error("Snapshot is too large");
+  // keep it the way the other side sees it, so it can be the baseline of later snapshots
+  snapshot->sequence = peer->sequence = sequence;
+  baseline = &peer->history[sequence % STS_SNAPSHOT_HISTORY];
+  sts_snapshot_copy(baseline, snapshot);
+  for (i = 0; i < schema->object_count; ++i) {
+    if (!baseline->active[i]) sts__memset(&baseline->values[i * schema->field_count], 0, sizeof(unsigned int) * (size_t)schema->field_count);
+  }
+  return length;
+}
+
+
+int sts_snapshot_decode(sts_snapshot_peer_t* peer, const void* data0, int length0, const void* data1, int length1, sts_snapshot_t* snapshot) {
+  const sts_snapshot_schema_t*  schema = peer->schema;
+  sts_snapshot_t                *baseline = NULL, *current;
+  sts_snapshot__reader_t        r;
+  unsigned int                  value, distance, *values;
+  int                           sequence, i, j;
+
+  r.data[0] = (const unsigned char*)data0;
+  r.length[0] = data0 ? length0 : 0;
+  r.data[1] = (const unsigned char*)data1;
+  r.length[1] = data1 ? length1 : 0;
+  r.position = r.count = 0;
+  r.bits = 0;
+  if (sts_snapshot__read(&r, 16, &value) < 0 || sts_snapshot__read(&r, 8, &distance) < 0) {
+    return sts_snapshot__set_error("Received corrupted snapshot");
+  }
+  // restore the full sequence from the last received one
+  sequence = peer->sequence < 0 ? (int)value : peer->sequence + (short)(unsigned short)(value - (unsigned int)peer->sequence);
+  if (sequence <= peer->sequence) return 0;
+  if (distance > 0) {
+    if ((int)distance >= STS_SNAPSHOT_HISTORY || (baseline = sts_snapshot__find(peer, sequence - (int)distance)) == NULL) {
+      return sts_snapshot__set_error("Unknown snapshot baseline");
+    }
+  }
+
+  // decode into the history, the baseline is never at the same place
+  current = &peer->history[sequence % STS_SNAPSHOT_HISTORY];
+  if (baseline) {
+    sts_snapshot_copy(current, baseline);
+  } else {
+    sts__memset(current->active, 0, (size_t)schema->object_count);
+    sts__memset(current->values, 0, sizeof(unsigned int) * (size_t)schema->object_count * (size_t)schema->field_count);
+  }
+  current->sequence = -1;
+  for (i = 0; i < schema->object_count; ++i) {
+    if (sts_snapshot__read(&r, 1, &value) < 0) return sts_snapshot__set_error("Received corrupted snapshot");
+    if (!value) continue;
+    if (sts_snapshot__read(&r, 1, &value) < 0) return sts_snapshot__set_error("Received corrupted snapshot");
+    current->active[i] = (unsigned char)value;
+    values = &current->values[i * schema->field_count];
+    if (!value) {
+      sts__memset(values, 0, sizeof(unsigned int) * (size_t)schema->field_count);
+      continue;
+    }
+    for (j = 0; j < schema->field_count; ++j) {
+      if (sts_snapshot__read(&r, 1, &value) < 0) return sts_snapshot__set_error("Received corrupted snapshot");
+      if (value && sts_snapshot__read(&r, schema->fields[j].bits, &values[j]) < 0) return sts_snapshot__set_error("Received corrupted snapshot");
+    }
+  }
+  current->sequence = peer->sequence = sequence;
+  sts_snapshot_copy(snapshot, current);
+  return 1;
+}
+
+
+#ifndef STS_NET_NO_PACKETS
+sts_net_buffer_t* sts_snapshot_create_packet(sts_snapshot_peer_t* peer, sts_snapshot_t* snapshot) {
+  int               capacity = sts_snapshot_max_size(peer->schema), length, header;
+  sts_net_buffer_t* buffer;
+
+  // the snapshot is encoded behind the space for the widest packet header
+  if ((buffer = sts_net_create_buffer(NULL, 6 + capacity)) == NULL) return NULL;
+  if ((length = sts_snapshot_encode(peer, snapshot, buffer->data + 6, capacity)) < 0) {
+    sts_net_release_buffer(buffer);
+    return NULL;
+  }
+  // write the packet header (see the packet API of sts_net.h) right in front of it
+  header = length < 0xffff ? 2 : 6;
+  buffer->data += 6 - header;
+  buffer->length = header + length;
+  if (header == 2) {
+    buffer->data[0] = (char)(length >> 8);
+    buffer->data[1] = (char)length;
+  } else {
+    buffer->data[0] = buffer->data[1] = (char)0xff;
+    buffer->data[2] = (char)(length >> 24);
+    buffer->data[3] = (char)(length >> 16);
+    buffer->data[4] = (char)(length >> 8);
+    buffer->data[5] = (char)length;
+  }
+  return buffer;
+}
+
+
+int sts_snapshot_decode_packet(sts_snapshot_peer_t* peer, const sts_net_packet_t* packet, sts_snapshot_t* snapshot) {
+  return sts_snapshot_decode(peer, packet->data[0], packet->length[0], packet->data[1], packet->length[1], snapshot);
+}
+#endif // STS_NET_NO_PACKETS
+#endif // STS_SNAPSHOT_IMPLEMENTATION
+/*
+  This is free and unencumbered software released into the public domain.
+
+  Anyone is free to copy, modify, publish, use, compile, sell, or
+  distribute this software, either in source code form or as a compiled
+  binary, for any purpose, commercial or non-commercial, and by any
+  means.
+
+  In jurisdictions that recognize copyright laws, the author or authors
+  of this software dedicate any and all copyright interest in the
+  software to the public domain. We make this dedication for the benefit
+  of the public at large and to the detriment of our heirs and
+  successors. We intend this dedication to be an overt act of
+  relinquishment in perpetuity of all present and future rights to this
+  software under copyright law.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+  OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+  OTHER DEALINGS IN THE SOFTWARE.
+
+  For more information, please refer to <http://unlicense.org/>
+*/